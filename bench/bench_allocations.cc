@@ -0,0 +1,63 @@
+// Created by DONG Zhong on 2024/04/20.
+
+#include "bench_allocations.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+std::atomic<std::uint64_t> allocation_count{0};
+
+void* Allocate(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+} // namespace
+
+std::uint64_t GetAllocationCount() {
+  return allocation_count.load(std::memory_order_relaxed);
+}
+
+} // namespace bench
+} // namespace rezero
+
+void* operator new(std::size_t size) {
+  if (void* p = rezero::bench::Allocate(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return rezero::bench::Allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return rezero::bench::Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
@@ -0,0 +1,18 @@
+// Created by DONG Zhong on 2024/04/20.
+
+#ifndef REZERO_BENCH_BENCH_ALLOCATIONS_H_
+#define REZERO_BENCH_BENCH_ALLOCATIONS_H_
+
+#include <cstdint>
+
+namespace rezero {
+namespace bench {
+
+// The number of calls to the global operator new so far, from any thread and
+// from the library as well, since the bench replaces the operator.
+std::uint64_t GetAllocationCount();
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_ALLOCATIONS_H_
@@ -0,0 +1,236 @@
+// Created by DONG Zhong on 2024/04/22.
+
+#include "bench_json.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+// Nesting deeper than this is rejected rather than risking the stack.
+constexpr int kMaxDepth = 64;
+
+class JsonParser {
+ public:
+  explicit JsonParser(const std::string& text) : text_(text) {}
+
+  bool Parse(JsonValue& value) {
+    if (!ParseValue(value, 0)) {
+      return false;
+    }
+    SkipWhitespace();
+    return position_ == text_.size();
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (position_ < text_.size() && std::strchr(" \t\r\n", text_[position_])) {
+      ++position_;
+    }
+  }
+
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (position_ < text_.size() && text_[position_] == c) {
+      ++position_;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeWord(const char* word) {
+    std::size_t length = std::strlen(word);
+    if (text_.compare(position_, length, word) != 0) {
+      return false;
+    }
+    position_ += length;
+    return true;
+  }
+
+  bool ParseValue(JsonValue& value, int depth) {
+    if (depth > kMaxDepth) {
+      return false;
+    }
+
+    SkipWhitespace();
+    if (position_ >= text_.size()) {
+      return false;
+    }
+
+    value = JsonValue();
+    char c = text_[position_];
+    if (c == '{') {
+      return ParseObject(value, depth);
+    }
+    if (c == '[') {
+      return ParseArray(value, depth);
+    }
+    if (c == '"') {
+      value.type = JsonValue::Type::kString;
+      return ParseString(value.string);
+    }
+    if (ConsumeWord("true")) {
+      value.type = JsonValue::Type::kBool;
+      value.boolean = true;
+      return true;
+    }
+    if (ConsumeWord("false")) {
+      value.type = JsonValue::Type::kBool;
+      return true;
+    }
+    if (ConsumeWord("null")) {
+      return true;
+    }
+    return ParseNumber(value);
+  }
+
+  bool ParseObject(JsonValue& value, int depth) {
+    value.type = JsonValue::Type::kObject;
+    ++position_;
+    if (Consume('}')) {
+      return true;
+    }
+
+    do {
+      SkipWhitespace();
+      std::pair<std::string, JsonValue> member;
+      if (!ParseString(member.first) || !Consume(':') || !ParseValue(member.second, depth + 1)) {
+        return false;
+      }
+      value.object.push_back(std::move(member));
+    } while (Consume(','));
+
+    return Consume('}');
+  }
+
+  bool ParseArray(JsonValue& value, int depth) {
+    value.type = JsonValue::Type::kArray;
+    ++position_;
+    if (Consume(']')) {
+      return true;
+    }
+
+    do {
+      JsonValue element;
+      if (!ParseValue(element, depth + 1)) {
+        return false;
+      }
+      value.array.push_back(std::move(element));
+    } while (Consume(','));
+
+    return Consume(']');
+  }
+
+  // Escaped code points are only kept when they are ASCII, which is all the
+  // bench writes.
+  bool ParseString(std::string& string) {
+    if (position_ >= text_.size() || text_[position_] != '"') {
+      return false;
+    }
+    ++position_;
+
+    while (position_ < text_.size()) {
+      char c = text_[position_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\') {
+        string.push_back(c);
+        continue;
+      }
+
+      if (position_ >= text_.size()) {
+        return false;
+      }
+      char escaped = text_[position_++];
+      switch (escaped) {
+        case 'b':
+          string.push_back('\b');
+          break;
+        case 'f':
+          string.push_back('\f');
+          break;
+        case 'n':
+          string.push_back('\n');
+          break;
+        case 'r':
+          string.push_back('\r');
+          break;
+        case 't':
+          string.push_back('\t');
+          break;
+        case 'u': {
+          if (position_ + 4 > text_.size()) {
+            return false;
+          }
+          long code = std::strtol(text_.substr(position_, 4).c_str(), nullptr, 16);
+          string.push_back(code < 0x80 ? static_cast<char>(code) : '?');
+          position_ += 4;
+          break;
+        }
+        default:
+          string.push_back(escaped);
+          break;
+      }
+    }
+
+    return false;
+  }
+
+  bool ParseNumber(JsonValue& value) {
+    const char* begin = text_.c_str() + position_;
+    char* end = nullptr;
+    value.number = std::strtod(begin, &end);
+    if (end == begin) {
+      return false;
+    }
+
+    value.type = JsonValue::Type::kNumber;
+    position_ += end - begin;
+    return true;
+  }
+
+  const std::string& text_;
+  std::size_t position_ = 0;
+};
+
+} // namespace
+
+const JsonValue* JsonValue::Find(const std::string& key) const {
+  for (const auto& member : object) {
+    if (member.first == key) {
+      return &member.second;
+    }
+  }
+  return nullptr;
+}
+
+bool ParseJson(const std::string& text, JsonValue& value) {
+  JsonParser parser(text);
+  return parser.Parse(value);
+}
+
+std::string QuoteJson(const std::string& text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted.push_back('\\');
+      quoted.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted.push_back(c);
+    }
+  }
+  quoted.push_back('"');
+  return quoted;
+}
+
+} // namespace bench
+} // namespace rezero
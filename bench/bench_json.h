@@ -0,0 +1,43 @@
+// Created by DONG Zhong on 2024/04/22.
+
+#ifndef REZERO_BENCH_BENCH_JSON_H_
+#define REZERO_BENCH_BENCH_JSON_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rezero {
+namespace bench {
+
+// Just enough JSON to read back the result files the bench writes.
+struct JsonValue {
+  enum class Type {
+    kNull,
+    kBool,
+    kNumber,
+    kString,
+    kArray,
+    kObject,
+  };
+
+  // The member `key` of an object, or null.
+  const JsonValue* Find(const std::string& key) const;
+
+  Type type = Type::kNull;
+  bool boolean = false;
+  double number = 0.0;
+  std::string string;
+  std::vector<JsonValue> array;
+  std::vector<std::pair<std::string, JsonValue>> object;
+};
+
+bool ParseJson(const std::string& text, JsonValue& value);
+
+// `text` quoted, with the characters JSON needs escaped.
+std::string QuoteJson(const std::string& text);
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_JSON_H_
@@ -0,0 +1,369 @@
+// Created by DONG Zhong on 2024/04/18.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <rezero2d.h>
+
+#include "bench_allocations.h"
+#include "bench_micro.h"
+#include "bench_report.h"
+#include "bench_scenes.h"
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+struct Size {
+  std::uint32_t width;
+  std::uint32_t height;
+};
+
+struct Options {
+  bool run_scenes = true;
+  bool run_micro = true;
+  std::vector<std::string> scenes = GetSceneNames();
+  std::vector<std::string> micro_benchmarks = GetMicroBenchmarkNames();
+  std::vector<Size> sizes = {{640, 480}, {1920, 1080}, {3840, 2160}};
+  std::vector<std::uint32_t> thread_counts;
+  // Each configuration is measured this many times, for at least `min_time`
+  // each, and reported by the median.
+  std::uint32_t repetitions = 5;
+  double min_time = 0.2;
+  // Allocates through a PoolAllocator instead of the system allocator.
+  bool pool = false;
+  // Maps large buffers with a HugePageAllocator, below the pool if any.
+  bool huge_pages = false;
+  std::string json_path;
+
+  // Set to compare two reports instead of running anything.
+  std::string compare_base_path;
+  std::string compare_new_path;
+  CompareOptions compare_options;
+};
+
+struct Result {
+  std::uint32_t frame_count = 0;
+  std::uint64_t allocation_count = 0;
+  double seconds = 0.0;
+};
+
+std::vector<std::string> Split(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+void PrintUsage() {
+  std::printf(
+      "Usage: rezero2d_bench [options]\n"
+      "  --suites=NAME,...    scenes, micro or both, the default\n"
+      "  --scenes=NAME,...    scenes to run, all by default:");
+  for (const auto& name : GetSceneNames()) {
+    std::printf(" %s", name.c_str());
+  }
+  std::printf(
+      "\n"
+      "  --micro=NAME,...     microbenchmarks to run, all by default:");
+  for (const auto& name : GetMicroBenchmarkNames()) {
+    std::printf(" %s", name.c_str());
+  }
+  std::printf(
+      "\n"
+      "  --sizes=WxH,...      bitmap sizes, 640x480,1920x1080,3840x2160 by default\n"
+      "  --threads=N,...      thread counts, 1 and powers of two up to the\n"
+      "                       hardware concurrency by default. 1 renders in\n"
+      "                       kSync mode, more in kBinned mode\n"
+      "  --repetitions=N      measurements of each configuration, 5 by default\n"
+      "  --min-time=SECONDS   length of each measurement, 0.2 by default\n"
+      "  --pool               allocates buffers from a PoolAllocator\n"
+      "  --huge-pages         maps large buffers with a HugePageAllocator\n"
+      "  --json=FILE          also writes the results to FILE\n"
+      "\n"
+      "Usage: rezero2d_bench --compare BASE NEW [options]\n"
+      "  Compares the medians of two --json reports and exits with 1 if any\n"
+      "  benchmark got slower by more than both thresholds or is missing from NEW.\n"
+      "  --threshold=FRACTION smallest change reported, 0.05 by default\n"
+      "  --noise=FACTOR       changes must exceed FACTOR times the scaled MAD of\n"
+      "                       the noisier report, 3 by default\n"
+      "  --allow-missing      passes even if NEW lacks benchmarks of BASE\n");
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    auto value_of = [&](const char* name) -> const char* {
+      std::size_t length = std::strlen(name);
+      if (argument.compare(0, length, name) == 0 && argument.size() > length &&
+          argument[length] == '=') {
+        return argv[i] + length + 1;
+      }
+      return nullptr;
+    };
+
+    if (argument == "--compare") {
+      if (i + 2 >= argc) {
+        PrintUsage();
+        return false;
+      }
+      options.compare_base_path = argv[++i];
+      options.compare_new_path = argv[++i];
+    } else if (const char* value = value_of("--suites")) {
+      options.run_scenes = false;
+      options.run_micro = false;
+      for (const auto& item : Split(value)) {
+        if (item == "scenes") {
+          options.run_scenes = true;
+        } else if (item == "micro") {
+          options.run_micro = true;
+        } else {
+          std::fprintf(stderr, "Unknown suite: %s\n", item.c_str());
+          return false;
+        }
+      }
+    } else if (const char* value = value_of("--scenes")) {
+      options.scenes = Split(value);
+    } else if (const char* value = value_of("--micro")) {
+      options.micro_benchmarks = Split(value);
+    } else if (const char* value = value_of("--sizes")) {
+      options.sizes.clear();
+      for (const auto& item : Split(value)) {
+        Size size;
+        if (std::sscanf(item.c_str(), "%ux%u", &size.width, &size.height) != 2 || !size.width ||
+            !size.height) {
+          std::fprintf(stderr, "Invalid size: %s\n", item.c_str());
+          return false;
+        }
+        options.sizes.push_back(size);
+      }
+    } else if (const char* value = value_of("--threads")) {
+      options.thread_counts.clear();
+      for (const auto& item : Split(value)) {
+        long thread_count = std::strtol(item.c_str(), nullptr, 10);
+        if (thread_count < 1) {
+          std::fprintf(stderr, "Invalid thread count: %s\n", item.c_str());
+          return false;
+        }
+        options.thread_counts.push_back(static_cast<std::uint32_t>(thread_count));
+      }
+    } else if (const char* value = value_of("--repetitions")) {
+      long repetitions = std::strtol(value, nullptr, 10);
+      if (repetitions < 1) {
+        std::fprintf(stderr, "Invalid repetition count: %s\n", value);
+        return false;
+      }
+      options.repetitions = static_cast<std::uint32_t>(repetitions);
+    } else if (const char* value = value_of("--min-time")) {
+      options.min_time = std::atof(value);
+    } else if (argument == "--pool") {
+      options.pool = true;
+    } else if (argument == "--huge-pages") {
+      options.huge_pages = true;
+    } else if (const char* value = value_of("--json")) {
+      options.json_path = value;
+    } else if (const char* value = value_of("--threshold")) {
+      options.compare_options.threshold = std::atof(value);
+    } else if (const char* value = value_of("--noise")) {
+      options.compare_options.noise_factor = std::atof(value);
+    } else if (argument == "--allow-missing") {
+      options.compare_options.allow_missing = true;
+    } else {
+      PrintUsage();
+      return false;
+    }
+  }
+
+  if (options.thread_counts.empty()) {
+    std::uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (std::uint32_t count = 1; count < hardware; count *= 2) {
+      options.thread_counts.push_back(count);
+    }
+    options.thread_counts.push_back(hardware);
+  }
+
+  return true;
+}
+
+bool RenderFrame(Canvas& canvas, const std::shared_ptr<Bitmap>& bitmap, const Scene& scene,
+                 std::uint32_t thread_count) {
+  canvas.SetThreadCount(thread_count);
+  if (!canvas.Begin(bitmap, thread_count > 1 ? RenderMode::kBinned : RenderMode::kSync)) {
+    return false;
+  }
+
+  DrawScene(canvas, scene);
+  canvas.End()->Wait();
+  return true;
+}
+
+// Renders frames until `min_time` has passed, after one frame to warm up.
+bool Run(const Scene& scene, const Size& size, std::uint32_t thread_count, double min_time,
+         Result& result) {
+  auto bitmap = std::make_shared<Bitmap>();
+  bitmap->Init(size.width, size.height, Format::kARGB8888);
+
+  Canvas canvas;
+  if (!RenderFrame(canvas, bitmap, scene, thread_count)) {
+    return false;
+  }
+
+  using Clock = std::chrono::steady_clock;
+  result = Result();
+  std::uint64_t allocations_before = GetAllocationCount();
+  auto start = Clock::now();
+  do {
+    if (!RenderFrame(canvas, bitmap, scene, thread_count)) {
+      return false;
+    }
+    ++result.frame_count;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  } while (result.seconds < min_time);
+
+  result.allocation_count = GetAllocationCount() - allocations_before;
+  return true;
+}
+
+bool RunScenes(const Options& options, std::vector<Record>& records) {
+  std::printf("%-10s %-10s %7s %10s %6s %12s %12s %9s %12s\n", "scene", "size", "threads",
+              "ms/frame", "mad", "paths/s", "Mpixels/s", "ns/edge", "allocs/frame");
+
+  for (const auto& name : options.scenes) {
+    for (const auto& size : options.sizes) {
+      Scene scene;
+      if (!BuildScene(name, size.width, size.height, scene)) {
+        std::fprintf(stderr, "Unknown scene: %s\n", name.c_str());
+        return false;
+      }
+      std::size_t edge_count = CountEdges(scene, size.width, size.height);
+      std::string size_name = std::to_string(size.width) + "x" + std::to_string(size.height);
+
+      for (std::uint32_t thread_count : options.thread_counts) {
+        Record record;
+        record.name = "scenes/" + name + "/" + size_name + "/" + std::to_string(thread_count);
+        record.unit = "frame";
+
+        std::uint64_t frame_count = 0;
+        std::uint64_t allocation_count = 0;
+        for (std::uint32_t i = 0; i < options.repetitions; ++i) {
+          Result result;
+          if (!Run(scene, size, thread_count, options.min_time, result)) {
+            std::fprintf(stderr, "Failed to render %s.\n", name.c_str());
+            return false;
+          }
+          record.samples.push_back(result.seconds * 1e9 / result.frame_count);
+          frame_count += result.frame_count;
+          allocation_count += result.allocation_count;
+        }
+        record.allocations_per_operation = double(allocation_count) / frame_count;
+
+        double frame_ns = Median(record.samples);
+        double pixels = double(size.width) * size.height;
+        std::printf("%-10s %-10s %7u %10.3f %5.1f%% %12.0f %12.1f %9.2f %12.1f\n", name.c_str(),
+                    size_name.c_str(), thread_count, frame_ns / 1e6,
+                    MedianAbsoluteDeviation(record.samples) * 100.0 / frame_ns,
+                    scene.path_count * 1e9 / frame_ns, pixels * 1e3 / frame_ns,
+                    edge_count ? frame_ns / edge_count : 0.0, record.allocations_per_operation);
+        std::fflush(stdout);
+        records.push_back(std::move(record));
+      }
+    }
+  }
+
+  return true;
+}
+
+bool RunMicroBenchmarks(const Options& options, std::vector<Record>& records) {
+  std::printf("%-24s %-8s %10s %6s %10s\n", "benchmark", "unit", "ns/op", "mad", "allocs/op");
+
+  for (const auto& name : options.micro_benchmarks) {
+    Record record;
+    record.name = "micro/" + name;
+
+    std::uint64_t operation_count = 0;
+    std::uint64_t allocation_count = 0;
+    for (std::uint32_t i = 0; i < options.repetitions; ++i) {
+      MicroResult result;
+      if (!RunMicroBenchmark(name, options.min_time, result)) {
+        std::fprintf(stderr, "Unknown microbenchmark: %s\n", name.c_str());
+        return false;
+      }
+      record.unit = result.unit;
+      record.samples.push_back(result.seconds * 1e9 / result.operation_count);
+      operation_count += result.operation_count;
+      allocation_count += result.allocation_count;
+    }
+    record.allocations_per_operation = double(allocation_count) / operation_count;
+
+    double operation_ns = Median(record.samples);
+    std::printf("%-24s %-8s %10.2f %5.1f%% %10.3f\n", name.c_str(), record.unit.c_str(),
+                operation_ns, MedianAbsoluteDeviation(record.samples) * 100.0 / operation_ns,
+                record.allocations_per_operation);
+    std::fflush(stdout);
+    records.push_back(std::move(record));
+  }
+
+  return true;
+}
+
+} // namespace
+
+int Main(int argc, char* argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 2;
+  }
+
+  if (!options.compare_base_path.empty()) {
+    return CompareReports(options.compare_base_path, options.compare_new_path,
+                          options.compare_options);
+  }
+
+  std::shared_ptr<Allocator> allocator;
+  if (options.huge_pages) {
+    allocator = std::make_shared<HugePageAllocator>();
+  }
+  if (options.pool) {
+    allocator = std::make_shared<PoolAllocator>(PoolAllocator::kDefaultMaxCachedBytes, allocator);
+  }
+  SetAllocator(allocator);
+
+  std::vector<Record> records;
+  if (options.run_scenes && !RunScenes(options, records)) {
+    return 2;
+  }
+
+  if (options.run_scenes && options.run_micro) {
+    std::printf("\n");
+  }
+
+  if (options.run_micro && !RunMicroBenchmarks(options, records)) {
+    return 2;
+  }
+
+  if (!options.json_path.empty() && !WriteReport(options.json_path, records)) {
+    return 2;
+  }
+
+  return 0;
+}
+
+} // namespace bench
+} // namespace rezero
+
+int main(int argc, char* argv[]) {
+  return rezero::bench::Main(argc, argv);
+}
@@ -0,0 +1,307 @@
+// Created by DONG Zhong on 2024/04/20.
+
+#include "bench_micro.h"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+#include <rezero2d.h>
+
+#include "bench_allocations.h"
+#include "bench_random.h"
+#include "rezero2d/raster/edge_builder.h"
+#include "rezero2d/raster/edge_storage.h"
+#include "rezero2d/raster/flatten_utils.h"
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+// The clip box of the edge builder benchmarks, in pixels, split into bands
+// as the canvas does.
+constexpr double kWidth = 1920.0;
+constexpr double kHeight = 1080.0;
+constexpr std::uint32_t kBandHeight = 32;
+
+// Keeps results alive so that the compiler cannot drop the work.
+volatile std::uint64_t sink;
+
+struct Benchmark {
+  const char* unit;
+  std::uint64_t operations_per_call;
+  std::function<void()> call;
+};
+
+// An edge builder over the clip box, reset before every path like the
+// canvas does.
+class EdgeBuilderFixture {
+ public:
+  explicit EdgeBuilderFixture(double tolerance = 0.2)
+      : storage_(static_cast<std::uint32_t>(std::ceil(kHeight / kBandHeight)),
+                 kBandHeight << kEdgeFixedShift),
+        builder_(&storage_, Rect(0.0, 0.0, kWidth * kEdgeFixedScale, kHeight * kEdgeFixedScale),
+                 tolerance * kEdgeFixedScale),
+        transform_(kEdgeFixedScale) {}
+
+  void Build(const std::shared_ptr<Path>& path) {
+    storage_.Reset();
+    builder_.Begin();
+    builder_.AddPath(path, transform_);
+    builder_.End();
+  }
+
+  EdgeStorage& GetStorage() { return storage_; }
+
+ private:
+  EdgeStorage storage_;
+  EdgeBuilder builder_;
+  EdgeTransform transform_;
+};
+
+Benchmark MakeBuildBenchmark(const char* unit, std::uint64_t count,
+                             const std::shared_ptr<Path>& path) {
+  auto fixture = std::make_shared<EdgeBuilderFixture>();
+  return {unit, count, [fixture, path]() { fixture->Build(path); }};
+}
+
+// A polyline of 1000 segments between random points of `[x0, x1) x [y0, y1)`.
+Benchmark MakeLineBenchmark(double x0, double y0, double x1, double y1, std::uint32_t seed) {
+  constexpr std::uint32_t kSegmentCount = 1000;
+
+  Random random(seed);
+  auto path = std::make_shared<Path>();
+  path->MoveTo(random.Uniform(x0, x1), random.Uniform(y0, y1));
+  for (std::uint32_t i = 0; i < kSegmentCount; ++i) {
+    path->LineTo(random.Uniform(x0, x1), random.Uniform(y0, y1));
+  }
+  path->Close();
+  return MakeBuildBenchmark("segment", kSegmentCount, path);
+}
+
+// 250 quads between random points of `[x0, x1) x [y0, y1)`.
+Benchmark MakeQuadBenchmark(double x0, double y0, double x1, double y1, std::uint32_t seed) {
+  constexpr std::uint32_t kCurveCount = 250;
+
+  Random random(seed);
+  auto path = std::make_shared<Path>();
+  path->MoveTo(random.Uniform(x0, x1), random.Uniform(y0, y1));
+  for (std::uint32_t i = 0; i < kCurveCount; ++i) {
+    path->QuadTo(random.Uniform(x0, x1), random.Uniform(y0, y1), random.Uniform(x0, x1),
+                 random.Uniform(y0, y1));
+  }
+  path->Close();
+  return MakeBuildBenchmark("curve", kCurveCount, path);
+}
+
+Benchmark MakeLineInside() {
+  return MakeLineBenchmark(0.0, 0.0, kWidth, kHeight, 1);
+}
+
+// Left of the clip box and past its top and bottom, so only the left border
+// is accumulated.
+Benchmark MakeLineOutside() {
+  return MakeLineBenchmark(-400.0, -200.0, -1.0, kHeight + 200.0, 2);
+}
+
+Benchmark MakeLineStraddling() {
+  return MakeLineBenchmark(-kWidth * 0.25, -kHeight * 0.25, kWidth * 1.25, kHeight * 1.25, 3);
+}
+
+Benchmark MakeQuadInside() {
+  return MakeQuadBenchmark(0.0, 0.0, kWidth, kHeight, 4);
+}
+
+Benchmark MakeQuadStraddling() {
+  return MakeQuadBenchmark(-kWidth * 0.25, -kHeight * 0.25, kWidth * 1.25, kHeight * 1.25, 5);
+}
+
+Benchmark MakeSplitQuadToSpline() {
+  constexpr std::uint32_t kCurveCount = 1024;
+
+  Random random(6);
+  auto curves = std::make_shared<std::vector<Point>>();
+  for (std::uint32_t i = 0; i < kCurveCount * 3; ++i) {
+    curves->emplace_back(random.Uniform(0.0, kWidth), random.Uniform(0.0, kHeight));
+  }
+
+  return {"curve", kCurveCount, [curves]() {
+            // At most 3 pieces sharing their end points.
+            Point spline[7];
+            std::uint64_t count = 0;
+            for (std::size_t i = 0; i < curves->size(); i += 3) {
+              count += QuadHelper::SplitQuadToSpline(curves->data() + i, spline) - spline;
+            }
+            sink = count;
+          }};
+}
+
+// Flattens a monotonic 64 pixel quad the way EdgeBuilder::QuadTo does,
+// including a new FlattenMonoQuad per curve.
+Benchmark MakeFlattenMonoQuad(double tolerance) {
+  constexpr std::uint32_t kCurveCount = 64;
+
+  auto curves = std::make_shared<std::vector<Point>>();
+  for (std::uint32_t i = 0; i < kCurveCount; ++i) {
+    double x = i * 8.0;
+    const Point points[3] = {Point(x, 0.0), Point(x + 48.0, 8.0), Point(x + 24.0, 64.0)};
+    for (const auto& point : points) {
+      curves->push_back(point * kEdgeFixedScale);
+    }
+  }
+
+  double tolerance_sq = (tolerance * kEdgeFixedScale) * (tolerance * kEdgeFixedScale);
+  return {"curve", kCurveCount, [curves, tolerance_sq]() {
+            std::uint64_t count = 0;
+            for (std::size_t i = 0; i < curves->size(); i += 3) {
+              FlattenMonoQuad mono_curve(tolerance_sq);
+              mono_curve.Begin(curves->data() + i, EdgeDirection::kDescending);
+              while (true) {
+                FlattenMonoQuad::Step step;
+                if (!mono_curve.IsFlat(step)) {
+                  mono_curve.Split(step);
+                  mono_curve.Push(step);
+                  continue;
+                }
+
+                ++count;
+                if (!mono_curve.CanPop()) {
+                  break;
+                }
+                mono_curve.Pop();
+              }
+            }
+            sink = count;
+          }};
+}
+
+Benchmark MakeFlattenFine() {
+  return MakeFlattenMonoQuad(0.05);
+}
+
+Benchmark MakeFlattenDefault() {
+  return MakeFlattenMonoQuad(0.2);
+}
+
+Benchmark MakeFlattenCoarse() {
+  return MakeFlattenMonoQuad(1.0);
+}
+
+// Appends 4 point edges to a list cleared every 256 of them, which keeps its
+// capacity.
+Benchmark MakeEdgeListAppend() {
+  constexpr std::uint32_t kEdgeCount = 256;
+
+  auto list = std::make_shared<EdgeList>();
+  auto edge = std::make_shared<EdgeVector>();
+  edge->direction = EdgeDirection::kDescending;
+  for (std::int32_t i = 0; i < 4; ++i) {
+    edge->Append(i * 256, i * 512);
+  }
+
+  return {"edge", kEdgeCount, [list, edge]() {
+            list->edges.clear();
+            for (std::uint32_t i = 0; i < kEdgeCount; ++i) {
+              list->Append(*edge);
+            }
+          }};
+}
+
+// Small triangles over the whole height, so that every band gets edges,
+// followed by the band range lookup the binned mode does.
+Benchmark MakeEdgeStorageBands() {
+  Random random(7);
+  auto path = std::make_shared<Path>();
+  for (int i = 0; i < 500; ++i) {
+    double x = random.Uniform(0.0, kWidth - 24.0);
+    double y = random.Uniform(0.0, kHeight - 24.0);
+    double size = random.Uniform(8.0, 24.0);
+    path->MoveTo(x, y);
+    path->LineTo(x + size, y + size * 0.5);
+    path->LineTo(x, y + size);
+    path->Close();
+  }
+
+  auto fixture = std::make_shared<EdgeBuilderFixture>();
+  fixture->Build(path);
+  std::uint64_t edge_count = 0;
+  EdgeStorage& storage = fixture->GetStorage();
+  for (std::uint32_t i = 0; i < storage.band_count; ++i) {
+    edge_count += storage.bands[i].edges.size();
+  }
+
+  return {"edge", edge_count, [fixture, path]() {
+            fixture->Build(path);
+            std::uint32_t band_begin;
+            std::uint32_t band_end;
+            fixture->GetStorage().CalculateBandRange(band_begin, band_end);
+            sink = band_end - band_begin;
+          }};
+}
+
+struct MicroBenchmarkEntry {
+  const char* name;
+  Benchmark (*make)();
+};
+
+constexpr MicroBenchmarkEntry kMicroBenchmarks[] = {
+    {"line_inside", MakeLineInside},
+    {"line_outside", MakeLineOutside},
+    {"line_straddling", MakeLineStraddling},
+    {"quad_inside", MakeQuadInside},
+    {"quad_straddling", MakeQuadStraddling},
+    {"split_quad_to_spline", MakeSplitQuadToSpline},
+    {"flatten_mono_quad_0.05", MakeFlattenFine},
+    {"flatten_mono_quad_0.2", MakeFlattenDefault},
+    {"flatten_mono_quad_1", MakeFlattenCoarse},
+    {"edge_list_append", MakeEdgeListAppend},
+    {"edge_storage_bands", MakeEdgeStorageBands},
+};
+
+} // namespace
+
+std::vector<std::string> GetMicroBenchmarkNames() {
+  std::vector<std::string> names;
+  for (const auto& entry : kMicroBenchmarks) {
+    names.emplace_back(entry.name);
+  }
+  return names;
+}
+
+bool RunMicroBenchmark(const std::string& name, double min_time, MicroResult& result) {
+  for (const auto& entry : kMicroBenchmarks) {
+    if (name != entry.name) {
+      continue;
+    }
+
+    Benchmark benchmark = entry.make();
+    // Warms up, and lets containers reach the capacity they keep.
+    benchmark.call();
+
+    using Clock = std::chrono::steady_clock;
+    result = MicroResult();
+    result.unit = benchmark.unit;
+    std::uint64_t call_count = 0;
+    std::uint64_t allocations_before = GetAllocationCount();
+    auto start = Clock::now();
+    do {
+      // Amortizes reading the clock over several calls.
+      for (int i = 0; i < 16; ++i) {
+        benchmark.call();
+      }
+      call_count += 16;
+      result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (result.seconds < min_time);
+
+    result.allocation_count = GetAllocationCount() - allocations_before;
+    result.operation_count = call_count * benchmark.operations_per_call;
+    return true;
+  }
+
+  return false;
+}
+
+} // namespace bench
+} // namespace rezero
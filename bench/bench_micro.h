@@ -0,0 +1,30 @@
+// Created by DONG Zhong on 2024/04/20.
+
+#ifndef REZERO_BENCH_BENCH_MICRO_H_
+#define REZERO_BENCH_BENCH_MICRO_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rezero {
+namespace bench {
+
+struct MicroResult {
+  // What one operation is, such as "segment" or "curve".
+  std::string unit;
+  std::uint64_t operation_count = 0;
+  std::uint64_t allocation_count = 0;
+  double seconds = 0.0;
+};
+
+// The names of the microbenchmarks, in the order they are run.
+std::vector<std::string> GetMicroBenchmarkNames();
+
+// Runs the microbenchmark `name` for at least `min_time` seconds.
+bool RunMicroBenchmark(const std::string& name, double min_time, MicroResult& result);
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_MICRO_H_
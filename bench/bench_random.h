@@ -0,0 +1,34 @@
+// Created by DONG Zhong on 2024/04/20.
+
+#ifndef REZERO_BENCH_BENCH_RANDOM_H_
+#define REZERO_BENCH_BENCH_RANDOM_H_
+
+#include <cstdint>
+#include <random>
+
+namespace rezero {
+namespace bench {
+
+// std::uniform_real_distribution differs between standard libraries, the
+// engine does not, so this maps its output by hand.
+class Random {
+ public:
+  explicit Random(std::uint32_t seed) : engine_(seed) {}
+
+  double Uniform(double min, double max) { return min + (max - min) * (engine_() / 4294967296.0); }
+
+  std::uint32_t Integer(std::uint32_t min, std::uint32_t max) {
+    return min + engine_() % (max - min + 1);
+  }
+
+  // A non-premultiplied color at least a quarter opaque.
+  std::uint32_t Color() { return 0x40000000 | (engine_() & 0xBFFFFFFF); }
+
+ private:
+  std::mt19937 engine_;
+};
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_RANDOM_H_
@@ -0,0 +1,211 @@
+// Created by DONG Zhong on 2024/04/22.
+
+#include "bench_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "bench_json.h"
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+constexpr const char* kFormat = "rezero2d-bench";
+constexpr int kVersion = 1;
+
+// Scales a MAD to the standard deviation of normally distributed samples.
+constexpr double kMadScale = 1.4826;
+
+const Record* FindRecord(const std::vector<Record>& records, const std::string& name) {
+  for (const auto& record : records) {
+    if (record.name == name) {
+      return &record;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+double Median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+
+  std::size_t middle = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + middle, values.end());
+  double median = values[middle];
+  if (values.size() % 2 == 0) {
+    median = (median + *std::max_element(values.begin(), values.begin() + middle)) / 2.0;
+  }
+  return median;
+}
+
+double MedianAbsoluteDeviation(const std::vector<double>& values) {
+  double median = Median(values);
+  std::vector<double> deviations;
+  for (double value : values) {
+    deviations.push_back(std::abs(value - median));
+  }
+  return Median(deviations);
+}
+
+bool WriteReport(const std::string& path, const std::vector<Record>& records) {
+  std::ofstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "Failed to open %s for writing.\n", path.c_str());
+    return false;
+  }
+
+  char number[32];
+  auto format = [&number](double value) {
+    std::snprintf(number, sizeof(number), "%.17g", value);
+    return number;
+  };
+
+  file << "{\n  \"format\": " << QuoteJson(kFormat) << ",\n  \"version\": " << kVersion
+       << ",\n  \"benchmarks\": [";
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    const Record& record = records[i];
+    file << (i ? ",\n" : "\n") << "    {\"name\": " << QuoteJson(record.name)
+         << ", \"unit\": " << QuoteJson(record.unit) << ", \"samples_ns\": [";
+    for (std::size_t j = 0; j < record.samples.size(); ++j) {
+      file << (j ? ", " : "") << format(record.samples[j]);
+    }
+    file << "], \"median_ns\": " << format(Median(record.samples));
+    file << ", \"mad_ns\": " << format(MedianAbsoluteDeviation(record.samples));
+    file << ", \"allocations\": " << format(record.allocations_per_operation) << "}";
+  }
+  file << "\n  ]\n}\n";
+
+  if (!file) {
+    std::fprintf(stderr, "Failed to write %s.\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ReadReport(const std::string& path, std::vector<Record>& records) {
+  std::ifstream file(path);
+  if (!file) {
+    std::fprintf(stderr, "Failed to open %s.\n", path.c_str());
+    return false;
+  }
+
+  std::stringstream text;
+  text << file.rdbuf();
+
+  JsonValue root;
+  if (!ParseJson(text.str(), root) || root.type != JsonValue::Type::kObject) {
+    std::fprintf(stderr, "%s is not valid JSON.\n", path.c_str());
+    return false;
+  }
+
+  const JsonValue* format = root.Find("format");
+  const JsonValue* version = root.Find("version");
+  const JsonValue* benchmarks = root.Find("benchmarks");
+  if (!format || format->string != kFormat || !version || version->number != kVersion ||
+      !benchmarks || benchmarks->type != JsonValue::Type::kArray) {
+    std::fprintf(stderr, "%s is not a version %d bench report.\n", path.c_str(), kVersion);
+    return false;
+  }
+
+  records.clear();
+  for (const auto& benchmark : benchmarks->array) {
+    const JsonValue* name = benchmark.Find("name");
+    const JsonValue* samples = benchmark.Find("samples_ns");
+    if (!name || name->type != JsonValue::Type::kString || !samples ||
+        samples->type != JsonValue::Type::kArray || samples->array.empty()) {
+      std::fprintf(stderr, "%s has a malformed benchmark.\n", path.c_str());
+      return false;
+    }
+
+    Record record;
+    record.name = name->string;
+    if (const JsonValue* unit = benchmark.Find("unit")) {
+      record.unit = unit->string;
+    }
+    for (const auto& sample : samples->array) {
+      record.samples.push_back(sample.number);
+    }
+    if (const JsonValue* allocations = benchmark.Find("allocations")) {
+      record.allocations_per_operation = allocations->number;
+    }
+    records.push_back(std::move(record));
+  }
+
+  return true;
+}
+
+int CompareReports(const std::string& base_path, const std::string& new_path,
+                   const CompareOptions& options) {
+  std::vector<Record> base_records;
+  std::vector<Record> new_records;
+  if (!ReadReport(base_path, base_records) || !ReadReport(new_path, new_records)) {
+    return 2;
+  }
+
+  std::printf("%-40s %14s %14s %9s %12s %12s  %s\n", "benchmark", "base ns/op", "new ns/op",
+              "change", "base allocs", "new allocs", "status");
+
+  int regression_count = 0;
+  int missing_count = 0;
+  for (const auto& base : base_records) {
+    const Record* current = FindRecord(new_records, base.name);
+    if (!current) {
+      std::printf("%-40s %14s %14s %9s %12s %12s  %s\n", base.name.c_str(), "", "", "", "", "",
+                  options.allow_missing ? "missing" : "MISSING");
+      ++missing_count;
+      continue;
+    }
+
+    double base_median = Median(base.samples);
+    double new_median = Median(current->samples);
+    double noise = kMadScale * std::max(MedianAbsoluteDeviation(base.samples),
+                                        MedianAbsoluteDeviation(current->samples));
+    double difference = new_median - base_median;
+    double change = base_median > 0.0 ? difference / base_median : 0.0;
+
+    // A change counts only if it is both large and well outside the noise.
+    const char* status = "same";
+    bool significant = std::abs(difference) > options.noise_factor * noise;
+    if (significant && change > options.threshold) {
+      status = "REGRESSED";
+      ++regression_count;
+    } else if (significant && change < -options.threshold) {
+      status = "improved";
+    }
+
+    std::printf("%-40s %14.2f %14.2f %+8.1f%% %12.6g %12.6g  %s\n", base.name.c_str(),
+                base_median, new_median, change * 100.0, base.allocations_per_operation,
+                current->allocations_per_operation, status);
+  }
+
+  for (const auto& current : new_records) {
+    if (!FindRecord(base_records, current.name)) {
+      std::printf("%-40s %14s %14.2f %9s %12s %12.6g  %s\n", current.name.c_str(), "",
+                  Median(current.samples), "", "", current.allocations_per_operation, "new");
+    }
+  }
+
+  bool failed = false;
+  if (regression_count) {
+    std::printf("\n%d benchmark(s) regressed by more than %.1f%%.\n", regression_count,
+                options.threshold * 100.0);
+    failed = true;
+  }
+  if (missing_count && !options.allow_missing) {
+    std::printf("\n%d benchmark(s) of the base report are missing from the new one.\n",
+                missing_count);
+    failed = true;
+  }
+  return failed ? 1 : 0;
+}
+
+} // namespace bench
+} // namespace rezero
@@ -0,0 +1,51 @@
+// Created by DONG Zhong on 2024/04/22.
+
+#ifndef REZERO_BENCH_BENCH_REPORT_H_
+#define REZERO_BENCH_BENCH_REPORT_H_
+
+#include <string>
+#include <vector>
+
+namespace rezero {
+namespace bench {
+
+// The measurements of one benchmark configuration, such as a scene at a
+// size and thread count.
+struct Record {
+  std::string name;
+  // What one operation is, such as "frame" or "segment".
+  std::string unit;
+  // Nanoseconds per operation, one per repetition.
+  std::vector<double> samples;
+  double allocations_per_operation = 0.0;
+};
+
+double Median(std::vector<double> values);
+
+// The median absolute deviation from the median, a spread measure that a
+// few outliers do not move.
+double MedianAbsoluteDeviation(const std::vector<double>& values);
+
+bool WriteReport(const std::string& path, const std::vector<Record>& records);
+bool ReadReport(const std::string& path, std::vector<Record>& records);
+
+struct CompareOptions {
+  // Changes of the median below this fraction are never reported.
+  double threshold = 0.05;
+  // Changes must also exceed this many scaled MADs of the noisier run.
+  double noise_factor = 3.0;
+  // Whether benchmarks of the base report may be missing from the new one,
+  // such as when comparing a subset.
+  bool allow_missing = false;
+};
+
+// Prints how every benchmark of `base_path` changed in `new_path`. Returns 0
+// when none got slower or went missing, 1 when some did and 2 when a file
+// cannot be read.
+int CompareReports(const std::string& base_path, const std::string& new_path,
+                   const CompareOptions& options);
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_REPORT_H_
@@ -0,0 +1,284 @@
+// Created by DONG Zhong on 2024/04/18.
+
+#include "bench_scenes.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "bench_random.h"
+#include "rezero2d/raster/edge_builder.h"
+#include "rezero2d/raster/edge_storage.h"
+
+namespace rezero {
+namespace bench {
+
+namespace {
+
+// Same as the canvas, so that CountEdges sees the edges it renders.
+constexpr std::uint32_t kBandHeight = 32;
+constexpr double kFlattenTolerance = 0.2;
+
+constexpr double kPi = 3.14159265358979323846;
+
+void AddPath(Scene& scene, std::uint32_t color, const std::shared_ptr<Path>& path) {
+  scene.calls.push_back({color, path, {}});
+  ++scene.path_count;
+}
+
+std::shared_ptr<Path> MakeCircle(double cx, double cy, double r) {
+  // Four cubics, the usual approximation.
+  double k = 0.5522847498 * r;
+  auto path = std::make_shared<Path>();
+  path->MoveTo(cx + r, cy);
+  path->CubicTo(cx + r, cy + k, cx + k, cy + r, cx, cy + r);
+  path->CubicTo(cx - k, cy + r, cx - r, cy + k, cx - r, cy);
+  path->CubicTo(cx - r, cy - k, cx - k, cy - r, cx, cy - r);
+  path->CubicTo(cx + k, cy - r, cx + r, cy - k, cx + r, cy);
+  path->Close();
+  return path;
+}
+
+std::shared_ptr<Path> MakeRoundedRect(double x0, double y0, double x1, double y1, double r) {
+  double k = (1.0 - 0.5522847498) * r;
+  auto path = std::make_shared<Path>();
+  path->MoveTo(x0 + r, y0);
+  path->LineTo(x1 - r, y0);
+  path->CubicTo(x1 - k, y0, x1, y0 + k, x1, y0 + r);
+  path->LineTo(x1, y1 - r);
+  path->CubicTo(x1, y1 - k, x1 - k, y1, x1 - r, y1);
+  path->LineTo(x0 + r, y1);
+  path->CubicTo(x0 + k, y1, x0, y1 - k, x0, y1 - r);
+  path->LineTo(x0, y0 + r);
+  path->CubicTo(x0, y0 + k, x0 + k, y0, x0 + r, y0);
+  path->Close();
+  return path;
+}
+
+std::shared_ptr<Path> MakeHeart(double cx, double cy, double size) {
+  double s = size / 2.0;
+  auto path = std::make_shared<Path>();
+  path->MoveTo(cx, cy + s);
+  path->CubicTo(cx - s * 1.4, cy, cx - s * 0.9, cy - s * 1.1, cx, cy - s * 0.4);
+  path->CubicTo(cx + s * 0.9, cy - s * 1.1, cx + s * 1.4, cy, cx, cy + s);
+  path->Close();
+  return path;
+}
+
+// Random polygons of 3 to 12 points, up to a quarter of the bitmap wide.
+void BuildPolygons(Scene& scene, double width, double height, Random& random) {
+  for (int i = 0; i < 500; ++i) {
+    double cx = random.Uniform(0.0, width);
+    double cy = random.Uniform(0.0, height);
+    double rx = random.Uniform(0.01, 0.125) * width;
+    double ry = random.Uniform(0.01, 0.125) * height;
+
+    auto path = std::make_shared<Path>();
+    std::uint32_t count = random.Integer(3, 12);
+    for (std::uint32_t j = 0; j < count; ++j) {
+      double x = cx + random.Uniform(-rx, rx);
+      double y = cy + random.Uniform(-ry, ry);
+      if (j == 0) {
+        path->MoveTo(x, y);
+      } else {
+        path->LineTo(x, y);
+      }
+    }
+    path->Close();
+    AddPath(scene, random.Color(), path);
+  }
+}
+
+// Blobs made of quadratic curves through points around a center.
+void BuildQuads(Scene& scene, double width, double height, Random& random) {
+  for (int i = 0; i < 200; ++i) {
+    double cx = random.Uniform(0.0, width);
+    double cy = random.Uniform(0.0, height);
+    double r = random.Uniform(0.02, 0.1) * std::min(width, height);
+    std::uint32_t count = random.Integer(8, 16);
+
+    auto path = std::make_shared<Path>();
+    path->MoveTo(cx + r, cy);
+    for (std::uint32_t j = 1; j <= count; ++j) {
+      double control = (j - 0.5) * 2.0 * kPi / count;
+      double end = j * 2.0 * kPi / count;
+      double control_r = r * random.Uniform(0.6, 1.6);
+      double end_r = j == count ? r : r * random.Uniform(0.7, 1.2);
+      path->QuadTo(cx + control_r * std::cos(control), cy + control_r * std::sin(control),
+                   cx + end_r * std::cos(end), cy + end_r * std::sin(end));
+    }
+    path->Close();
+    AddPath(scene, random.Color(), path);
+  }
+}
+
+// A grid of 48 pixel icons built from cubics, as a toolbar or launcher would
+// draw them.
+void BuildIcons(Scene& scene, double width, double height, Random& random) {
+  constexpr double kCell = 48.0;
+
+  for (double y = 0.0; y + kCell <= height; y += kCell) {
+    for (double x = 0.0; x + kCell <= width; x += kCell) {
+      double cx = x + kCell / 2.0;
+      double cy = y + kCell / 2.0;
+
+      AddPath(scene, 0xFFE0E0E0,
+              MakeRoundedRect(x + 4.0, y + 4.0, x + kCell - 4.0, y + kCell - 4.0, 8.0));
+      switch (random.Integer(0, 2)) {
+        case 0:
+          AddPath(scene, random.Color() | 0xFF000000, MakeCircle(cx, cy, 14.0));
+          break;
+        case 1:
+          AddPath(scene, random.Color() | 0xFF000000, MakeHeart(cx, cy, 28.0));
+          break;
+        default:
+          AddPath(scene, random.Color() | 0xFF000000,
+                  MakeRoundedRect(cx - 12.0, cy - 12.0, cx + 12.0, cy + 12.0, 4.0));
+          break;
+      }
+    }
+  }
+}
+
+// Long random walks, as plotted data or handwriting would produce.
+void BuildPolylines(Scene& scene, double width, double height, Random& random) {
+  double step = std::min(width, height) / 100.0;
+
+  for (int i = 0; i < 20; ++i) {
+    double x = random.Uniform(0.0, width);
+    double y = random.Uniform(0.0, height);
+
+    auto path = std::make_shared<Path>();
+    path->MoveTo(x, y);
+    for (int j = 0; j < 2000; ++j) {
+      x = std::clamp(x + random.Uniform(-step, step), 0.0, width);
+      y = std::clamp(y + random.Uniform(-step, step), 0.0, height);
+      path->LineTo(x, y);
+    }
+    path->Close();
+    AddPath(scene, random.Color(), path);
+  }
+}
+
+// Small rectangles in batches of 100 per color, half of them pixel aligned.
+void BuildRects(Scene& scene, double width, double height, Random& random) {
+  for (int i = 0; i < 100; ++i) {
+    DrawCall call{random.Color(), nullptr, {}};
+    for (int j = 0; j < 100; ++j) {
+      double x = random.Uniform(0.0, width);
+      double y = random.Uniform(0.0, height);
+      double w = random.Uniform(2.0, 16.0);
+      double h = random.Uniform(2.0, 16.0);
+      if (j % 2 == 0) {
+        x = std::floor(x);
+        y = std::floor(y);
+        w = std::floor(w);
+        h = std::floor(h);
+      }
+      call.rects.emplace_back(x, y, x + w, y + h);
+    }
+    scene.path_count += call.rects.size();
+    scene.calls.push_back(std::move(call));
+  }
+}
+
+// Paths many times the size of the bitmap that barely touch it, or miss it.
+void BuildOffscreen(Scene& scene, double width, double height, Random& random) {
+  for (int i = 0; i < 100; ++i) {
+    double r = random.Uniform(4.0, 8.0) * std::max(width, height);
+    double angle = random.Uniform(0.0, 2.0 * kPi);
+    double distance = r + random.Uniform(-0.05, 0.5) * std::max(width, height);
+    double cx = width / 2.0 + distance * std::cos(angle);
+    double cy = height / 2.0 + distance * std::sin(angle);
+    AddPath(scene, random.Color(), MakeCircle(cx, cy, r));
+  }
+}
+
+struct SceneEntry {
+  const char* name;
+  void (*build)(Scene& scene, double width, double height, Random& random);
+};
+
+constexpr SceneEntry kScenes[] = {
+    {"polygons", BuildPolygons},   {"quads", BuildQuads}, {"icons", BuildIcons},
+    {"polylines", BuildPolylines}, {"rects", BuildRects}, {"offscreen", BuildOffscreen},
+};
+
+} // namespace
+
+std::vector<std::string> GetSceneNames() {
+  std::vector<std::string> names;
+  for (const auto& entry : kScenes) {
+    names.emplace_back(entry.name);
+  }
+  return names;
+}
+
+bool BuildScene(const std::string& name, std::uint32_t width, std::uint32_t height, Scene& scene) {
+  for (std::uint32_t i = 0; i < sizeof(kScenes) / sizeof(kScenes[0]); ++i) {
+    if (name != kScenes[i].name) {
+      continue;
+    }
+
+    scene = Scene();
+    scene.name = name;
+    Random random(0x5EED + i);
+    kScenes[i].build(scene, width, height, random);
+    return true;
+  }
+
+  return false;
+}
+
+void DrawScene(Canvas& canvas, const Scene& scene) {
+  for (const auto& call : scene.calls) {
+    canvas.SetFillColor(call.color);
+    if (call.path) {
+      canvas.FillPath(call.path);
+    } else {
+      canvas.FillRects(call.rects.data(), call.rects.size());
+    }
+  }
+}
+
+std::size_t CountEdges(const Scene& scene, std::uint32_t width, std::uint32_t height) {
+  EdgeStorage edge_storage((height + kBandHeight - 1) / kBandHeight, kBandHeight << kEdgeFixedShift);
+  const Rect clipping_box(0.0, 0.0, width * kEdgeFixedScale, height * kEdgeFixedScale);
+  EdgeBuilder builder(&edge_storage, clipping_box, kFlattenTolerance * kEdgeFixedScale);
+  EdgeTransform transform(kEdgeFixedScale);
+
+  std::size_t count = 0;
+  auto count_path = [&](const std::shared_ptr<Path>& path) {
+    edge_storage.Reset();
+    builder.Begin();
+    builder.AddPath(path, transform);
+    builder.End();
+
+    for (std::uint32_t i = 0; i < edge_storage.band_count; ++i) {
+      for (const auto& edge : edge_storage.bands[i].edges) {
+        count += edge.points.size() - 1;
+      }
+    }
+  };
+
+  for (const auto& call : scene.calls) {
+    if (call.path) {
+      count_path(call.path);
+      continue;
+    }
+
+    for (const auto& rect : call.rects) {
+      auto path = std::make_shared<Path>();
+      path->MoveTo(rect.min_x, rect.min_y);
+      path->LineTo(rect.max_x, rect.min_y);
+      path->LineTo(rect.max_x, rect.max_y);
+      path->LineTo(rect.min_x, rect.max_y);
+      path->Close();
+      count_path(path);
+    }
+  }
+
+  return count;
+}
+
+} // namespace bench
+} // namespace rezero
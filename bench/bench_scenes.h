@@ -0,0 +1,46 @@
+// Created by DONG Zhong on 2024/04/18.
+
+#ifndef REZERO_BENCH_BENCH_SCENES_H_
+#define REZERO_BENCH_BENCH_SCENES_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <rezero2d.h>
+
+namespace rezero {
+namespace bench {
+
+// A fill of `path`, or of `rects` when the path is null.
+struct DrawCall {
+  std::uint32_t color;
+  std::shared_ptr<Path> path;
+  std::vector<Rect> rects;
+};
+
+struct Scene {
+  std::string name;
+  std::vector<DrawCall> calls;
+  // Each rectangle counts as a path.
+  std::size_t path_count = 0;
+};
+
+// The names of the standard scenes, in the order they are run.
+std::vector<std::string> GetSceneNames();
+
+// Builds the scene `name` for a `width` x `height` bitmap. The scenes are
+// generated from a fixed seed, so every run draws the same paths.
+bool BuildScene(const std::string& name, std::uint32_t width, std::uint32_t height, Scene& scene);
+
+void DrawScene(Canvas& canvas, const Scene& scene);
+
+// The line segments the scene flattens to within a `width` x `height`
+// bitmap, after clipping.
+std::size_t CountEdges(const Scene& scene, std::uint32_t width, std::uint32_t height);
+
+} // namespace bench
+} // namespace rezero
+
+#endif // REZERO_BENCH_BENCH_SCENES_H_
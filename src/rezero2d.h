@@ -4,12 +4,19 @@
 #ifndef REZERO_REZERO_2D
 #define REZERO_REZERO_2D
 
+#include "rezero2d/allocator.h"
 #include "rezero2d/bitmap.h"
 #include "rezero2d/canvas.h"
 #include "rezero2d/codec.h"
+#include "rezero2d/damage_region.h"
 #include "rezero2d/data.h"
+#include "rezero2d/display_list.h"
+#include "rezero2d/executor.h"
+#include "rezero2d/fence.h"
 #include "rezero2d/format.h"
 #include "rezero2d/geometry.h"
 #include "rezero2d/path.h"
+#include "rezero2d/render_stats.h"
+#include "rezero2d/tracing.h"
 
 #endif // REZERO_REZERO_2D
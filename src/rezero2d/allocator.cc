@@ -0,0 +1,186 @@
+// Created by DONG Zhong on 2024/04/30.
+
+#include "rezero2d/allocator.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace rezero {
+
+namespace {
+
+constexpr std::size_t kMinSizeClass = 64;
+
+std::size_t AlignUp(std::size_t size, std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+class SystemAllocator : public Allocator {
+ public:
+  void* Allocate(std::size_t size) override { return std::malloc(size); }
+  void Free(void* data, std::size_t /*size*/) override { std::free(data); }
+};
+
+struct AllocatorState {
+  std::mutex mutex;
+  std::shared_ptr<Allocator> allocator;
+};
+
+AllocatorState& GetAllocatorState() {
+  static AllocatorState state;
+  return state;
+}
+
+} // namespace
+
+std::shared_ptr<Allocator> GetSystemAllocator() {
+  static const std::shared_ptr<Allocator> allocator = std::make_shared<SystemAllocator>();
+  return allocator;
+}
+
+std::shared_ptr<Allocator> GetAllocator() {
+  AllocatorState& state = GetAllocatorState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  return state.allocator ? state.allocator : GetSystemAllocator();
+}
+
+void SetAllocator(std::shared_ptr<Allocator> allocator) {
+  AllocatorState& state = GetAllocatorState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.allocator = std::move(allocator);
+}
+
+PoolAllocator::PoolAllocator(std::size_t max_cached_bytes, std::shared_ptr<Allocator> backing)
+    : backing_(backing ? std::move(backing) : GetSystemAllocator()),
+      max_cached_bytes_(max_cached_bytes) {}
+
+PoolAllocator::~PoolAllocator() {
+  Trim();
+}
+
+std::size_t PoolAllocator::GetSizeClass(std::size_t size) {
+  if (size <= kMinSizeClass) {
+    return kMinSizeClass;
+  }
+
+  // A quarter of the power of two below `size`.
+  std::size_t step = kMinSizeClass / 4;
+  while (step * 8 < size) {
+    step *= 2;
+  }
+  return (size + step - 1) / step * step;
+}
+
+void* PoolAllocator::Allocate(std::size_t size) {
+  std::size_t size_class = GetSizeClass(size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = free_lists_.find(size_class);
+    if (it != free_lists_.end() && !it->second.empty()) {
+      void* data = it->second.back();
+      it->second.pop_back();
+      cached_bytes_ -= size_class;
+      return data;
+    }
+  }
+  return backing_->Allocate(size_class);
+}
+
+void PoolAllocator::Free(void* data, std::size_t size) {
+  if (!data) {
+    return;
+  }
+
+  std::size_t size_class = GetSizeClass(size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cached_bytes_ + size_class <= max_cached_bytes_) {
+      free_lists_[size_class].push_back(data);
+      cached_bytes_ += size_class;
+      return;
+    }
+  }
+  backing_->Free(data, size_class);
+}
+
+void PoolAllocator::Trim() {
+  std::unordered_map<std::size_t, std::vector<void*>> free_lists;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_lists.swap(free_lists_);
+    cached_bytes_ = 0;
+  }
+
+  for (auto& entry : free_lists) {
+    for (void* data : entry.second) {
+      backing_->Free(data, entry.first);
+    }
+  }
+}
+
+std::size_t PoolAllocator::GetCachedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+HugePageAllocator::HugePageAllocator(const HugePageOptions& options,
+                                     std::shared_ptr<Allocator> small)
+    : options_(options), small_(small ? std::move(small) : GetSystemAllocator()) {}
+
+HugePageAllocator::~HugePageAllocator() = default;
+
+void* HugePageAllocator::Allocate(std::size_t size) {
+  if (size < options_.min_size) {
+    return small_->Allocate(size);
+  }
+
+  // Maps one huge page more than needed and trims the unaligned head and
+  // tail, as mmap only aligns to normal pages.
+  std::size_t mapped_size = AlignUp(size, kHugePageSize);
+  std::size_t reserved_size = mapped_size + kHugePageSize;
+  void* reserved = ::mmap(nullptr, reserved_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto begin = reinterpret_cast<std::uintptr_t>(reserved);
+  std::uintptr_t aligned = AlignUp(begin, kHugePageSize);
+  if (aligned > begin) {
+    ::munmap(reserved, aligned - begin);
+  }
+  std::size_t tail_size = begin + reserved_size - (aligned + mapped_size);
+  if (tail_size) {
+    ::munmap(reinterpret_cast<void*>(aligned + mapped_size), tail_size);
+  }
+
+  auto* data = reinterpret_cast<std::uint8_t*>(aligned);
+#ifdef MADV_HUGEPAGE
+  ::madvise(data, mapped_size, MADV_HUGEPAGE);
+#endif
+
+  if (options_.prefault) {
+    // Writes are needed, as reads would map the shared zero page.
+    auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    for (std::size_t offset = 0; offset < mapped_size; offset += page_size) {
+      static_cast<volatile std::uint8_t*>(data)[offset] = 0;
+    }
+  }
+
+  return data;
+}
+
+void HugePageAllocator::Free(void* data, std::size_t size) {
+  if (size < options_.min_size) {
+    small_->Free(data, size);
+    return;
+  }
+
+  if (data) {
+    ::munmap(data, AlignUp(size, kHugePageSize));
+  }
+}
+
+} // namespace rezero
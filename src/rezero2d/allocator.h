@@ -0,0 +1,108 @@
+// Created by DONG Zhong on 2024/04/30.
+
+#ifndef REZERO_ALLOCATOR_H_
+#define REZERO_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "rezero2d/base/macros.h"
+
+namespace rezero {
+
+// Provides the pixel buffers of bitmaps, the storage of Data and the
+// scratch buffers of canvases. Must be safe to call from several threads.
+class Allocator {
+ public:
+  virtual ~Allocator() = default;
+
+  // Returns `size` bytes aligned as std::malloc aligns them, or null.
+  virtual void* Allocate(std::size_t size) = 0;
+
+  // `size` is the one `data` was allocated with.
+  virtual void Free(void* data, std::size_t size) = 0;
+};
+
+// std::malloc and std::free.
+std::shared_ptr<Allocator> GetSystemAllocator();
+
+// The allocator used when none is given, the system one by default.
+std::shared_ptr<Allocator> GetAllocator();
+
+// Replaces the default allocator, or restores the system one when null.
+// Buffers are always freed by the allocator that allocated them.
+void SetAllocator(std::shared_ptr<Allocator> allocator);
+
+// Keeps freed buffers to hand them out again for requests of the same size
+// class, so drawing frames of the same size over and over allocates and
+// faults in their pages only once. Sizes are rounded up to four classes per
+// power of two.
+class PoolAllocator : public Allocator {
+ public:
+  static constexpr std::size_t kDefaultMaxCachedBytes = std::size_t(256) << 20;
+
+  // Takes its buffers from `backing`, or the system allocator when null,
+  // and keeps at most `max_cached_bytes` of freed ones.
+  explicit PoolAllocator(std::size_t max_cached_bytes = kDefaultMaxCachedBytes,
+                         std::shared_ptr<Allocator> backing = nullptr);
+  ~PoolAllocator() override;
+
+  void* Allocate(std::size_t size) override;
+  void Free(void* data, std::size_t size) override;
+
+  // Returns the kept buffers to the backing allocator.
+  void Trim();
+
+  std::size_t GetCachedBytes() const;
+
+  static std::size_t GetSizeClass(std::size_t size);
+
+ private:
+  std::shared_ptr<Allocator> backing_;
+  std::size_t max_cached_bytes_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::size_t, std::vector<void*>> free_lists_;
+  std::size_t cached_bytes_ = 0;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(PoolAllocator);
+};
+
+struct HugePageOptions {
+  // Smaller buffers go to the small allocator.
+  std::size_t min_size = std::size_t(2) << 20;
+  // Touches every page on allocation, so drawing into a new bitmap takes no
+  // page faults.
+  bool prefault = false;
+};
+
+// Maps large buffers aligned to 2 MB and asks the kernel to back them with
+// transparent huge pages, which saves most page faults and TLB misses when
+// a large bitmap is first drawn. Without madvise support the buffers are
+// still mapped, just with normal pages.
+class HugePageAllocator : public Allocator {
+ public:
+  static constexpr std::size_t kHugePageSize = std::size_t(2) << 20;
+
+  // Buffers below `options.min_size` come from `small`, or the system
+  // allocator when null.
+  explicit HugePageAllocator(const HugePageOptions& options = HugePageOptions(),
+                             std::shared_ptr<Allocator> small = nullptr);
+  ~HugePageAllocator() override;
+
+  void* Allocate(std::size_t size) override;
+  void Free(void* data, std::size_t size) override;
+
+ private:
+  HugePageOptions options_;
+  std::shared_ptr<Allocator> small_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(HugePageAllocator);
+};
+
+} // namespace rezero
+
+#endif // REZERO_ALLOCATOR_H_
@@ -2,6 +2,12 @@
 
 #include "rezero2d/base/api.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+#include "rezero2d/base/logging.h"
+
 namespace rezero {
 
 namespace endian {
@@ -20,4 +26,112 @@ Endianness GetEndianOrder() {
                    ? Endianness::kBigEndian : Endianness::kUnknown;
 }
 
+namespace {
+
+constexpr CpuFeature kCpuFeatures[] = {
+    CpuFeature::kSSE2, CpuFeature::kSSSE3,    CpuFeature::kSSE41,
+    CpuFeature::kAVX2, CpuFeature::kAVX512BW, CpuFeature::kBMI2,
+};
+
+constexpr std::uint32_t kAllCpuFeatures = 0xFFFFFFFF;
+
+std::atomic<std::uint32_t> cpu_feature_mask{kAllCpuFeatures};
+std::atomic<bool> cpu_features_used{false};
+
+// The mask set by REZERO_CPU_FEATURES, or all features when it is not set.
+std::uint32_t ReadCpuFeatureVariable() {
+  const char* variable = std::getenv("REZERO_CPU_FEATURES");
+  if (!variable) {
+    return kAllCpuFeatures;
+  }
+
+  std::uint32_t mask = 0;
+  std::string names(variable);
+  std::size_t begin = 0;
+  while (begin <= names.size()) {
+    std::size_t end = names.find(',', begin);
+    if (end == std::string::npos) {
+      end = names.size();
+    }
+    std::string name = names.substr(begin, end - begin);
+    begin = end + 1;
+
+    if (name.empty() || name == "none") {
+      continue;
+    }
+
+    bool found = false;
+    for (CpuFeature feature : kCpuFeatures) {
+      if (name == GetCpuFeatureName(feature)) {
+        mask |= static_cast<std::uint32_t>(feature);
+        found = true;
+      }
+    }
+    if (!found) {
+      REZERO_LOG(WARNING) << "Unknown CPU feature in REZERO_CPU_FEATURES: " << name;
+    }
+  }
+  return mask;
+}
+
+} // namespace
+
+const char* GetCpuFeatureName(CpuFeature feature) {
+  switch (feature) {
+    case CpuFeature::kSSE2:
+      return "sse2";
+    case CpuFeature::kSSSE3:
+      return "ssse3";
+    case CpuFeature::kSSE41:
+      return "sse4.1";
+    case CpuFeature::kAVX2:
+      return "avx2";
+    case CpuFeature::kAVX512BW:
+      return "avx512bw";
+    case CpuFeature::kBMI2:
+      return "bmi2";
+  }
+  return "unknown";
+}
+
+std::uint32_t DetectCpuFeatures() {
+  std::uint32_t features = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  // These also check that the OS saves the AVX registers.
+  __builtin_cpu_init();
+  auto add = [&features](bool supported, CpuFeature feature) {
+    if (supported) {
+      features |= static_cast<std::uint32_t>(feature);
+    }
+  };
+  add(__builtin_cpu_supports("sse2"), CpuFeature::kSSE2);
+  add(__builtin_cpu_supports("ssse3"), CpuFeature::kSSSE3);
+  add(__builtin_cpu_supports("sse4.1"), CpuFeature::kSSE41);
+  add(__builtin_cpu_supports("avx2"), CpuFeature::kAVX2);
+  add(__builtin_cpu_supports("avx512bw"), CpuFeature::kAVX512BW);
+  add(__builtin_cpu_supports("bmi2"), CpuFeature::kBMI2);
+#endif
+  return features;
+}
+
+std::uint32_t GetCpuFeatures() {
+  static const std::uint32_t available = DetectCpuFeatures() & ReadCpuFeatureVariable();
+  cpu_features_used.store(true, std::memory_order_relaxed);
+  return available & cpu_feature_mask.load(std::memory_order_relaxed);
+}
+
+bool HasCpuFeature(CpuFeature feature) {
+  return GetCpuFeatures() & static_cast<std::uint32_t>(feature);
+}
+
+bool SetCpuFeatureMask(std::uint32_t mask) {
+  if (cpu_features_used.load(std::memory_order_relaxed)) {
+    REZERO_LOG(ERROR) << "CPU features are already in use.";
+    return false;
+  }
+
+  cpu_feature_mask.store(mask, std::memory_order_relaxed);
+  return true;
+}
+
 } // namespace rezero
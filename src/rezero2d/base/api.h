@@ -15,6 +15,33 @@ enum class Endianness : std::uint32_t {
 
 Endianness GetEndianOrder();
 
+enum class CpuFeature : std::uint32_t {
+  kSSE2     = 1 << 0,
+  kSSSE3    = 1 << 1,
+  kSSE41    = 1 << 2,
+  kAVX2     = 1 << 3,
+  kAVX512BW = 1 << 4,
+  kBMI2     = 1 << 5,
+};
+
+// Lower case, as in the REZERO_CPU_FEATURES variable, e.g. "sse4.1".
+const char* GetCpuFeatureName(CpuFeature feature);
+
+// The CpuFeature bits the CPU and the OS support.
+std::uint32_t DetectCpuFeatures();
+
+// The CpuFeature bits kernels may use: the detected ones, limited by the
+// REZERO_CPU_FEATURES environment variable when set to a comma separated
+// list of names or to "none", then by SetCpuFeatureMask. Kernels are chosen
+// from it once, on first use.
+std::uint32_t GetCpuFeatures();
+bool HasCpuFeature(CpuFeature feature);
+
+// Limits the features kernels may use to `mask`, so every code path can be
+// tested on one machine. Fails once GetCpuFeatures has been called, so call
+// it before anything renders or decodes.
+bool SetCpuFeatureMask(std::uint32_t mask);
+
 } // namespace rezero
 
 #endif // REZERO_BASE_API_H_
@@ -0,0 +1,97 @@
+// Created by DONG Zhong on 2024/03/18.
+
+#include "rezero2d/base/file.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rezero {
+
+ScopedFD::~ScopedFD() {
+  Reset();
+}
+
+ScopedFD::ScopedFD(ScopedFD&& other) noexcept : fd_(other.Release()) {}
+
+ScopedFD& ScopedFD::operator=(ScopedFD&& other) noexcept {
+  if (this != &other) {
+    Reset(other.Release());
+  }
+  return *this;
+}
+
+int ScopedFD::Release() {
+  int fd = fd_;
+  fd_ = -1;
+  return fd;
+}
+
+void ScopedFD::Reset(int fd) {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  fd_ = fd;
+}
+
+ScopedFD OpenFileForRead(const std::string& file_path) {
+  return ScopedFD(::open(file_path.c_str(), O_RDONLY | O_CLOEXEC));
+}
+
+ScopedFD OpenFileForWrite(const std::string& file_path) {
+  return ScopedFD(::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+}
+
+ReplaceFileWriter::ReplaceFileWriter(const std::string& file_path)
+    : file_path_(file_path), temp_path_(file_path + ".XXXXXX") {
+  fd_.Reset(::mkostemp(&temp_path_[0], O_CLOEXEC));
+  // mkstemp creates the file 0600; match OpenFileForWrite.
+  if (fd_.IsValid() && ::fchmod(fd_.Get(), 0644) != 0) {
+    ::unlink(temp_path_.c_str());
+    fd_.Reset();
+  }
+}
+
+ReplaceFileWriter::~ReplaceFileWriter() {
+  if (fd_.IsValid()) {
+    fd_.Reset();
+    ::unlink(temp_path_.c_str());
+  }
+}
+
+bool ReplaceFileWriter::Commit() {
+  if (!fd_.IsValid()) {
+    return false;
+  }
+
+  bool closed = ::close(fd_.Release()) == 0;
+  if (!closed || std::rename(temp_path_.c_str(), file_path_.c_str()) != 0) {
+    ::unlink(temp_path_.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool WriteFully(int fd, const void* data, std::size_t size) {
+  const auto* p = static_cast<const char*>(data);
+
+  while (size > 0) {
+    ssize_t written = ::write(fd, p, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    p += written;
+    size -= static_cast<std::size_t>(written);
+  }
+
+  return true;
+}
+
+} // namespace rezero
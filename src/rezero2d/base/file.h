@@ -0,0 +1,66 @@
+// Created by DONG Zhong on 2024/03/18.
+
+#ifndef REZERO_BASE_FILE_H_
+#define REZERO_BASE_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+#include "rezero2d/base/macros.h"
+
+namespace rezero {
+
+// Owns a POSIX file descriptor and closes it on destruction.
+class ScopedFD {
+ public:
+  ScopedFD() = default;
+  explicit ScopedFD(int fd) : fd_(fd) {}
+  ~ScopedFD();
+
+  ScopedFD(ScopedFD&& other) noexcept;
+  ScopedFD& operator=(ScopedFD&& other) noexcept;
+
+  bool IsValid() const { return fd_ >= 0; }
+  int Get() const { return fd_; }
+
+  int Release();
+  void Reset(int fd = -1);
+
+ private:
+  int fd_ = -1;
+
+  REZERO_DISALLOW_COPY_AND_ASSIGN(ScopedFD);
+};
+
+ScopedFD OpenFileForRead(const std::string& file_path);
+
+// Creates or truncates `file_path`.
+ScopedFD OpenFileForWrite(const std::string& file_path);
+
+// Writes `file_path` through a temporary file in the same directory, which
+// Commit renames over it. Until then the old file stays intact, and the
+// temporary file is unlinked if the writer goes away uncommitted.
+class ReplaceFileWriter {
+ public:
+  explicit ReplaceFileWriter(const std::string& file_path);
+  ~ReplaceFileWriter();
+
+  bool IsValid() const { return fd_.IsValid(); }
+  int Get() const { return fd_.Get(); }
+
+  bool Commit();
+
+ private:
+  std::string file_path_;
+  std::string temp_path_;
+  ScopedFD fd_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(ReplaceFileWriter);
+};
+
+// Retries on EINTR and short writes until `size` bytes have been written.
+bool WriteFully(int fd, const void* data, std::size_t size);
+
+} // namespace rezero
+
+#endif // REZERO_BASE_FILE_H_
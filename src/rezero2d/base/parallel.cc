@@ -0,0 +1,87 @@
+// Created by DONG Zhong on 2024/03/30.
+
+#include "rezero2d/base/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "rezero2d/base/trace.h"
+#include "rezero2d/executor.h"
+
+namespace rezero {
+
+namespace {
+
+// Shared with the posted helpers, which may start after the loop is done.
+struct ParallelForState {
+  std::atomic<std::size_t> next_index{0};
+  std::atomic<std::size_t> finished_count{0};
+  std::mutex mutex;
+  std::condition_variable finished_condition;
+};
+
+} // namespace
+
+std::uint32_t ResolveThreadCount(std::uint32_t thread_count, std::size_t task_count) {
+  if (thread_count == 0) {
+    thread_count = GetExecutor()->GetConcurrency();
+  }
+  return static_cast<std::uint32_t>(std::max<std::size_t>(1, std::min<std::size_t>(thread_count, task_count)));
+}
+
+void ParallelFor(std::size_t task_count, std::uint32_t thread_count,
+                 const std::function<void(std::size_t index)>& task) {
+  thread_count = ResolveThreadCount(thread_count, task_count);
+
+  if (thread_count == 1) {
+    for (std::size_t i = 0; i < task_count; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  // Helpers only touch `task` after claiming an index, which the caller
+  // waits for, so it may live on the caller's stack.
+  auto state = std::make_shared<ParallelForState>();
+  auto worker = [state, &task, task_count]() {
+    REZERO_TRACE_SCOPE("ParallelFor");
+    std::size_t i;
+    std::size_t finished = 0;
+    while ((i = state->next_index.fetch_add(1, std::memory_order_relaxed)) < task_count) {
+      task(i);
+      ++finished;
+    }
+
+    if (finished &&
+        state->finished_count.fetch_add(finished, std::memory_order_acq_rel) + finished == task_count) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->finished_condition.notify_all();
+    }
+  };
+
+  std::shared_ptr<Executor> executor = GetExecutor();
+  for (std::uint32_t i = 1; i < thread_count; ++i) {
+    executor->Post(worker);
+  }
+  // Without free threads, the caller runs every task itself.
+  worker();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished_condition.wait(lock, [&state, task_count]() {
+    return state->finished_count.load(std::memory_order_acquire) == task_count;
+  });
+}
+
+void ParallelForRange(std::size_t count, std::size_t grain, std::uint32_t thread_count,
+                      const std::function<void(std::size_t begin, std::size_t end)>& task) {
+  grain = std::max<std::size_t>(1, grain);
+  std::size_t range_count = (count + grain - 1) / grain;
+  ParallelFor(range_count, thread_count, [&](std::size_t i) {
+    task(i * grain, std::min(count, (i + 1) * grain));
+  });
+}
+
+} // namespace rezero
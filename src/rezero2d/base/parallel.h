@@ -0,0 +1,31 @@
+// Created by DONG Zhong on 2024/03/30.
+
+#ifndef REZERO_BASE_PARALLEL_H_
+#define REZERO_BASE_PARALLEL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace rezero {
+
+// Maps a requested thread count to the number to use: 0 means the
+// concurrency of the executor, and the result is never above `task_count`
+// or below 1.
+std::uint32_t ResolveThreadCount(std::uint32_t thread_count, std::size_t task_count);
+
+// Calls `task(i)` for every `i` in `[0, task_count)` on up to `thread_count`
+// threads, the calling thread and those of the executor, and returns when
+// all have finished. Tasks are claimed in index order but may complete in
+// any order, and no two tasks running at once share an index.
+void ParallelFor(std::size_t task_count, std::uint32_t thread_count,
+                 const std::function<void(std::size_t index)>& task);
+
+// Calls `task(begin, end)` over `[0, count)` split into ranges of `grain`,
+// such as rows of an image.
+void ParallelForRange(std::size_t count, std::size_t grain, std::uint32_t thread_count,
+                      const std::function<void(std::size_t begin, std::size_t end)>& task);
+
+} // namespace rezero
+
+#endif // REZERO_BASE_PARALLEL_H_
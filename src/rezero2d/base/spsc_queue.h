@@ -0,0 +1,70 @@
+// Created by DONG Zhong on 2024/04/10.
+
+#ifndef REZERO_BASE_SPSC_QUEUE_H_
+#define REZERO_BASE_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+#include "rezero2d/base/macros.h"
+
+namespace rezero {
+
+// An unbounded lock-free queue for exactly one producer thread and one
+// consumer thread. `T` must be default constructible.
+template <typename T>
+class SPSCQueue {
+ public:
+  SPSCQueue() : head_(new Node()), tail_(head_) {}
+
+  ~SPSCQueue() {
+    while (head_) {
+      Node* next = head_->next.load(std::memory_order_relaxed);
+      delete head_;
+      head_ = next;
+    }
+  }
+
+  // Producer only.
+  void Push(T value) {
+    Node* node = new Node();
+    node->value = std::move(value);
+    tail_->next.store(node, std::memory_order_release);
+    tail_ = node;
+  }
+
+  // Consumer only. Returns false when the queue is empty.
+  bool Pop(T& value) {
+    Node* next = head_->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+
+    // `next` becomes the new sentinel once its value has been taken.
+    value = std::move(next->value);
+    next->value = T();
+    delete head_;
+    head_ = next;
+    return true;
+  }
+
+  // Consumer only.
+  bool IsEmpty() const { return !head_->next.load(std::memory_order_acquire); }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  // The consumer owns `head_`, a sentinel whose value was already popped,
+  // and the producer owns `tail_`.
+  Node* head_;
+  Node* tail_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(SPSCQueue);
+};
+
+} // namespace rezero
+
+#endif // REZERO_BASE_SPSC_QUEUE_H_
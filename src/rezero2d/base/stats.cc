@@ -0,0 +1,101 @@
+// Created by DONG Zhong on 2024/04/24.
+
+#include "rezero2d/base/stats.h"
+
+namespace rezero {
+
+bool IsRenderStatsEnabled() {
+#ifdef REZERO_ENABLE_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+void StatsCollector::Reset(std::uint32_t band_count) {
+  path_count = 0;
+  line_count = 0;
+  quad_count = 0;
+  cubic_count = 0;
+  conic_count = 0;
+  quad_split_count = 0;
+  border_edge_count = 0;
+  composited_pixel_count = 0;
+  for (auto& ns : stage_ns) {
+    ns = 0;
+  }
+
+  if (band_count_ != band_count) {
+    band_edge_counts_ = std::make_unique<std::atomic<std::uint64_t>[]>(band_count);
+    band_count_ = band_count;
+  }
+  for (std::uint32_t i = 0; i < band_count_; ++i) {
+    band_edge_counts_[i] = 0;
+  }
+}
+
+RenderStats StatsCollector::GetStats() const {
+  RenderStats stats;
+  stats.path_count = path_count;
+  stats.line_count = line_count;
+  stats.quad_count = quad_count;
+  stats.cubic_count = cubic_count;
+  stats.conic_count = conic_count;
+  stats.quad_split_count = quad_split_count;
+  stats.border_edge_count = border_edge_count;
+  stats.composited_pixel_count = composited_pixel_count;
+  stats.edge_building_ns = stage_ns[std::uint32_t(StatsStage::kEdgeBuilding)];
+  stats.rasterization_ns = stage_ns[std::uint32_t(StatsStage::kRasterization)];
+  stats.compositing_ns = stage_ns[std::uint32_t(StatsStage::kCompositing)];
+
+  stats.band_edge_counts.resize(band_count_);
+  for (std::uint32_t i = 0; i < band_count_; ++i) {
+    stats.band_edge_counts[i] = band_edge_counts_[i];
+  }
+  return stats;
+}
+
+#ifdef REZERO_ENABLE_STATS
+
+namespace {
+
+thread_local StatsCollector* current_collector = nullptr;
+thread_local StatsTimer* current_timer = nullptr;
+
+} // namespace
+
+StatsCollector* GetCurrentStats() {
+  return current_collector;
+}
+
+StatsScope::StatsScope(StatsCollector* collector) : previous_(current_collector) {
+  current_collector = collector;
+}
+
+StatsScope::~StatsScope() {
+  current_collector = previous_;
+}
+
+StatsTimer::StatsTimer(StatsStage stage)
+    : stage_(stage), start_(Clock::now()), parent_(current_timer) {
+  current_timer = this;
+}
+
+StatsTimer::~StatsTimer() {
+  auto elapsed = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+
+  current_timer = parent_;
+  if (parent_) {
+    parent_->nested_ns_ += elapsed;
+  }
+
+  if (StatsCollector* collector = current_collector) {
+    collector->stage_ns[std::uint32_t(stage_)].fetch_add(elapsed - nested_ns_,
+                                                          std::memory_order_relaxed);
+  }
+}
+
+#endif // REZERO_ENABLE_STATS
+
+} // namespace rezero
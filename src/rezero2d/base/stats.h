@@ -0,0 +1,128 @@
+// Created by DONG Zhong on 2024/04/24.
+
+#ifndef REZERO_BASE_STATS_H_
+#define REZERO_BASE_STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/render_stats.h"
+
+namespace rezero {
+
+enum class StatsStage : std::uint32_t {
+  kEdgeBuilding,
+  kRasterization,
+  kCompositing,
+  kCount,
+};
+
+// The counters of one canvas session. They are updated with relaxed atomics
+// from whichever threads render it.
+class StatsCollector {
+ public:
+  StatsCollector() = default;
+  ~StatsCollector() = default;
+
+  void Reset(std::uint32_t band_count);
+
+  RenderStats GetStats() const;
+
+  void AddBandEdge(std::uint32_t band_id) {
+    if (band_id < band_count_) {
+      band_edge_counts_[band_id].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::atomic<std::uint64_t> path_count{0};
+  std::atomic<std::uint64_t> line_count{0};
+  std::atomic<std::uint64_t> quad_count{0};
+  std::atomic<std::uint64_t> cubic_count{0};
+  std::atomic<std::uint64_t> conic_count{0};
+  std::atomic<std::uint64_t> quad_split_count{0};
+  std::atomic<std::uint64_t> border_edge_count{0};
+  std::atomic<std::uint64_t> composited_pixel_count{0};
+  std::atomic<std::uint64_t> stage_ns[std::uint32_t(StatsStage::kCount)] = {};
+
+ private:
+  std::uint32_t band_count_ = 0;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> band_edge_counts_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(StatsCollector);
+};
+
+#ifdef REZERO_ENABLE_STATS
+
+// The collector of the session the calling thread renders, or null.
+StatsCollector* GetCurrentStats();
+
+// Makes `collector` the one of the calling thread until destroyed.
+class StatsScope {
+ public:
+  explicit StatsScope(StatsCollector* collector);
+  ~StatsScope();
+
+ private:
+  StatsCollector* previous_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(StatsScope);
+};
+
+// Adds the time until destroyed to `stage`, less the time of the timers
+// started on the same thread meanwhile.
+class StatsTimer {
+ public:
+  explicit StatsTimer(StatsStage stage);
+  ~StatsTimer();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  StatsStage stage_;
+  Clock::time_point start_;
+  std::uint64_t nested_ns_ = 0;
+  StatsTimer* parent_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(StatsTimer);
+};
+
+#define REZERO_STATS_ADD(counter, value)                                      \
+  do {                                                                        \
+    if (::rezero::StatsCollector* rezero_stats = ::rezero::GetCurrentStats()) { \
+      rezero_stats->counter.fetch_add(value, std::memory_order_relaxed);      \
+    }                                                                         \
+  } while (0)
+
+#define REZERO_STATS_ADD_BAND_EDGE(band_id)                                   \
+  do {                                                                        \
+    if (::rezero::StatsCollector* rezero_stats = ::rezero::GetCurrentStats()) { \
+      rezero_stats->AddBandEdge(band_id);                                     \
+    }                                                                         \
+  } while (0)
+
+#define REZERO_STATS_SCOPE(collector) ::rezero::StatsScope rezero_stats_scope(collector)
+
+#define REZERO_STATS_TIMER(stage) \
+  ::rezero::StatsTimer rezero_stats_timer(::rezero::StatsStage::stage)
+
+#else
+
+#define REZERO_STATS_ADD(counter, value) \
+  do {                                   \
+  } while (0)
+
+#define REZERO_STATS_ADD_BAND_EDGE(band_id) \
+  do {                                      \
+  } while (0)
+
+#define REZERO_STATS_SCOPE(collector)
+#define REZERO_STATS_TIMER(stage)
+
+#endif // REZERO_ENABLE_STATS
+
+} // namespace rezero
+
+#endif // REZERO_BASE_STATS_H_
@@ -0,0 +1,56 @@
+// Created by DONG Zhong on 2024/04/30.
+
+#ifndef REZERO_BASE_STD_ALLOCATOR_H_
+#define REZERO_BASE_STD_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "rezero2d/allocator.h"
+#include "rezero2d/base/logging.h"
+
+namespace rezero {
+
+// Lets standard containers take their storage from an Allocator.
+template <typename T>
+class StdAllocator {
+ public:
+  using value_type = T;
+
+  explicit StdAllocator(std::shared_ptr<Allocator> allocator = nullptr)
+      : allocator_(allocator ? std::move(allocator) : ::rezero::GetAllocator()) {}
+
+  template <typename U>
+  StdAllocator(const StdAllocator<U>& other) : allocator_(other.GetAllocator()) {}
+
+  T* allocate(std::size_t count) {
+    void* data = allocator_->Allocate(count * sizeof(T));
+    REZERO_CHECK(data);
+    return static_cast<T*>(data);
+  }
+
+  void deallocate(T* data, std::size_t count) { allocator_->Free(data, count * sizeof(T)); }
+
+  const std::shared_ptr<Allocator>& GetAllocator() const { return allocator_; }
+
+  template <typename U>
+  bool operator==(const StdAllocator<U>& other) const {
+    return allocator_ == other.GetAllocator();
+  }
+
+  template <typename U>
+  bool operator!=(const StdAllocator<U>& other) const {
+    return allocator_ != other.GetAllocator();
+  }
+
+ private:
+  std::shared_ptr<Allocator> allocator_;
+};
+
+template <typename T>
+using AllocatorVector = std::vector<T, StdAllocator<T>>;
+
+} // namespace rezero
+
+#endif // REZERO_BASE_STD_ALLOCATOR_H_
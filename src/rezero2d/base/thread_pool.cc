@@ -0,0 +1,185 @@
+// Created by DONG Zhong on 2024/04/28.
+
+#include "rezero2d/base/thread_pool.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "rezero2d/base/logging.h"
+
+namespace rezero {
+
+namespace {
+
+// The pool state and worker the calling thread belongs to, if any.
+thread_local const void* current_state = nullptr;
+thread_local std::size_t current_worker = 0;
+
+struct ExecutorState {
+  std::mutex mutex;
+  std::shared_ptr<Executor> executor;
+  ThreadPoolOptions pool_options;
+};
+
+ExecutorState& GetExecutorState() {
+  static ExecutorState state;
+  return state;
+}
+
+void SetAffinity(std::thread& thread, int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  if (pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) != 0) {
+    REZERO_LOG(WARNING) << "Failed to pin a worker to CPU " << cpu << ".";
+  }
+#else
+  REZERO_LOG(WARNING) << "Pinning workers is not supported on this platform.";
+#endif
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options) {
+  std::uint32_t thread_count = options.thread_count;
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+  }
+
+  for (std::uint32_t i = 0; i < thread_count; ++i) {
+    state_->workers.push_back(std::make_unique<Worker>());
+  }
+  // Workers steal from each other, so all must exist before any starts.
+  for (std::uint32_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(&ThreadPool::WorkerMain, state_, i);
+    if (!options.cpus.empty()) {
+      SetAffinity(threads_[i], options.cpus[i % options.cpus.size()]);
+    }
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(state_->sleep_mutex);
+    state_->stopping = true;
+  }
+  state_->sleep_condition.notify_all();
+
+  for (auto& thread : threads_) {
+    // The last reference may be dropped by a task of this pool. Its worker
+    // keeps the state alive and exits once the pending tasks are done.
+    if (thread.get_id() == std::this_thread::get_id()) {
+      thread.detach();
+    } else {
+      thread.join();
+    }
+  }
+}
+
+void ThreadPool::Post(std::function<void()> task) {
+  State& state = *state_;
+  if (state.workers.empty()) {
+    task();
+    return;
+  }
+
+  std::size_t index = current_state == &state
+                          ? current_worker
+                          : state.next_worker.fetch_add(1, std::memory_order_relaxed) %
+                                state.workers.size();
+  {
+    std::lock_guard<std::mutex> lock(state.workers[index]->mutex);
+    state.workers[index]->tasks.push_back(std::move(task));
+  }
+
+  // Pairs with the sleeping count a worker raises before checking for tasks,
+  // so either it finds this one or it is woken up.
+  state.pending_count.fetch_add(1, std::memory_order_seq_cst);
+  if (state.sleeping_count.load(std::memory_order_seq_cst)) {
+    std::lock_guard<std::mutex> lock(state.sleep_mutex);
+    state.sleep_condition.notify_one();
+  }
+}
+
+void ThreadPool::WorkerMain(std::shared_ptr<State> state, std::size_t index) {
+  current_state = state.get();
+  current_worker = index;
+
+  std::function<void()> task;
+  while (true) {
+    if (state->TakeTask(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(state->sleep_mutex);
+    if (state->stopping && !state->pending_count.load(std::memory_order_seq_cst)) {
+      return;
+    }
+    state->sleeping_count.fetch_add(1, std::memory_order_seq_cst);
+    state->sleep_condition.wait(lock, [&state]() {
+      return state->stopping || state->pending_count.load(std::memory_order_seq_cst);
+    });
+    state->sleeping_count.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+bool ThreadPool::State::TakeTask(std::size_t index, std::function<void()>& task) {
+  {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      pending_count.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  for (std::size_t i = 1; i < workers.size(); ++i) {
+    Worker& victim = *workers[(index + i) % workers.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      pending_count.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::shared_ptr<Executor> GetExecutor() {
+  ExecutorState& state = GetExecutorState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (!state.executor) {
+    state.executor = std::make_shared<ThreadPool>(state.pool_options);
+  }
+  return state.executor;
+}
+
+void SetExecutor(std::shared_ptr<Executor> executor) {
+  ExecutorState& state = GetExecutorState();
+  // Released after the lock, as destroying a pool waits for its workers.
+  std::shared_ptr<Executor> previous;
+  std::lock_guard<std::mutex> lock(state.mutex);
+  previous = std::move(state.executor);
+  state.executor = std::move(executor);
+}
+
+void ConfigureThreadPool(const ThreadPoolOptions& options) {
+  ExecutorState& state = GetExecutorState();
+  std::shared_ptr<Executor> previous;
+  std::lock_guard<std::mutex> lock(state.mutex);
+  previous = std::move(state.executor);
+  state.pool_options = options;
+}
+
+} // namespace rezero
@@ -0,0 +1,67 @@
+// Created by DONG Zhong on 2024/04/28.
+
+#ifndef REZERO_BASE_THREAD_POOL_H_
+#define REZERO_BASE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/executor.h"
+
+namespace rezero {
+
+// A work-stealing pool. Each worker runs the tasks it posted itself newest
+// first, takes the oldest tasks of the others when it has none, and sleeps
+// when no worker has any.
+class ThreadPool : public Executor {
+ public:
+  explicit ThreadPool(const ThreadPoolOptions& options);
+  ~ThreadPool() override;
+
+  void Post(std::function<void()> task) override;
+
+  std::uint32_t GetConcurrency() const override {
+    return static_cast<std::uint32_t>(threads_.size()) + 1;
+  }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Everything the workers use. Each worker owns it as well as the pool, as
+  // a task of the pool may drop its last reference. The pool then detaches
+  // that worker, which finishes without touching the destroyed pool.
+  struct State {
+    bool TakeTask(std::size_t index, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<std::size_t> next_worker{0};
+
+    // Tasks posted and not taken yet.
+    std::atomic<std::size_t> pending_count{0};
+    std::atomic<std::size_t> sleeping_count{0};
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    bool stopping = false;
+  };
+
+  static void WorkerMain(std::shared_ptr<State> state, std::size_t index);
+
+  std::shared_ptr<State> state_ = std::make_shared<State>();
+  std::vector<std::thread> threads_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(ThreadPool);
+};
+
+} // namespace rezero
+
+#endif // REZERO_BASE_THREAD_POOL_H_
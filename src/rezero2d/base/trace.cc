@@ -0,0 +1,233 @@
+// Created by DONG Zhong on 2024/04/26.
+
+#include "rezero2d/base/trace.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rezero2d/base/logging.h"
+
+namespace rezero {
+
+std::atomic<bool> trace_enabled{false};
+
+namespace {
+
+// Events kept per thread, a power of two.
+constexpr std::uint64_t kTraceBufferSize = 1 << 15;
+
+// A seqlock slot, as the exporter may read it while it is overwritten.
+struct TraceEvent {
+  // `2 * index + 1` while the event at `index` is written, and `2 * index + 2`
+  // once it is.
+  std::atomic<std::uint64_t> sequence{0};
+  std::atomic<const char*> name{nullptr};
+  // The timestamp shifted left by one, with the lowest bit set for ends.
+  std::atomic<std::uint64_t> stamp{0};
+};
+
+// Written only by the thread holding it, and read by the exporter. A buffer
+// is handed to another thread once its thread exits, so the threads of
+// successive ParallelFor calls do not each add one. `count` only grows, so
+// an index always names the same event.
+struct TraceBuffer {
+  std::uint32_t thread_id = 0;
+  bool in_use = false;
+  std::atomic<std::uint64_t> count{0};
+  std::unique_ptr<TraceEvent[]> events = std::make_unique<TraceEvent[]>(kTraceBufferSize);
+};
+
+struct TraceRegistry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<TraceBuffer>> buffers;
+  std::uint64_t start_time = 0;
+};
+
+// Never destroyed, as threads may still record while the process exits.
+TraceRegistry& GetRegistry() {
+  static TraceRegistry* registry = new TraceRegistry();
+  return *registry;
+}
+
+std::uint64_t GetTimestamp() {
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                        std::chrono::steady_clock::now().time_since_epoch())
+                                        .count());
+}
+
+TraceBuffer* AcquireBuffer() {
+  TraceRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto& buffer : registry.buffers) {
+    if (!buffer->in_use) {
+      buffer->in_use = true;
+      return buffer.get();
+    }
+  }
+
+  auto buffer = std::make_unique<TraceBuffer>();
+  buffer->thread_id = static_cast<std::uint32_t>(registry.buffers.size() + 1);
+  buffer->in_use = true;
+  registry.buffers.push_back(std::move(buffer));
+  return registry.buffers.back().get();
+}
+
+void ReleaseBuffer(TraceBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(GetRegistry().mutex);
+  buffer->in_use = false;
+}
+
+struct ThreadBuffer {
+  ~ThreadBuffer() {
+    if (buffer) {
+      ReleaseBuffer(buffer);
+    }
+  }
+
+  TraceBuffer* buffer = nullptr;
+};
+
+thread_local ThreadBuffer thread_buffer;
+
+// Reads the event at `index` unless it is being or has been overwritten.
+bool ReadEvent(const TraceBuffer& buffer, std::uint64_t index, const char*& name,
+               std::uint64_t& stamp) {
+  const TraceEvent& event = buffer.events[index & (kTraceBufferSize - 1)];
+  std::uint64_t sequence = 2 * index + 2;
+  if (event.sequence.load(std::memory_order_acquire) != sequence) {
+    return false;
+  }
+
+  name = event.name.load(std::memory_order_relaxed);
+  stamp = event.stamp.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return event.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+void AppendJsonString(std::string& out, const char* text) {
+  out += '"';
+  for (; *text; ++text) {
+    char c = *text;
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escape[8];
+      std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+      out += escape;
+    } else {
+      out += c;
+    }
+  }
+  out += '"';
+}
+
+} // namespace
+
+void AddTraceEvent(const char* name, bool is_end) {
+  TraceBuffer* buffer = thread_buffer.buffer;
+  if (!buffer) {
+    buffer = thread_buffer.buffer = AcquireBuffer();
+  }
+
+  std::uint64_t index = buffer->count.load(std::memory_order_relaxed);
+  TraceEvent& event = buffer->events[index & (kTraceBufferSize - 1)];
+  event.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  event.name.store(name, std::memory_order_relaxed);
+  event.stamp.store((GetTimestamp() << 1) | std::uint64_t(is_end), std::memory_order_relaxed);
+  event.sequence.store(2 * index + 2, std::memory_order_release);
+  buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void StartTracing() {
+  TraceRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (trace_enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  // The buffers are left to their threads, and the exporter drops the
+  // events recorded before this.
+  registry.start_time = GetTimestamp();
+  trace_enabled.store(true, std::memory_order_release);
+}
+
+void StopTracing() {
+  trace_enabled.store(false, std::memory_order_release);
+}
+
+bool IsTracing() {
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+std::string ExportChromeTrace() {
+  TraceRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+                    "\"args\":{\"name\":\"rezero2d\"}}";
+  char fields[96];
+  for (const auto& buffer : registry.buffers) {
+    std::uint64_t count = buffer->count.load(std::memory_order_acquire);
+    std::uint64_t first = count > kTraceBufferSize ? count - kTraceBufferSize : 0;
+
+    // Ends whose begin was overwritten or recorded before the start would
+    // close the wrong slices.
+    std::uint32_t depth = 0;
+    for (std::uint64_t i = first; i < count; ++i) {
+      const char* name;
+      std::uint64_t stamp;
+      if (!ReadEvent(*buffer, i, name, stamp)) {
+        continue;
+      }
+
+      std::uint64_t timestamp = stamp >> 1;
+      bool is_end = stamp & 1;
+      if (timestamp < registry.start_time) {
+        continue;
+      }
+
+      if (is_end) {
+        if (depth == 0) {
+          continue;
+        }
+        --depth;
+      } else {
+        ++depth;
+      }
+
+      out += ",\n{\"name\":";
+      AppendJsonString(out, name);
+      std::snprintf(fields, sizeof(fields), ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                    is_end ? 'E' : 'B', (timestamp - registry.start_time) / 1000.0,
+                    buffer->thread_id);
+      out += fields;
+    }
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+bool WriteChromeTrace(const std::string& path) {
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    REZERO_LOG(ERROR) << "Failed to open " << path << " for writing.";
+    return false;
+  }
+
+  file << ExportChromeTrace();
+  if (!file) {
+    REZERO_LOG(ERROR) << "Failed to write " << path << ".";
+    return false;
+  }
+  return true;
+}
+
+} // namespace rezero
@@ -0,0 +1,46 @@
+// Created by DONG Zhong on 2024/04/26.
+
+#ifndef REZERO_BASE_TRACE_H_
+#define REZERO_BASE_TRACE_H_
+
+#include <atomic>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/tracing.h"
+
+namespace rezero {
+
+extern std::atomic<bool> trace_enabled;
+
+// Records an event in the ring buffer of the calling thread. `name` must
+// outlive the trace, as only the pointer is kept.
+void AddTraceEvent(const char* name, bool is_end);
+
+// Records the begin of `name` when created and its end when destroyed, if
+// tracing was on when created.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name)
+      : name_(trace_enabled.load(std::memory_order_relaxed) ? name : nullptr) {
+    if (name_) {
+      AddTraceEvent(name_, false);
+    }
+  }
+
+  ~TraceScope() {
+    if (name_) {
+      AddTraceEvent(name_, true);
+    }
+  }
+
+ private:
+  const char* name_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(TraceScope);
+};
+
+} // namespace rezero
+
+#define REZERO_TRACE_SCOPE(name) ::rezero::TraceScope rezero_trace_scope(name)
+
+#endif // REZERO_BASE_TRACE_H_
@@ -2,36 +2,216 @@
 
 #include "rezero2d/bitmap.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "rezero2d/base/file.h"
 #include "rezero2d/base/logging.h"
-#include "rezero2d/codec.h"
 
 namespace rezero {
 
+std::shared_ptr<Bitmap> Bitmap::Decode(CodecType type, const std::shared_ptr<Data>& data) {
+  if (!data) {
+    return nullptr;
+  }
+
+  auto codec = type == CodecType::kDefault ? Codec::FindCodec(*data, nullptr, true)
+                                            : Codec::GetCodec(type);
+
+  ImageInfo info;
+  if (!codec || !codec->CanDecodePixels() || !codec->DecodeInfo(*data, info)) {
+    return nullptr;
+  }
+
+  // Codecs bound the size by the data where they can, which not every
+  // encoding allows, so a header alone never gets an arbitrary allocation.
+  FormatInformation format_info(info.format);
+  if (std::uint64_t(info.width) * info.height > kMaxDecodeSize / format_info.GetBytesPerPixel()) {
+    return nullptr;
+  }
+
+  auto bitmap = std::make_shared<Bitmap>();
+  if (!bitmap->AllocatePixels(info.width, info.height, info.format, nullptr) ||
+      !codec->DecodePixels(*data, info, bitmap->data_, bitmap->stride_)) {
+    return nullptr;
+  }
+
+  return bitmap;
+}
+
+std::shared_ptr<Bitmap> Bitmap::DecodeFile(CodecType type, const std::string& file_path) {
+  return Decode(type, Data::MakeFromFileMapping(file_path));
+}
+
 Bitmap::Bitmap() = default;
 
 Bitmap::~Bitmap() {
-  if (data_) {
-    std::free(data_);
-  }
+  ReleasePixels();
 }
 
-void Bitmap::Init(std::uint32_t width, std::uint32_t height, Format format) {
+void Bitmap::Init(std::uint32_t width, std::uint32_t height, Format format,
+                  std::shared_ptr<Allocator> allocator) {
   REZERO_CHECK(width > 0 && height > 0);
 
-  if (data_) {
-    std::free(data_);
-    data_ = nullptr;
+  bool allocated = AllocatePixels(width, height, format, std::move(allocator));
+  REZERO_CHECK(allocated);
+}
+
+bool Bitmap::AllocatePixels(std::uint32_t width, std::uint32_t height, Format format,
+                            std::shared_ptr<Allocator> allocator) {
+  ReleasePixels();
+  allocator_ = allocator ? std::move(allocator) : GetAllocator();
+
+  format_ = format;
+  width_ = width;
+  height_ = height;
+
+  FormatInformation format_info(format);
+  std::uint64_t stride = std::uint64_t(width) * format_info.GetBytesPerPixel();
+  if (!width || !height || stride > std::numeric_limits<std::uint32_t>::max() ||
+      stride * height > std::numeric_limits<std::size_t>::max()) {
+    stride_ = 0;
+    return false;
   }
 
+  stride_ = static_cast<std::uint32_t>(stride);
+  data_ = allocator_->Allocate(std::size_t(stride_) * height);
+  return data_ != nullptr;
+}
+
+void Bitmap::InitTiled(std::uint32_t width, std::uint32_t height, Format format,
+                       std::uint32_t tile_size, std::shared_ptr<Allocator> allocator) {
+  REZERO_CHECK(width > 0 && height > 0 && tile_size > 0);
+
+  ReleasePixels();
+  allocator_ = allocator ? std::move(allocator) : GetAllocator();
+
   format_ = format;
   width_ = width;
   height_ = height;
 
   FormatInformation format_info(format);
-  stride_ = width * format_info.GetBytesPerPixel();
-  data_ = std::malloc(width * height * format_info.GetBytesPerPixel());
+  stride_ = tile_size * format_info.GetBytesPerPixel();
+
+  tile_size_ = tile_size;
+  tile_columns_ = (width + tile_size - 1) / tile_size;
+  tile_rows_ = (height + tile_size - 1) / tile_size;
+
+  std::size_t tile_count = std::size_t(tile_columns_) * tile_rows_;
+  tiles_.reset(new std::atomic<std::uint8_t*>[tile_count]);
+  for (std::size_t i = 0; i < tile_count; ++i) {
+    tiles_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+void Bitmap::ReleasePixels() {
+  if (data_) {
+    allocator_->Free(data_, std::size_t(stride_) * height_);
+    data_ = nullptr;
+  }
+
+  if (tiles_) {
+    std::size_t tile_count = std::size_t(tile_columns_) * tile_rows_;
+    for (std::size_t i = 0; i < tile_count; ++i) {
+      if (std::uint8_t* tile = tiles_[i].load(std::memory_order_relaxed)) {
+        allocator_->Free(tile, GetTileByteSize());
+      }
+    }
+    tiles_.reset();
+  }
+
+  tile_size_ = 0;
+  tile_columns_ = 0;
+  tile_rows_ = 0;
+}
+
+std::size_t Bitmap::GetAllocatedTileCount() const {
+  std::size_t tile_count = std::size_t(tile_columns_) * tile_rows_;
+  std::size_t allocated = 0;
+  for (std::size_t i = 0; i < tile_count; ++i) {
+    if (tiles_[i].load(std::memory_order_acquire)) {
+      ++allocated;
+    }
+  }
+  return allocated;
+}
+
+std::uint8_t* Bitmap::GetTile(std::uint32_t tile_x, std::uint32_t tile_y, bool allocate) {
+  REZERO_DCHECK(tile_x < tile_columns_ && tile_y < tile_rows_);
+
+  auto& slot = tiles_[std::size_t(tile_y) * tile_columns_ + tile_x];
+  std::uint8_t* tile = slot.load(std::memory_order_acquire);
+  if (tile || !allocate) {
+    return tile;
+  }
+
+  // Zeroes are what an untouched tile reads as.
+  auto* fresh = static_cast<std::uint8_t*>(allocator_->Allocate(GetTileByteSize()));
+  REZERO_CHECK(fresh);
+  std::memset(fresh, 0, GetTileByteSize());
+
+  if (!slot.compare_exchange_strong(tile, fresh, std::memory_order_acq_rel)) {
+    // Another thread allocated it first.
+    allocator_->Free(fresh, GetTileByteSize());
+    return tile;
+  }
+  return fresh;
+}
+
+const std::uint8_t* Bitmap::GetTile(std::uint32_t tile_x, std::uint32_t tile_y) const {
+  REZERO_DCHECK(tile_x < tile_columns_ && tile_y < tile_rows_);
+  return tiles_[std::size_t(tile_y) * tile_columns_ + tile_x].load(std::memory_order_acquire);
+}
+
+void Bitmap::ReadPixels(void* dst, std::uint32_t dst_stride) const {
+  ReadRows(0, height_, dst, dst_stride);
+}
 
-  REZERO_CHECK(data_);
+void Bitmap::ReadRows(std::uint32_t y0, std::uint32_t count, void* dst,
+                      std::size_t dst_stride) const {
+  FormatInformation format_info(format_);
+  std::uint32_t bpp = format_info.GetBytesPerPixel();
+  auto* dst_row = static_cast<std::uint8_t*>(dst);
+  std::uint32_t y1 = y0 + count;
+
+  if (!IsTiled()) {
+    const auto* src_row = static_cast<const std::uint8_t*>(data_) + std::size_t(y0) * stride_;
+    for (std::uint32_t y = y0; y < y1; ++y, src_row += stride_, dst_row += dst_stride) {
+      std::memcpy(dst_row, src_row, std::size_t(width_) * bpp);
+    }
+    return;
+  }
+
+  for (std::uint32_t y = y0; y < y1; ++y, dst_row += dst_stride) {
+    std::uint32_t tile_y = y / tile_size_;
+    std::size_t tile_offset = std::size_t(y % tile_size_) * stride_;
+
+    for (std::uint32_t tile_x = 0; tile_x < tile_columns_; ++tile_x) {
+      std::uint32_t x0 = tile_x * tile_size_;
+      std::size_t size = std::size_t(std::min(tile_size_, width_ - x0)) * bpp;
+      const std::uint8_t* tile = GetTile(tile_x, tile_y);
+      if (tile) {
+        std::memcpy(dst_row + std::size_t(x0) * bpp, tile + tile_offset, size);
+      } else {
+        std::memset(dst_row + std::size_t(x0) * bpp, 0, size);
+      }
+    }
+  }
+}
+
+PixelRows Bitmap::GetPixelRows() const {
+  FormatInformation format_info(format_);
+  std::size_t row_size = std::size_t(width_) * format_info.GetBytesPerPixel();
+  if (!IsTiled()) {
+    return PixelRows(data_, row_size);
+  }
+
+  auto read = [this, row_size](std::uint32_t y, std::uint32_t count, std::uint8_t* dst) {
+    ReadRows(y, count, dst, row_size);
+  };
+  return PixelRows(read, row_size);
 }
 
 std::shared_ptr<Data> Bitmap::GetPixelData() {
@@ -39,28 +219,73 @@ std::shared_ptr<Data> Bitmap::GetPixelData() {
     return nullptr;
   }
 
-  auto data = std::make_shared<Data>();
-
   FormatInformation format_info(format_);
-  data->Init(width_ * height_ * format_info.GetBytesPerPixel(), data_);
+  std::uint32_t row_size = width_ * format_info.GetBytesPerPixel();
+
+  std::shared_ptr<Data> data;
+  if (IsTiled()) {
+    data = Data::MakeUninitialized(std::size_t(row_size) * height_);
+    ReadPixels(data->GetData(), row_size);
+  } else {
+    data = Data::MakeWithCopy(data_, std::size_t(row_size) * height_);
+  }
 
   flag_.clear();
 
   return data;
 }
 
-std::shared_ptr<Data> Bitmap::EncodeAsFileData(CodecType type) {
+std::shared_ptr<Data> Bitmap::EncodeAsFileData(CodecType type, const EncodeOptions& options) {
   if (flag_.test_and_set()) {
     REZERO_LOG(ERROR) << "Bitmap has been occupied.";
     return nullptr;
   }
 
   auto codec = Codec::GetCodec(type);
-  auto data = codec->EncodeToFileData(format_, width_, height_, data_);
+  auto data = codec->EncodeToFileData(format_, width_, height_, GetPixelRows(), options);
 
   flag_.clear();
 
   return data;
 }
 
+bool Bitmap::EncodeToSink(CodecType type, const EncodeSink& sink, const EncodeOptions& options) {
+  if (flag_.test_and_set()) {
+    REZERO_LOG(ERROR) << "Bitmap has been occupied.";
+    return false;
+  }
+
+  auto codec = Codec::GetCodec(type);
+  bool result = codec->EncodeToSink(format_, width_, height_, GetPixelRows(), options, sink);
+
+  flag_.clear();
+
+  return result;
+}
+
+bool Bitmap::EncodeToFile(CodecType type, const std::string& file_path,
+                          const EncodeOptions& options) {
+  if (flag_.test_and_set()) {
+    REZERO_LOG(ERROR) << "Bitmap has been occupied.";
+    return false;
+  }
+
+  // The target is only replaced once the whole file has been encoded.
+  ReplaceFileWriter writer(file_path);
+  if (!writer.IsValid()) {
+    REZERO_LOG(ERROR) << "Failed to open " << file_path << ".";
+    flag_.clear();
+    return false;
+  }
+
+  auto codec = Codec::GetCodec(type);
+  bool result =
+      codec->EncodeToFile(format_, width_, height_, GetPixelRows(), options, writer.Get()) &&
+      writer.Commit();
+
+  flag_.clear();
+
+  return result;
+}
+
 } // namespace rezero
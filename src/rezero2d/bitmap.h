@@ -6,39 +6,101 @@
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 
+#include "rezero2d/allocator.h"
 #include "rezero2d/base/macros.h"
+#include "rezero2d/codec.h"
 #include "rezero2d/data.h"
 #include "rezero2d/format.h"
 
 namespace rezero {
 
-enum class CodecType : std::uint8_t;
-
 class Canvas;
 
 class Bitmap {
  public:
+  // Decode rejects images whose pixels would take more bytes than this.
+  static constexpr std::uint64_t kMaxDecodeSize = std::uint64_t(1) << 32;
+
+  // CodecType::kDefault picks the codec from the data itself. Returns null
+  // when the codec cannot decode pixels or the pixels cannot be allocated.
+  static std::shared_ptr<Bitmap> Decode(CodecType type, const std::shared_ptr<Data>& data);
+
+  // Maps the file instead of reading it into a buffer.
+  static std::shared_ptr<Bitmap> DecodeFile(CodecType type, const std::string& file_path);
+
+  static constexpr std::uint32_t kDefaultTileSize = 256;
+
   Bitmap();
   ~Bitmap();
 
-  void Init(std::uint32_t width, std::uint32_t height, Format format);
+  // The pixels come from `allocator`, or GetAllocator when null.
+  void Init(std::uint32_t width, std::uint32_t height, Format format,
+            std::shared_ptr<Allocator> allocator = nullptr);
+
+  // Stores the pixels as `tile_size` square tiles that are allocated on the
+  // first draw touching them. Tiles never drawn to take no memory and read
+  // as transparent.
+  void InitTiled(std::uint32_t width, std::uint32_t height, Format format,
+                 std::uint32_t tile_size = kDefaultTileSize,
+                 std::shared_ptr<Allocator> allocator = nullptr);
 
   Format GetFormat() const { return format_; }
   std::uint32_t GetWidth() const { return width_; }
   std::uint32_t GetHeight() const { return height_; }
+  // The distance between rows; within a tile for tiled bitmaps.
   std::uint32_t GetStride() const { return stride_; }
 
+  bool IsTiled() const { return tile_size_ != 0; }
+  std::uint32_t GetTileSize() const { return tile_size_; }
+  std::size_t GetAllocatedTileCount() const;
+
+  // Copies the pixels into `dst`, whose rows are `dst_stride` bytes apart.
+  void ReadPixels(void* dst, std::uint32_t dst_stride) const;
+
   std::shared_ptr<Data> GetPixelData();
 
-  std::shared_ptr<Data> EncodeAsFileData(CodecType type);
+  std::shared_ptr<Data> EncodeAsFileData(CodecType type,
+                                         const EncodeOptions& options = EncodeOptions());
+
+  // Streams the encoded file without materializing it in memory.
+  bool EncodeToSink(CodecType type, const EncodeSink& sink,
+                    const EncodeOptions& options = EncodeOptions());
+  bool EncodeToFile(CodecType type, const std::string& file_path,
+                    const EncodeOptions& options = EncodeOptions());
 
  private:
+  // Init without the checks, returning false when the stride does not fit
+  // 32 bits or the allocation fails.
+  bool AllocatePixels(std::uint32_t width, std::uint32_t height, Format format,
+                      std::shared_ptr<Allocator> allocator);
+  void ReleasePixels();
+
+  // Returns the tile at tile coordinates `tile_x` and `tile_y`, allocating it
+  // when `allocate` is set, or null. Safe to call from several threads.
+  std::uint8_t* GetTile(std::uint32_t tile_x, std::uint32_t tile_y, bool allocate);
+  std::size_t GetTileByteSize() const { return std::size_t(stride_) * tile_size_; }
+  const std::uint8_t* GetTile(std::uint32_t tile_x, std::uint32_t tile_y) const;
+
+  // Copies rows `[y0, y0 + count)` into `dst`.
+  void ReadRows(std::uint32_t y0, std::uint32_t count, void* dst, std::size_t dst_stride) const;
+
+  // The pixels as the codecs read them. Tiled bitmaps are read a row range
+  // at a time straight from the tiles, never as a whole.
+  PixelRows GetPixelRows() const;
+
   Format format_;
   std::uint32_t width_ = 0;
   std::uint32_t height_ = 0;
   std::uint32_t stride_ = 0;
-  void* data_;
+  void* data_ = nullptr;
+  std::shared_ptr<Allocator> allocator_;
+
+  std::uint32_t tile_size_ = 0;
+  std::uint32_t tile_columns_ = 0;
+  std::uint32_t tile_rows_ = 0;
+  std::unique_ptr<std::atomic<std::uint8_t*>[]> tiles_;
 
   std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
 
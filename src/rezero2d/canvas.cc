@@ -2,55 +2,1046 @@
 
 #include "rezero2d/canvas.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include "rezero2d/base/logging.h"
+#include "rezero2d/base/parallel.h"
+#include "rezero2d/base/stats.h"
+#include "rezero2d/base/std_allocator.h"
+#include "rezero2d/base/trace.h"
+#include "rezero2d/raster/compositor.h"
+#include "rezero2d/raster/edge_builder.h"
+#include "rezero2d/raster/edge_storage.h"
+#include "rezero2d/raster/rasterizer.h"
 
 namespace rezero {
 
+namespace {
+
+constexpr std::uint32_t kBandHeight = 32;
+
+// In pixels.
+constexpr double kFlattenTolerance = 0.2;
+
+// Fills that far apart in a display list are never batched together.
+constexpr std::size_t kBatchWindow = 64;
+
+// The unit of work claimed by a thread in kBinned mode.
+constexpr std::uint32_t kBandsPerGroup = 2;
+
+// Paths of a kBinned frame are built and rendered this many at a time, so
+// the frame reuses a bounded set of edge storages however long it is.
+constexpr std::size_t kFramePathsPerBatch = 64;
+
+// Trace event names, in Command::Type order.
+constexpr const char* kCommandTraceNames[] = {
+    "Begin",   "End",     "FillPath", "FillRects", "DrawDisplayList", "ClipToRegion",
+    "Save",    "Restore", "ClipRect", "ClipPath",  "Flush",           "Quit",
+};
+
+// Fixed point rounding as done by the edge builder, so that rectangles
+// cover the same pixels as the equivalent paths.
+inline double QuantizeCoordinate(double value) {
+  return std::trunc(value * kEdgeFixedScale) / kEdgeFixedScale;
+}
+
+inline std::uint8_t CalculateCoverage(double area) {
+  return static_cast<std::uint8_t>(std::min(area, 1.0) * 255.0 + 0.5);
+}
+
+inline std::uint8_t MulDiv255(std::uint32_t a, std::uint32_t b) {
+  std::uint32_t x = a * b + 128;
+  return static_cast<std::uint8_t>((x + (x >> 8)) >> 8);
+}
+
+bool HasCoverage(const std::uint8_t* coverage, std::uint32_t count) {
+  return std::any_of(coverage, coverage + count, [](std::uint8_t value) { return value != 0; });
+}
+
+Rect IntersectRect(const Rect& a, const Rect& b) {
+  return Rect(std::max(a.min_x, b.min_x), std::max(a.min_y, b.min_y),
+              std::min(a.max_x, b.max_x), std::min(a.max_y, b.max_y));
+}
+
+// The pixels a command with control point `bounds` may touch.
+IntRect CalculatePixelBox(const Rect& bounds, double scale, std::uint32_t width,
+                          std::uint32_t height) {
+  auto clamp = [](double value, std::uint32_t limit) {
+    return static_cast<std::int32_t>(std::clamp(value, 0.0, double(limit)));
+  };
+  return {clamp(std::floor(bounds.min_x * scale), width), clamp(std::floor(bounds.min_y * scale), height),
+          clamp(std::ceil(bounds.max_x * scale), width), clamp(std::ceil(bounds.max_y * scale), height)};
+}
+
+} // namespace
+
+// The coverage of the path clips in effect, over `bounds`. Pixels outside
+// of it are fully clipped.
+struct Canvas::ClipMask {
+  const std::uint8_t* GetRow(std::int32_t y) const {
+    return alpha.data() + std::size_t(y - bounds.min_y) * (bounds.max_x - bounds.min_x);
+  }
+
+  IntRect bounds;
+  AllocatorVector<std::uint8_t> alpha;
+};
+
+// Writes the coverage of a clip path into a new mask, intersected with the
+// mask of the enclosing clip if there is one.
+class Canvas::MaskSink : public SpanSink {
+ public:
+  MaskSink(ClipMask* mask, const ClipMask* parent) : mask_(mask), parent_(parent) {}
+
+  void BlendSpan(std::uint32_t y, std::uint32_t x0, std::uint32_t x1,
+                 const std::uint8_t* coverage) override {
+    const IntRect& bounds = mask_->bounds;
+    auto row = static_cast<std::int32_t>(y);
+    auto begin = std::max(static_cast<std::int32_t>(x0), bounds.min_x);
+    auto end = std::min(static_cast<std::int32_t>(x1), bounds.max_x);
+    if (row < bounds.min_y || row >= bounds.max_y || begin >= end) {
+      return;
+    }
+
+    auto* dst = const_cast<std::uint8_t*>(mask_->GetRow(row)) - bounds.min_x;
+    coverage -= x0;
+    for (std::int32_t x = begin; x < end; ++x) {
+      dst[x] = coverage[x];
+    }
+
+    if (!parent_) {
+      return;
+    }
+
+    // A parent row only covers its own bounds, which contain ours.
+    const std::uint8_t* parent_row = parent_->GetRow(row) - parent_->bounds.min_x;
+    for (std::int32_t x = begin; x < end; ++x) {
+      dst[x] = MulDiv255(dst[x], parent_row[x]);
+    }
+  }
+
+ private:
+  ClipMask* mask_;
+  const ClipMask* parent_;
+};
+
+// Composites spans into the pixels of the bitmap, within `clip` if given.
+// On tiled bitmaps the span is cut at tile borders and only the pieces with
+// coverage touch a tile, so the tiles a fill never reaches stay unallocated.
+class Canvas::BitmapSink : public SpanSink {
+ public:
+  BitmapSink(Bitmap* bitmap, std::uint32_t color, const DamageRegion* clip, const ClipMask* mask)
+      : bitmap_(bitmap), color_(color), clip_(clip), mask_(mask),
+        bytes_per_pixel_(FormatInformation(bitmap->GetFormat()).GetBytesPerPixel()) {}
+
+  void BlendSpan(std::uint32_t y, std::uint32_t x0, std::uint32_t x1,
+                 const std::uint8_t* coverage) override {
+    if (!clip_) {
+      Blend(y, x0, x1, coverage);
+      return;
+    }
+
+    // The rectangles never overlap, so no pixel is blended twice.
+    auto row = static_cast<std::int32_t>(y);
+    for (const auto& rect : clip_->GetRects()) {
+      if (row < rect.min_y || row >= rect.max_y) {
+        continue;
+      }
+
+      auto clip_x0 = std::max(x0, static_cast<std::uint32_t>(rect.min_x));
+      auto clip_x1 = std::min(x1, static_cast<std::uint32_t>(rect.max_x));
+      if (clip_x0 < clip_x1) {
+        Blend(y, clip_x0, clip_x1, coverage + (clip_x0 - x0));
+      }
+    }
+  }
+
+  // Blends `coverage` over pixels `[x0, x1)` of row `y`.
+  void FillSpan(std::uint32_t y, std::uint32_t x0, std::uint32_t x1, std::uint8_t coverage) {
+    if (clip_ || mask_) {
+      constant_.assign(x1 - x0, coverage);
+      BlendSpan(y, x0, x1, constant_.data());
+      return;
+    }
+
+    Format format = bitmap_->GetFormat();
+    std::size_t stride = bitmap_->GetStride();
+
+    if (!bitmap_->IsTiled()) {
+      auto* row = static_cast<std::uint8_t*>(bitmap_->data_) + y * stride;
+      CompositeSrcOverSolid(format, row + std::size_t(x0) * bytes_per_pixel_, coverage, x1 - x0,
+                            color_);
+      return;
+    }
+
+    std::uint32_t tile_size = bitmap_->GetTileSize();
+    std::uint32_t tile_y = y / tile_size;
+    std::size_t row_offset = (y % tile_size) * stride;
+
+    while (x0 < x1) {
+      std::uint32_t tile_x = x0 / tile_size;
+      std::uint32_t end = std::min(x1, (tile_x + 1) * tile_size);
+
+      std::uint8_t* tile = bitmap_->GetTile(tile_x, tile_y, true);
+      std::size_t offset = row_offset + std::size_t(x0 - tile_x * tile_size) * bytes_per_pixel_;
+      CompositeSrcOverSolid(format, tile + offset, coverage, end - x0, color_);
+
+      x0 = end;
+    }
+  }
+
+  // Fills the rows `[row_begin, row_end)` of `rect`, which lies within the
+  // bitmap. Only the border pixels need their coverage computed; every other
+  // pixel of a row shares the row's vertical coverage.
+  void FillRect(const Rect& rect, std::int32_t row_begin, std::int32_t row_end) {
+    auto x0 = static_cast<std::int32_t>(std::floor(rect.min_x));
+    auto x1 = static_cast<std::int32_t>(std::ceil(rect.max_x));
+    auto inner_x0 = static_cast<std::int32_t>(std::ceil(rect.min_x));
+    auto inner_x1 = static_cast<std::int32_t>(std::floor(rect.max_x));
+    bool single_column = x1 - x0 == 1;
+
+    auto y0 = std::max(static_cast<std::int32_t>(std::floor(rect.min_y)), row_begin);
+    auto y1 = std::min(static_cast<std::int32_t>(std::ceil(rect.max_y)), row_end);
+
+    for (std::int32_t y = y0; y < y1; ++y) {
+      double coverage_y = std::min(y + 1.0, rect.max_y) - std::max(double(y), rect.min_y);
+      auto row = static_cast<std::uint32_t>(y);
+
+      if (single_column) {
+        std::uint8_t coverage = CalculateCoverage((rect.max_x - rect.min_x) * coverage_y);
+        BlendSpan(row, x0, x0 + 1, &coverage);
+        continue;
+      }
+
+      if (x0 < inner_x0) {
+        std::uint8_t coverage = CalculateCoverage((inner_x0 - rect.min_x) * coverage_y);
+        BlendSpan(row, x0, inner_x0, &coverage);
+      }
+      if (inner_x0 < inner_x1) {
+        FillSpan(row, inner_x0, inner_x1, CalculateCoverage(coverage_y));
+      }
+      if (inner_x1 < x1) {
+        std::uint8_t coverage = CalculateCoverage((rect.max_x - inner_x1) * coverage_y);
+        BlendSpan(row, inner_x1, x1, &coverage);
+      }
+    }
+  }
+
+ private:
+  void Blend(std::uint32_t y, std::uint32_t x0, std::uint32_t x1, const std::uint8_t* coverage) {
+    if (mask_) {
+      const IntRect& bounds = mask_->bounds;
+      auto row = static_cast<std::int32_t>(y);
+      auto begin = std::max(static_cast<std::int32_t>(x0), bounds.min_x);
+      auto end = std::min(static_cast<std::int32_t>(x1), bounds.max_x);
+      if (row < bounds.min_y || row >= bounds.max_y || begin >= end) {
+        return;
+      }
+
+      const std::uint8_t* mask_row = mask_->GetRow(row) - bounds.min_x;
+      masked_.resize(end - begin);
+      for (std::int32_t x = begin; x < end; ++x) {
+        masked_[x - begin] = MulDiv255(coverage[x - x0], mask_row[x]);
+      }
+
+      coverage = masked_.data();
+      x0 = begin;
+      x1 = end;
+    }
+
+    Format format = bitmap_->GetFormat();
+    std::size_t stride = bitmap_->GetStride();
+
+    if (!bitmap_->IsTiled()) {
+      auto* row = static_cast<std::uint8_t*>(bitmap_->data_) + y * stride;
+      CompositeSrcOver(format, row + std::size_t(x0) * bytes_per_pixel_, coverage, x1 - x0, color_);
+      return;
+    }
+
+    std::uint32_t tile_size = bitmap_->GetTileSize();
+    std::uint32_t tile_y = y / tile_size;
+    std::size_t row_offset = (y % tile_size) * stride;
+
+    while (x0 < x1) {
+      std::uint32_t tile_x = x0 / tile_size;
+      std::uint32_t end = std::min(x1, (tile_x + 1) * tile_size);
+      std::uint32_t count = end - x0;
+
+      if (HasCoverage(coverage, count)) {
+        std::uint8_t* tile = bitmap_->GetTile(tile_x, tile_y, true);
+        std::size_t offset = row_offset + std::size_t(x0 - tile_x * tile_size) * bytes_per_pixel_;
+        CompositeSrcOver(format, tile + offset, coverage, count, color_);
+      }
+
+      coverage += count;
+      x0 = end;
+    }
+  }
+
+  Bitmap* bitmap_;
+  std::uint32_t color_;
+  const DamageRegion* clip_;
+  const ClipMask* mask_;
+  std::uint32_t bytes_per_pixel_;
+  std::vector<std::uint8_t> masked_;
+  std::vector<std::uint8_t> constant_;
+};
+
 Canvas::Canvas() = default;
 
 Canvas::~Canvas() {
   End();
+
+  if (render_thread_.joinable()) {
+    Command quit;
+    quit.type = Command::Type::kQuit;
+    Enqueue(std::move(quit));
+    render_thread_.join();
+  }
 }
 
-bool Canvas::Begin(const std::shared_ptr<Bitmap>& bitmap) {
-  REZERO_CHECK(!bitmap_);
+bool Canvas::Begin(const std::shared_ptr<Bitmap>& bitmap, RenderMode mode) {
+  REZERO_CHECK(!bitmap_ && !recording_);
 
   if (bitmap->flag_.test_and_set()) {
     REZERO_LOG(ERROR) << "Bitmap has been occupied.";
     return false;
   }
 
+  if (mode == RenderMode::kAsync && !render_thread_.joinable()) {
+    render_thread_ = std::thread(&Canvas::RenderMain, this);
+  } else if (mode != RenderMode::kAsync && render_thread_.joinable()) {
+    // Sync and binned sessions render on this thread with the state the
+    // rendering thread uses, and it may still be busy with an earlier
+    // asynchronous session.
+    Command flush;
+    flush.type = Command::Type::kFlush;
+    flush.fence = std::make_shared<Fence>();
+    auto fence = flush.fence;
+    Enqueue(std::move(flush));
+    fence->Wait();
+  }
+
   bitmap_ = bitmap;
+  mode_ = mode;
 
-  return true;
+  Command command;
+  command.type = Command::Type::kBegin;
+  command.mode = mode;
+  command.thread_count = thread_count_;
+  command.allocator = allocator_ ? allocator_ : GetAllocator();
+  command.bitmap = bitmap;
+  return Submit(std::move(command));
 }
 
-void Canvas::End() {
-  if (bitmap_) {
-    bitmap_->flag_.clear();
+std::shared_ptr<Fence> Canvas::End() {
+  if (!bitmap_) {
+    return Fence::MakeSignaled();
   }
 
+  Command command;
+  command.type = Command::Type::kEnd;
+  command.fence = std::make_shared<Fence>();
+  auto fence = command.fence;
+  Submit(std::move(command));
+
   bitmap_ = nullptr;
+
+  return fence;
+}
+
+std::shared_ptr<Fence> Canvas::Flush() {
+  if (!bitmap_ || mode_ == RenderMode::kSync) {
+    return Fence::MakeSignaled();
+  }
+
+  Command command;
+  command.type = Command::Type::kFlush;
+  command.fence = std::make_shared<Fence>();
+  auto fence = command.fence;
+  Submit(std::move(command));
+
+  return fence;
 }
 
 bool Canvas::FillPath(const std::shared_ptr<Path>& path) {
+  if (!path) {
+    return false;
+  }
+
+  if (recording_) {
+    recording_->AddFillPath(path, fill_color_);
+    return true;
+  }
+
   if (!bitmap_) {
     return false;
   }
 
+  Command command;
+  command.type = Command::Type::kFillPath;
+  command.color = fill_color_;
+  command.path = path;
+  return Submit(std::move(command));
+}
+
+bool Canvas::FillRect(const Rect& rect) {
+  return FillRects(&rect, 1);
+}
+
+bool Canvas::FillRects(const Rect* rects, std::size_t count) {
+  if (recording_) {
+    for (std::size_t i = 0; i < count; ++i) {
+      const Rect& rect = rects[i];
+      auto path = std::make_shared<Path>();
+      path->MoveTo(rect.min_x, rect.min_y);
+      path->LineTo(rect.max_x, rect.min_y);
+      path->LineTo(rect.max_x, rect.max_y);
+      path->LineTo(rect.min_x, rect.max_y);
+      path->Close();
+      recording_->AddFillPath(path, fill_color_);
+    }
+    return true;
+  }
+
+  if (!bitmap_) {
+    return false;
+  }
+
+  Command command;
+  command.type = Command::Type::kFillRects;
+  command.color = fill_color_;
+  command.rects.assign(rects, rects + count);
+  return Submit(std::move(command));
+}
+
+bool Canvas::StrokePath(const std::shared_ptr<Path>& path) {
+  if (!bitmap_ && !recording_) {
+    return false;
+  }
+
   // TODO:
 
   return true;
 }
 
-bool Canvas::StrokePath(const std::shared_ptr<Path>& path) {
+void Canvas::SetFillColor(std::uint32_t argb) {
+  fill_color_ = PremultiplyColor(argb);
+}
+
+void Canvas::Save() {
   if (!bitmap_) {
+    return;
+  }
+
+  Command command;
+  command.type = Command::Type::kSave;
+  Submit(std::move(command));
+}
+
+void Canvas::Restore() {
+  if (!bitmap_) {
+    return;
+  }
+
+  Command command;
+  command.type = Command::Type::kRestore;
+  Submit(std::move(command));
+}
+
+void Canvas::ClipRect(const Rect& rect) {
+  if (!bitmap_) {
+    return;
+  }
+
+  Command command;
+  command.type = Command::Type::kClipRect;
+  command.rect_min = Point(rect.min_x, rect.min_y);
+  command.rect_max = Point(rect.max_x, rect.max_y);
+  Submit(std::move(command));
+}
+
+bool Canvas::ClipPath(const std::shared_ptr<Path>& path) {
+  if (!bitmap_ || !path) {
     return false;
   }
 
-  // TODO:
+  Command command;
+  command.type = Command::Type::kClipPath;
+  command.path = path;
+  return Submit(std::move(command));
+}
+
+void Canvas::ClipToRegion(const DamageRegion& region) {
+  if (!bitmap_) {
+    return;
+  }
+
+  Command command;
+  command.type = Command::Type::kClipToRegion;
+  command.region = std::make_shared<const DamageRegion>(region);
+  Submit(std::move(command));
+}
+
+DamageRegion Canvas::GetDamage() const {
+  std::lock_guard<std::mutex> lock(damage_mutex_);
+  return last_damage_;
+}
+
+RenderStats Canvas::GetStats() const {
+  std::lock_guard<std::mutex> lock(damage_mutex_);
+  return last_stats_;
+}
+
+bool Canvas::BeginRecording() {
+  if (bitmap_ || recording_) {
+    REZERO_LOG(ERROR) << "Canvas is in use.";
+    return false;
+  }
+
+  recording_ = std::make_shared<DisplayList>();
+  return true;
+}
+
+std::shared_ptr<DisplayList> Canvas::EndRecording() {
+  auto display_list = std::move(recording_);
+  recording_ = nullptr;
+  if (display_list) {
+    display_list->path_indices_.clear();
+  }
+  return display_list;
+}
+
+bool Canvas::DrawDisplayList(const std::shared_ptr<const DisplayList>& display_list, double scale) {
+  if (!bitmap_ || !display_list || !(scale > 0.0)) {
+    return false;
+  }
+
+  Command command;
+  command.type = Command::Type::kDrawDisplayList;
+  command.scale = scale;
+  command.display_list = display_list;
+  return Submit(std::move(command));
+}
+
+bool Canvas::Submit(Command command) {
+  if (mode_ != RenderMode::kAsync) {
+    return Execute(command);
+  }
+
+  Enqueue(std::move(command));
+  return true;
+}
+
+void Canvas::Enqueue(Command command) {
+  queue_.Push(std::move(command));
+
+  // Pairs with the fence in RenderMain, so either the rendering thread sees
+  // the command before it sleeps or this thread sees it sleeping.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (render_thread_sleeping_.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_condition_.notify_one();
+  }
+}
+
+bool Canvas::Execute(Command& command) {
+#ifdef REZERO_ENABLE_STATS
+  if (command.type == Command::Type::kBegin && !stats_) {
+    stats_ = std::make_unique<StatsCollector>();
+  }
+#endif
+  REZERO_STATS_SCOPE(stats_.get());
+  static_assert(sizeof(kCommandTraceNames) / sizeof(kCommandTraceNames[0]) ==
+                static_cast<std::size_t>(Command::Type::kQuit) + 1);
+  REZERO_TRACE_SCOPE(kCommandTraceNames[static_cast<std::size_t>(command.type)]);
+
+  switch (command.type) {
+    case Command::Type::kBegin: {
+      target_ = std::move(command.bitmap);
+      binned_ = command.mode == RenderMode::kBinned;
+      frame_thread_count_ = command.thread_count;
+      scratch_allocator_ = std::move(command.allocator);
+      std::uint32_t width = target_->GetWidth();
+      std::uint32_t height = target_->GetHeight();
+      std::uint32_t band_count = (height + kBandHeight - 1) / kBandHeight;
+      edge_storage_ = std::make_unique<EdgeStorage>(band_count, kBandHeight << kEdgeFixedShift,
+                                                    scratch_allocator_);
+      rasterizer_ = std::make_unique<Rasterizer>(width, height, kBandHeight, scratch_allocator_);
+      damage_.Clear();
+      clip_region_ = nullptr;
+      clip_stack_.clear();
+      ResetClip();
+      if (stats_) {
+        stats_->Reset(band_count);
+      }
+      return true;
+    }
+    case Command::Type::kEnd: {
+      bool result = !binned_ || RenderFrame();
+      {
+        std::lock_guard<std::mutex> lock(damage_mutex_);
+        last_damage_ = damage_;
+        if (stats_) {
+          last_stats_ = stats_->GetStats();
+        }
+      }
+      damage_.Clear();
+      clip_region_ = nullptr;
+      clip_stack_.clear();
+      clip_.mask = nullptr;
+      target_->flag_.clear();
+      target_ = nullptr;
+      edge_storage_ = nullptr;
+      rasterizer_ = nullptr;
+      frame_edge_storages_.clear();
+      frame_rasterizers_.clear();
+      frame_path_commands_.clear();
+      frame_group_commands_.clear();
+      scratch_allocator_ = nullptr;
+      command.fence->Signal();
+      return result;
+    }
+    case Command::Type::kClipToRegion:
+      if (binned_) {
+        // The frame collected so far was drawn under the previous clip.
+        RenderFrame();
+      }
+      clip_region_ = std::move(command.region);
+      return true;
+    case Command::Type::kSave:
+      clip_stack_.push_back(clip_);
+      return true;
+    case Command::Type::kRestore:
+    case Command::Type::kClipRect:
+    case Command::Type::kClipPath:
+      if (binned_) {
+        // The frame collected so far was drawn under the current clip.
+        RenderFrame();
+      }
+      return ExecuteClip(command);
+    case Command::Type::kFillPath:
+      if (!IsVisible(CalculatePixelBox(command.path->GetBounds(), 1.0, target_->GetWidth(),
+                                       target_->GetHeight()))) {
+        return true;
+      }
+      if (binned_) {
+        AddFrameCommand(command.path, command.color, 1.0);
+        return true;
+      }
+      if (!FillPaths(&command.path, 1, 1.0, command.color)) {
+        REZERO_LOG(ERROR) << "Failed to fill the path.";
+        return false;
+      }
+      return true;
+    case Command::Type::kFillRects:
+      for (const auto& rect : command.rects) {
+        FillRect(rect, command.color);
+      }
+      return true;
+    case Command::Type::kDrawDisplayList:
+      if (binned_) {
+        const DisplayList& display_list = *command.display_list;
+        for (const auto& list_command : display_list.commands_) {
+          const auto& path_entry = display_list.paths_[list_command.path_index];
+          IntRect box = CalculatePixelBox(path_entry.bounds, command.scale, target_->GetWidth(),
+                                           target_->GetHeight());
+          if (IsVisible(box)) {
+            AddFrameCommand(path_entry.path, list_command.color, command.scale);
+          }
+        }
+        return true;
+      }
+      if (!PlayDisplayList(*command.display_list, command.scale)) {
+        REZERO_LOG(ERROR) << "Failed to draw the display list.";
+        return false;
+      }
+      return true;
+    case Command::Type::kFlush: {
+      bool result = !binned_ || RenderFrame();
+      command.fence->Signal();
+      return result;
+    }
+    case Command::Type::kQuit:
+      return true;
+  }
+  return false;
+}
+
+void Canvas::RenderMain() {
+  Command command;
+  for (;;) {
+    if (!queue_.Pop(command)) {
+      render_thread_sleeping_.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_condition_.wait(lock, [this] { return !queue_.IsEmpty(); });
+      render_thread_sleeping_.store(false, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (command.type == Command::Type::kQuit) {
+      return;
+    }
+
+    Execute(command);
+    // Drops the references to the paths and the bitmap.
+    command = Command();
+  }
+}
+
+bool Canvas::PlayDisplayList(const DisplayList& display_list, double scale) {
+  std::uint32_t width = target_->GetWidth();
+  std::uint32_t height = target_->GetHeight();
+
+  struct Entry {
+    const DisplayList::Command* command;
+    IntRect box;
+  };
+
+  std::vector<Entry> entries;
+  entries.reserve(display_list.commands_.size());
+  for (const auto& command : display_list.commands_) {
+    const auto& path_entry = display_list.paths_[command.path_index];
+    IntRect box = CalculatePixelBox(path_entry.bounds, scale, width, height);
+    if (IsVisible(box)) {
+      entries.push_back({&command, box});
+    }
+  }
+
+  // Starting from the first command not drawn yet, later fills of the same
+  // color join its batch when they overlap neither the batch nor any of the
+  // commands they are moved in front of. Their order relative to everything
+  // they could interact with is kept, so the result matches plain playback.
+  std::vector<bool> drawn(entries.size(), false);
+  std::vector<const IntRect*> batch_boxes;
+  std::vector<const IntRect*> skipped_boxes;
+  bool result = true;
+
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    if (drawn[i]) {
+      continue;
+    }
+
+    const auto* command = entries[i].command;
+    batch_paths_.clear();
+    batch_paths_.push_back(display_list.paths_[command->path_index].path);
+    batch_boxes.assign(1, &entries[i].box);
+    skipped_boxes.clear();
+
+    std::size_t window_end = std::min(entries.size(), i + kBatchWindow);
+    for (std::size_t j = i + 1; j < window_end; ++j) {
+      if (drawn[j]) {
+        continue;
+      }
+
+      const Entry& candidate = entries[j];
+      auto overlaps = [&candidate](const IntRect* box) { return box->Intersects(candidate.box); };
+      if (candidate.command->color == command->color &&
+          std::none_of(batch_boxes.begin(), batch_boxes.end(), overlaps) &&
+          std::none_of(skipped_boxes.begin(), skipped_boxes.end(), overlaps)) {
+        batch_paths_.push_back(display_list.paths_[candidate.command->path_index].path);
+        batch_boxes.push_back(&candidate.box);
+        drawn[j] = true;
+      } else {
+        skipped_boxes.push_back(&candidate.box);
+      }
+    }
+
+    result &= FillPaths(batch_paths_.data(), batch_paths_.size(), scale, command->color);
+  }
+
+  batch_paths_.clear();
+  return result;
+}
+
+bool Canvas::FillPaths(const std::shared_ptr<Path>* paths, std::size_t count, double scale,
+                       std::uint32_t color) {
+  if (!BuildEdges(*edge_storage_, paths, count, scale)) {
+    return false;
+  }
+
+  AddDamage(edge_storage_->bounding_box_);
+
+  BitmapSink sink(target_.get(), color, GetClipRegion(), clip_.mask.get());
+  rasterizer_->Rasterize(*edge_storage_, sink);
 
   return true;
 }
 
+bool Canvas::BuildEdges(EdgeStorage& edge_storage, const std::shared_ptr<Path>* paths,
+                        std::size_t count, double scale) {
+  REZERO_STATS_TIMER(kEdgeBuilding);
+  REZERO_TRACE_SCOPE("BuildEdges");
+  edge_storage.Reset();
+
+  Rect clipping_box(clip_.box.min_x * kEdgeFixedScale, clip_.box.min_y * kEdgeFixedScale,
+                    clip_.box.max_x * kEdgeFixedScale, clip_.box.max_y * kEdgeFixedScale);
+  EdgeBuilder builder(&edge_storage, clipping_box, kFlattenTolerance * kEdgeFixedScale);
+  EdgeTransform transform(kEdgeFixedScale * scale);
+
+  bool result = true;
+  builder.Begin();
+  for (std::size_t i = 0; i < count; ++i) {
+    result &= builder.AddPath(paths[i], transform);
+  }
+  builder.End();
+
+  return result;
+}
+
+bool Canvas::IsVisible(const IntRect& box) const {
+  IntRect clipped = box.Intersect(GetClipPixelBox());
+  return !clipped.IsEmpty() && (!clip_region_ || clip_region_->Intersects(clipped));
+}
+
+IntRect Canvas::GetClipPixelBox() const {
+  return CalculatePixelBox(clip_.box, 1.0, target_->GetWidth(), target_->GetHeight());
+}
+
+void Canvas::ResetClip() {
+  const Rect box(0.0, 0.0, target_->GetWidth(), target_->GetHeight());
+  clip_.box = box;
+  clip_.mask = nullptr;
+}
+
+bool Canvas::ExecuteClip(Command& command) {
+  switch (command.type) {
+    case Command::Type::kRestore:
+      if (clip_stack_.empty()) {
+        REZERO_LOG(ERROR) << "Restore without a matching Save.";
+        return false;
+      }
+      clip_ = clip_stack_.back();
+      clip_stack_.pop_back();
+      return true;
+    case Command::Type::kClipRect: {
+      // Only the edge builder sees the rectangle, which costs nothing per
+      // pixel and keeps fractional borders anti-aliased.
+      const Rect rect(command.rect_min, command.rect_max);
+      const Rect box = IntersectRect(clip_.box, rect);
+      clip_.box = box;
+      return true;
+    }
+    case Command::Type::kClipPath: {
+      IntRect bounds = CalculatePixelBox(command.path->GetBounds(), 1.0, target_->GetWidth(),
+                                         target_->GetHeight()).Intersect(GetClipPixelBox());
+      if (bounds.IsEmpty()) {
+        const Rect empty_box(0.0, 0.0, 0.0, 0.0);
+        clip_.box = empty_box;
+        clip_.mask = nullptr;
+        return true;
+      }
+
+      auto mask = std::make_shared<ClipMask>();
+      mask->bounds = bounds;
+      mask->alpha = AllocatorVector<std::uint8_t>(std::size_t(bounds.GetArea()), 0,
+                                                  StdAllocator<std::uint8_t>(scratch_allocator_));
+
+      // The path is rasterized within the current clip box, so the mask
+      // already accounts for the rectangle clips.
+      if (!BuildEdges(*edge_storage_, &command.path, 1, 1.0)) {
+        REZERO_LOG(ERROR) << "Failed to clip to the path.";
+        return false;
+      }
+      MaskSink sink(mask.get(), clip_.mask.get());
+      rasterizer_->Rasterize(*edge_storage_, sink);
+
+      const Rect mask_box(bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y);
+      const Rect box = IntersectRect(clip_.box, mask_box);
+      clip_.box = box;
+      clip_.mask = std::move(mask);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void Canvas::AddDamage(const Rect& edge_bounds) {
+  if (!edge_bounds.IsValid()) {
+    return;
+  }
+
+  IntRect box = CalculatePixelBox(edge_bounds, 1.0 / kEdgeFixedScale, target_->GetWidth(),
+                                  target_->GetHeight());
+  if (!clip_region_) {
+    damage_.Add(box);
+    return;
+  }
+
+  for (const auto& rect : clip_region_->GetRects()) {
+    damage_.Add(box.Intersect(rect));
+  }
+}
+
+void Canvas::FillRect(const Rect& rect, std::uint32_t color) {
+  if (!rect.IsValid()) {
+    return;
+  }
+
+  const Rect clipped = IntersectRect(rect, clip_.box);
+  const Rect quantized(QuantizeCoordinate(clipped.min_x), QuantizeCoordinate(clipped.min_y),
+                       QuantizeCoordinate(clipped.max_x), QuantizeCoordinate(clipped.max_y));
+  if (!(quantized.min_x < quantized.max_x && quantized.min_y < quantized.max_y) ||
+      !IsVisible(CalculatePixelBox(quantized, 1.0, target_->GetWidth(), target_->GetHeight()))) {
+    return;
+  }
+
+  if (binned_) {
+    FrameCommand frame_command;
+    frame_command.rect_min = Point(quantized.min_x, quantized.min_y);
+    frame_command.rect_max = Point(quantized.max_x, quantized.max_y);
+    frame_command.color = color;
+    frame_command.band_begin = static_cast<std::uint32_t>(quantized.min_y) / kBandHeight;
+    frame_command.band_end =
+        (static_cast<std::uint32_t>(std::ceil(quantized.max_y)) + kBandHeight - 1) / kBandHeight;
+    frame_commands_.push_back(std::move(frame_command));
+    return;
+  }
+
+  const Rect fixed_bounds(quantized.min_x * kEdgeFixedScale, quantized.min_y * kEdgeFixedScale,
+                          quantized.max_x * kEdgeFixedScale, quantized.max_y * kEdgeFixedScale);
+  AddDamage(fixed_bounds);
+
+  BitmapSink sink(target_.get(), color, GetClipRegion(), clip_.mask.get());
+  sink.FillRect(quantized, 0, static_cast<std::int32_t>(target_->GetHeight()));
+}
+
+void Canvas::AddFrameCommand(const std::shared_ptr<Path>& path, std::uint32_t color, double scale) {
+  FrameCommand frame_command;
+  frame_command.path = path;
+  frame_command.color = color;
+  frame_command.scale = scale;
+  frame_commands_.push_back(std::move(frame_command));
+}
+
+bool Canvas::RenderFrame() {
+  REZERO_TRACE_SCOPE("RenderFrame");
+  std::size_t command_count = frame_commands_.size();
+
+  // Batches end after their last path; the rectangles up to the next path
+  // need no edges.
+  bool result = true;
+  std::size_t begin = 0;
+  while (begin < command_count) {
+    std::size_t end = begin;
+    std::size_t path_count = 0;
+    while (end < command_count &&
+           (path_count < kFramePathsPerBatch || !frame_commands_[end].path)) {
+      path_count += frame_commands_[end].path ? 1 : 0;
+      ++end;
+    }
+
+    result &= RenderFrameBatch(begin, end);
+    begin = end;
+  }
+
+  frame_commands_.clear();
+
+  if (!result) {
+    REZERO_LOG(ERROR) << "Failed to build the edges of the frame.";
+    return false;
+  }
+  return true;
+}
+
+bool Canvas::RenderFrameBatch(std::size_t begin, std::size_t end) {
+  frame_path_commands_.clear();
+  for (std::size_t i = begin; i < end; ++i) {
+    if (frame_commands_[i].path) {
+      auto index = static_cast<std::uint32_t>(frame_path_commands_.size());
+      frame_commands_[i].edge_storage_index = index;
+      frame_path_commands_.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+
+  std::uint32_t band_count = edge_storage_->band_count;
+  while (frame_edge_storages_.size() < frame_path_commands_.size()) {
+    frame_edge_storages_.push_back(
+        std::make_unique<EdgeStorage>(band_count, kBandHeight << kEdgeFixedShift,
+                                      scratch_allocator_));
+  }
+
+  std::atomic<bool> result{true};
+  ParallelFor(frame_path_commands_.size(), frame_thread_count_, [&](std::size_t i) {
+    REZERO_STATS_SCOPE(stats_.get());
+    FrameCommand& command = frame_commands_[frame_path_commands_[i]];
+    EdgeStorage& edge_storage = *frame_edge_storages_[i];
+    if (!BuildEdges(edge_storage, &command.path, 1, command.scale)) {
+      result.store(false, std::memory_order_relaxed);
+      return;
+    }
+    edge_storage.CalculateBandRange(command.band_begin, command.band_end);
+  });
+
+  // Bins every command into the band groups it touches, keeping submission
+  // order within each group.
+  std::uint32_t group_count = (band_count + kBandsPerGroup - 1) / kBandsPerGroup;
+  frame_group_commands_.resize(group_count);
+  for (auto& commands : frame_group_commands_) {
+    commands.clear();
+  }
+  for (std::size_t i = begin; i < end; ++i) {
+    const FrameCommand& command = frame_commands_[i];
+    if (command.band_begin == command.band_end) {
+      continue;
+    }
+
+    if (command.path) {
+      AddDamage(frame_edge_storages_[command.edge_storage_index]->bounding_box_);
+    } else {
+      const Rect fixed_bounds(command.rect_min.x * kEdgeFixedScale,
+                              command.rect_min.y * kEdgeFixedScale,
+                              command.rect_max.x * kEdgeFixedScale,
+                              command.rect_max.y * kEdgeFixedScale);
+      AddDamage(fixed_bounds);
+    }
+
+    std::uint32_t last_group = (command.band_end - 1) / kBandsPerGroup;
+    for (std::uint32_t group = command.band_begin / kBandsPerGroup; group <= last_group; ++group) {
+      frame_group_commands_[group].push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+
+  // Band groups share no pixels, so each can be rendered by a different
+  // thread without changing the painter's order inside it.
+  std::uint32_t thread_count = ResolveThreadCount(frame_thread_count_, group_count);
+  while (frame_rasterizers_.size() < thread_count) {
+    frame_rasterizers_.push_back(
+        std::make_unique<Rasterizer>(target_->GetWidth(), target_->GetHeight(), kBandHeight,
+                                     scratch_allocator_));
+  }
+
+  std::atomic<std::uint32_t> next_group{0};
+  ParallelFor(thread_count, thread_count, [&](std::size_t thread_index) {
+    REZERO_STATS_SCOPE(stats_.get());
+    Rasterizer& rasterizer = *frame_rasterizers_[thread_index];
+
+    std::uint32_t group;
+    while ((group = next_group.fetch_add(1, std::memory_order_relaxed)) < group_count) {
+      REZERO_TRACE_SCOPE("RenderBandGroup");
+      std::uint32_t group_begin = group * kBandsPerGroup;
+      std::uint32_t group_end = std::min(band_count, group_begin + kBandsPerGroup);
+
+      for (std::uint32_t i : frame_group_commands_[group]) {
+        const FrameCommand& command = frame_commands_[i];
+        BitmapSink sink(target_.get(), command.color, GetClipRegion(), clip_.mask.get());
+        if (!command.path) {
+          const Rect rect(command.rect_min, command.rect_max);
+          sink.FillRect(rect, static_cast<std::int32_t>(group_begin * kBandHeight),
+                        static_cast<std::int32_t>(group_end * kBandHeight));
+          continue;
+        }
+        rasterizer.Rasterize(*frame_edge_storages_[command.edge_storage_index], sink,
+                             std::max(group_begin, command.band_begin),
+                             std::min(group_end, command.band_end));
+      }
+    }
+  });
+
+  return result.load(std::memory_order_relaxed);
+}
+
 } // namespace rezero
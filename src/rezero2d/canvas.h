@@ -3,26 +3,256 @@
 #ifndef REZERO_CANVAS_H_
 #define REZERO_CANVAS_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rezero2d/allocator.h"
+#include "rezero2d/base/spsc_queue.h"
 #include "rezero2d/bitmap.h"
+#include "rezero2d/damage_region.h"
+#include "rezero2d/display_list.h"
+#include "rezero2d/fence.h"
 #include "rezero2d/path.h"
+#include "rezero2d/render_stats.h"
 
 namespace rezero {
 
+class EdgeStorage;
+class Rasterizer;
+class StatsCollector;
+
+enum class RenderMode {
+  // Draw calls render before they return.
+  kSync,
+  // Draw calls are queued to a rendering thread owned by the canvas. Paths
+  // and display lists must not change until the fence from Flush or End
+  // has been signaled.
+  kAsync,
+  // Draw calls are collected until Flush or End, which render the whole
+  // frame on several threads. The edges of every call are built once and
+  // binned by band, then each thread takes whole bands and runs the calls
+  // touching them in submission order.
+  kBinned,
+};
+
 class Canvas {
  public:
   Canvas();
   ~Canvas();
 
-  bool Begin(const std::shared_ptr<Bitmap>& bitmap);
+  bool Begin(const std::shared_ptr<Bitmap>& bitmap, RenderMode mode = RenderMode::kSync);
+
+  // Returns a fence signaled once the bitmap is complete and released. In
+  // kAsync mode the canvas can begin on another bitmap right away.
+  std::shared_ptr<Fence> End();
 
-  void End();
+  // Returns a fence signaled once every draw call made so far has rendered.
+  std::shared_ptr<Fence> Flush();
 
+  // In kAsync mode failures are only logged, and these return true once the
+  // call has been queued.
   bool FillPath(const std::shared_ptr<Path>& path);
 
+  // Fill axis-aligned rectangles without building edges. Pixels inside are
+  // written as solid runs, and only the border pixels get their coverage
+  // computed.
+  bool FillRect(const Rect& rect);
+  bool FillRects(const Rect* rects, std::size_t count);
+
   bool StrokePath(const std::shared_ptr<Path>& path);
 
+  // `argb` is a non-premultiplied 0xAARRGGBB color.
+  void SetFillColor(std::uint32_t argb);
+
+  // Threads used by kBinned mode from the next Begin on. 0, the default,
+  // uses the concurrency of the executor.
+  void SetThreadCount(std::uint32_t thread_count) { thread_count_ = thread_count; }
+
+  // Allocator of the scratch buffers of the sessions begun from now on, or
+  // null, the default, for the one from GetAllocator.
+  void SetAllocator(std::shared_ptr<Allocator> allocator) { allocator_ = std::move(allocator); }
+
+  // Saves the clip, which Restore brings back. Begin starts with the whole
+  // bitmap and an empty stack.
+  void Save();
+  void Restore();
+
+  // Intersects the clip with `rect`. Rectangle clips only shrink the box
+  // edges are clipped to, so they cost nothing per pixel.
+  void ClipRect(const Rect& rect);
+
+  // Intersects the clip with the coverage of `path`. This goes through an
+  // A8 mask applied while compositing, so prefer ClipRect when it will do.
+  bool ClipPath(const std::shared_ptr<Path>& path);
+
+  // Limits drawing until End to `region`, in pixels. Other pixels keep their
+  // content, and draws missing the region are skipped before their edges are
+  // built, so redrawing a whole scene only costs what the region covers.
+  void ClipToRegion(const DamageRegion& region);
+
+  // The pixels changed by the last session that has ended.
+  DamageRegion GetDamage() const;
+
+  // What the last session that has ended did. Empty unless the library is
+  // built with REZERO_ENABLE_STATS.
+  RenderStats GetStats() const;
+
+  // Captures the following draw calls into a display list instead of
+  // drawing them. The canvas must not be bound to a bitmap.
+  bool BeginRecording();
+  std::shared_ptr<DisplayList> EndRecording();
+
+  // Replays `display_list` scaled by `scale`. Commands outside the bitmap are
+  // skipped, and fills of the same color that do not overlap each other or
+  // the commands they are moved across are drawn in a single pass.
+  bool DrawDisplayList(const std::shared_ptr<const DisplayList>& display_list, double scale = 1.0);
+
  private:
+  class BitmapSink;
+  class MaskSink;
+  struct ClipMask;
+
+  struct ClipState {
+    // In pixels. Draws are clipped to it while their edges are built.
+    Rect box;
+    // The path clips so far, or null when there are none.
+    std::shared_ptr<const ClipMask> mask;
+  };
+
+  struct Command {
+    enum class Type : std::uint8_t {
+      kBegin,
+      kEnd,
+      kFillPath,
+      kFillRects,
+      kDrawDisplayList,
+      kClipToRegion,
+      kSave,
+      kRestore,
+      kClipRect,
+      kClipPath,
+      kFlush,
+      kQuit,
+    };
+
+    Type type = Type::kQuit;
+    // kBegin only.
+    RenderMode mode = RenderMode::kSync;
+    std::uint32_t thread_count = 0;
+    std::shared_ptr<Allocator> allocator;
+    // Premultiplied.
+    std::uint32_t color = 0;
+    double scale = 1.0;
+    // kClipRect only.
+    Point rect_min;
+    Point rect_max;
+    std::shared_ptr<Bitmap> bitmap;
+    std::shared_ptr<Path> path;
+    std::vector<Rect> rects;
+    std::shared_ptr<const DisplayList> display_list;
+    std::shared_ptr<const DamageRegion> region;
+    std::shared_ptr<Fence> fence;
+  };
+
+  // Executes `command` right away in kSync mode, or hands it to the
+  // rendering thread.
+  bool Submit(Command command);
+  void Enqueue(Command command);
+  bool Execute(Command& command);
+  void RenderMain();
+
+  bool PlayDisplayList(const DisplayList& display_list, double scale);
+
+  // Whether a command touching `box` can change any pixel.
+  bool IsVisible(const IntRect& box) const;
+
+  // Records the pixels a fill with edges within `edge_bounds` may change.
+  void AddDamage(const Rect& edge_bounds);
+
+  const DamageRegion* GetClipRegion() const { return clip_region_.get(); }
+
+  IntRect GetClipPixelBox() const;
+  void ResetClip();
+  bool ExecuteClip(Command& command);
+
+  void FillRect(const Rect& rect, std::uint32_t color);
+
+  void AddFrameCommand(const std::shared_ptr<Path>& path, std::uint32_t color, double scale);
+  bool RenderFrame();
+  // Renders frame commands `[begin, end)`, which hold at most
+  // kFramePathsPerBatch paths.
+  bool RenderFrameBatch(std::size_t begin, std::size_t end);
+
+  bool BuildEdges(EdgeStorage& edge_storage, const std::shared_ptr<Path>* paths,
+                  std::size_t count, double scale);
+
+  // Fills `count` paths in one pass. Pixels covered by several of them get
+  // their summed coverage, so callers only batch paths that do not overlap.
+  bool FillPaths(const std::shared_ptr<Path>* paths, std::size_t count, double scale,
+                 std::uint32_t color);
+
+  // State of the calling thread.
   std::shared_ptr<Bitmap> bitmap_ = nullptr;
+  RenderMode mode_ = RenderMode::kSync;
+  std::shared_ptr<DisplayList> recording_ = nullptr;
+  // Premultiplied.
+  std::uint32_t fill_color_ = 0xFF000000;
+  std::uint32_t thread_count_ = 0;
+  std::shared_ptr<Allocator> allocator_;
+
+  // State of whichever thread renders.
+  std::shared_ptr<Bitmap> target_ = nullptr;
+  std::shared_ptr<Allocator> scratch_allocator_;
+  std::unique_ptr<EdgeStorage> edge_storage_;
+  std::unique_ptr<Rasterizer> rasterizer_;
+  std::vector<std::shared_ptr<Path>> batch_paths_;
+  std::shared_ptr<const DamageRegion> clip_region_;
+  DamageRegion damage_;
+  ClipState clip_;
+  std::vector<ClipState> clip_stack_;
+  std::unique_ptr<StatsCollector> stats_;
+
+  // The frame collected in kBinned mode. Edge storages, one per path of a
+  // batch, and rasterizers are kept for the following batches until End.
+  struct FrameCommand {
+    // A rectangle from `rect_min` to `rect_max`, already clipped, when null.
+    std::shared_ptr<Path> path;
+    Point rect_min;
+    Point rect_max;
+    std::uint32_t color = 0;
+    double scale = 1.0;
+    std::uint32_t band_begin = 0;
+    std::uint32_t band_end = 0;
+    // The edges of a path within its batch.
+    std::uint32_t edge_storage_index = 0;
+  };
+
+  bool binned_ = false;
+  std::uint32_t frame_thread_count_ = 0;
+  std::vector<FrameCommand> frame_commands_;
+  std::vector<std::unique_ptr<EdgeStorage>> frame_edge_storages_;
+  std::vector<std::unique_ptr<Rasterizer>> frame_rasterizers_;
+  // Per batch: the indices of its paths, and of its commands in each group.
+  std::vector<std::uint32_t> frame_path_commands_;
+  std::vector<std::vector<std::uint32_t>> frame_group_commands_;
+
+  // The rendering thread, started by the first kAsync Begin. It only takes
+  // `wake_mutex_` to sleep on an empty queue.
+  std::thread render_thread_;
+  SPSCQueue<Command> queue_;
+  std::atomic<bool> render_thread_sleeping_{false};
+  std::mutex wake_mutex_;
+  std::condition_variable wake_condition_;
+
+  // Written by the rendering side at the end of each session.
+  mutable std::mutex damage_mutex_;
+  DamageRegion last_damage_;
+  RenderStats last_stats_;
 
   REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Canvas);
 };
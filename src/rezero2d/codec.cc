@@ -2,16 +2,233 @@
 
 #include "rezero2d/codec.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "rezero2d/base/file.h"
 #include "rezero2d/codec/bmp_codec.h"
+#include "rezero2d/codec/png_codec.h"
+#include "rezero2d/codec/qoi_codec.h"
 
 namespace rezero {
 
+namespace {
+
+// Small writes are gathered into a fixed buffer, large ones bypass it, so the
+// memory used for streaming stays bounded regardless of the image size.
+class BufferedFDSink {
+ public:
+  static constexpr std::size_t kBufferSize = 64 * 1024;
+
+  explicit BufferedFDSink(int fd) : fd_(fd) {}
+
+  bool Write(const void* data, std::size_t size) {
+    if (used_ + size <= kBufferSize) {
+      std::memcpy(buffer_ + used_, data, size);
+      used_ += size;
+      return true;
+    }
+
+    if (!Flush()) {
+      return false;
+    }
+
+    if (size >= kBufferSize) {
+      return WriteFully(fd_, data, size);
+    }
+
+    std::memcpy(buffer_, data, size);
+    used_ = size;
+    return true;
+  }
+
+  bool Flush() {
+    bool result = WriteFully(fd_, buffer_, used_);
+    used_ = 0;
+    return result;
+  }
+
+ private:
+  int fd_;
+  std::size_t used_ = 0;
+  char buffer_[kBufferSize];
+};
+
+// Holds one instance per codec type. Built-in codecs are created on first
+// lookup; the lock is held only to read or swap a slot.
+class CodecRegistry {
+ public:
+  static CodecRegistry& GetInstance() {
+    static CodecRegistry registry;
+    return registry;
+  }
+
+  std::shared_ptr<Codec> Get(CodecType type) {
+    if (type == CodecType::kDefault) {
+      type = CodecType::kBMP;
+    }
+
+    auto index = static_cast<std::size_t>(type);
+    if (index >= kCodecTypeCount) {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!codecs_[index]) {
+      codecs_[index] = CreateBuiltinCodec(type);
+    }
+    return codecs_[index];
+  }
+
+  void Set(CodecType type, std::shared_ptr<Codec> codec) {
+    auto index = static_cast<std::size_t>(type);
+    if (type == CodecType::kDefault || index >= kCodecTypeCount) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    codecs_[index] = std::move(codec);
+  }
+
+ private:
+  static std::shared_ptr<Codec> CreateBuiltinCodec(CodecType type) {
+    switch (type) {
+      case CodecType::kPNG:
+        return std::make_shared<PNGCodec>();
+      case CodecType::kQOI:
+        return std::make_shared<QOICodec>();
+      case CodecType::kBMP:
+      default:
+        return std::make_shared<BMPCodec>();
+    }
+  }
+
+  std::mutex mutex_;
+  std::shared_ptr<Codec> codecs_[kCodecTypeCount];
+};
+
+} // namespace
+
+PixelRows::PixelRows(const void* pixels, std::size_t row_size)
+    : pixels_(static_cast<const std::uint8_t*>(pixels)), row_size_(row_size) {}
+
+PixelRows::PixelRows(ReadProc read, std::size_t row_size)
+    : read_(std::move(read)), row_size_(row_size) {}
+
+const std::uint8_t* PixelRows::Read(std::uint32_t y, std::uint32_t count,
+                                    std::vector<std::uint8_t>& scratch) const {
+  if (pixels_) {
+    return pixels_ + std::size_t(y) * row_size_;
+  }
+
+  scratch.resize(std::size_t(count) * row_size_);
+  read_(y, count, scratch.data());
+  return scratch.data();
+}
+
 std::shared_ptr<Codec> Codec::GetCodec(CodecType type) {
-  switch (type) {
-    case CodecType::kBMP:
-    default:
-      return std::make_shared<BMPCodec>();
+  return CodecRegistry::GetInstance().Get(type);
+}
+
+std::shared_ptr<Codec> Codec::FindCodec(const Data& data, CodecType* type, bool decodable) {
+  auto& registry = CodecRegistry::GetInstance();
+
+  std::size_t size = std::min(data.GetSize(), kSniffSize);
+  for (std::size_t i = 1; i < kCodecTypeCount; ++i) {
+    auto codec_type = static_cast<CodecType>(i);
+    auto codec = registry.Get(codec_type);
+    if (codec && (!decodable || codec->CanDecodePixels()) && codec->Sniff(data.GetData(), size)) {
+      if (type) {
+        *type = codec_type;
+      }
+      return codec;
+    }
+  }
+  return nullptr;
+}
+
+void Codec::RegisterCodec(CodecType type, std::shared_ptr<Codec> codec) {
+  CodecRegistry::GetInstance().Set(type, std::move(codec));
+}
+
+bool Codec::Probe(const Data& data, CodecType& type, ImageInfo& info) {
+  auto codec = FindCodec(data, &type);
+  return codec && codec->DecodeInfo(data, info);
+}
+
+bool Codec::ProbeFile(const std::string& file_path, CodecType& type, ImageInfo& info) {
+  auto data = Data::MakeFromFileMapping(file_path, false);
+  return data && Probe(*data, type, info);
+}
+
+bool Codec::EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                         const PixelRows& pixels, const EncodeOptions& options,
+                         const EncodeSink& sink) {
+  auto file_data = EncodeToFileData(format, width, height, pixels, options);
+  if (!file_data) {
+    return false;
   }
+  return sink(file_data->GetData(), file_data->GetSize());
+}
+
+bool Codec::EncodeToFile(Format format, std::uint32_t width, std::uint32_t height,
+                         const PixelRows& pixels, const EncodeOptions& options, int fd) {
+  auto fd_sink = std::make_unique<BufferedFDSink>(fd);
+
+  auto sink = [&fd_sink](const void* chunk, std::size_t size) {
+    return fd_sink->Write(chunk, size);
+  };
+
+  if (!EncodeToSink(format, width, height, pixels, options, sink)) {
+    return false;
+  }
+  return fd_sink->Flush();
+}
+
+std::shared_ptr<Data> Codec::EncodeToGrowingData(Format format, std::uint32_t width,
+                                                std::uint32_t height, const PixelRows& pixels,
+                                                const EncodeOptions& options) {
+  auto buffer = std::make_unique<std::vector<std::uint8_t>>();
+
+  auto sink = [&buffer](const void* chunk, std::size_t size) {
+    const auto* bytes = static_cast<const std::uint8_t*>(chunk);
+    buffer->insert(buffer->end(), bytes, bytes + size);
+    return true;
+  };
+
+  if (!EncodeToSink(format, width, height, pixels, options, sink)) {
+    return nullptr;
+  }
+
+  // The Data takes over the vector instead of copying it.
+  auto result = Data::MakeWithProc(buffer->data(), buffer->size(),
+                                   [](void* /*data*/, std::size_t /*size*/, void* context) {
+                                     delete static_cast<std::vector<std::uint8_t>*>(context);
+                                   },
+                                   buffer.get());
+  buffer.release();
+  return result;
+}
+
+bool Codec::Sniff(const void* /*header*/, std::size_t /*size*/) const {
+  return false;
+}
+
+bool Codec::CanDecodePixels() const {
+  return false;
+}
+
+bool Codec::DecodeInfo(const Data& /*data*/, ImageInfo& /*info*/) {
+  return false;
+}
+
+bool Codec::DecodePixels(const Data& /*data*/, const ImageInfo& /*info*/,
+                         void* /*pixels*/, std::uint32_t /*stride*/) {
+  return false;
 }
 
 } // namespace rezero
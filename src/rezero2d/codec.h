@@ -4,27 +4,140 @@
 #define REZERO_CODEC_H_
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "rezero2d/data.h"
 #include "rezero2d/format.h"
 
 namespace rezero {
 
+// kDefault encodes as BMP. When decoding it detects the codec from the
+// leading bytes of the data.
 enum class CodecType : std::uint8_t {
   kDefault = 0,
-  kBMP = 0,
+  kBMP = 1,
+  kPNG = 2,
+  kQOI = 3,
+};
+
+static constexpr std::size_t kCodecTypeCount = 4;
+
+// Receives encoded bytes in file order. The pointer is only valid during the
+// call. Returning false aborts the encoding.
+using EncodeSink = std::function<bool(const void* data, std::size_t size)>;
+
+struct EncodeOptions {
+  // Prefer a compressed encoding when the codec offers one for the format.
+  // BMPCodec writes RLE8/RLE4 for kA8. PNGCodec always compresses; this
+  // switches it from a fixed filter and single-probe matching to adaptive
+  // filtering and chained match search.
+  bool compress = false;
+
+  // Threads for codecs that encode row ranges in parallel and join them into
+  // one file: BMP copies or run-length encodes them, PNG filters and deflates
+  // them. QOI is inherently sequential. 0 uses the hardware concurrency and 1
+  // keeps everything on the calling thread.
+  std::uint32_t thread_count = 0;
+};
+
+struct ImageInfo {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  Format format = Format::kARGB8888;
+};
+
+// The pixels an encoder reads, a range of rows at a time, so the image need
+// not sit in one buffer. Encoders that work on row ranges in parallel read
+// from several threads at once.
+class PixelRows {
+ public:
+  // Copies rows `[y, y + count)` into `dst`, packed back to back.
+  using ReadProc = std::function<void(std::uint32_t y, std::uint32_t count, std::uint8_t* dst)>;
+
+  // Rows of contiguous pixels, `row_size` bytes apart.
+  PixelRows(const void* pixels, std::size_t row_size);
+  PixelRows(ReadProc read, std::size_t row_size);
+
+  std::size_t GetRowSize() const { return row_size_; }
+
+  // Returns rows `[y, y + count)`, `GetRowSize()` bytes apart. Contiguous
+  // pixels are returned in place; others are read into `scratch`.
+  const std::uint8_t* Read(std::uint32_t y, std::uint32_t count,
+                           std::vector<std::uint8_t>& scratch) const;
+
+ private:
+  const std::uint8_t* pixels_ = nullptr;
+  ReadProc read_;
+  std::size_t row_size_;
 };
 
 class Codec {
  public:
+  // The largest prefix any built-in codec needs to recognize its data.
+  static constexpr std::size_t kSniffSize = 8;
+
+  // Returns the shared instance for `type`, created on first use. Codecs keep
+  // no per-call state, so an instance can be used from several threads.
   static std::shared_ptr<Codec> GetCodec(CodecType type);
 
+  // Returns the codec that recognizes the leading bytes of `data`, or nullptr.
+  // `type` receives its type when not null. With `decodable`, codecs that
+  // cannot decode pixels are skipped.
+  static std::shared_ptr<Codec> FindCodec(const Data& data, CodecType* type = nullptr,
+                                          bool decodable = false);
+
+  // Replaces the instance returned for `type`, such as with a platform codec.
+  static void RegisterCodec(CodecType type, std::shared_ptr<Codec> codec);
+
+  // Detects the codec and reads the image header without decoding pixels.
+  static bool Probe(const Data& data, CodecType& type, ImageInfo& info);
+
+  // Like Probe, but maps `file_path` without read-ahead so only the pages the
+  // codec looks at are read.
+  static bool ProbeFile(const std::string& file_path, CodecType& type, ImageInfo& info);
+
   Codec() = default;
   virtual ~Codec() = default;
 
   virtual std::shared_ptr<Data> EncodeToFileData(Format format, std::uint32_t width,
-                                                 std::uint32_t height, void* data) = 0;
+                                                 std::uint32_t height, const PixelRows& pixels,
+                                                 const EncodeOptions& options) = 0;
+
+  // Streams the encoded file into `sink`. The default implementation encodes
+  // into a Data first; codecs override it to avoid the whole-file buffer.
+  virtual bool EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                            const PixelRows& pixels, const EncodeOptions& options,
+                            const EncodeSink& sink);
+
+  // Streams the encoded file into `fd`, coalescing small chunks.
+  bool EncodeToFile(Format format, std::uint32_t width, std::uint32_t height,
+                    const PixelRows& pixels, const EncodeOptions& options, int fd);
+
+  // Returns true if `header`, the first `size` bytes of a file, belong to
+  // this codec. `size` may be less than kSniffSize for short files.
+  virtual bool Sniff(const void* header, std::size_t size) const;
+
+  // Whether DecodePixels is implemented. Codecs that only encode or read
+  // headers return false, and Bitmap::Decode skips them.
+  virtual bool CanDecodePixels() const;
+
+  // Reads the image header only. Returns false if `data` is not decodable by
+  // this codec.
+  virtual bool DecodeInfo(const Data& data, ImageInfo& info);
+
+  // Decodes into `pixels`, which holds `info.height` rows of `stride` bytes in
+  // `info.format`. `info` must come from DecodeInfo.
+  virtual bool DecodePixels(const Data& data, const ImageInfo& info,
+                            void* pixels, std::uint32_t stride);
+
+ protected:
+  // Runs EncodeToSink into a growing buffer, for encodings whose size is not
+  // known up front.
+  std::shared_ptr<Data> EncodeToGrowingData(Format format, std::uint32_t width, std::uint32_t height,
+                                            const PixelRows& pixels, const EncodeOptions& options);
 
  private:
   REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Codec);
@@ -2,10 +2,18 @@
 
 #include "rezero2d/codec/bmp_codec.h"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <vector>
 
 #include "rezero2d/base/api.h"
+#include "rezero2d/base/logging.h"
+#include "rezero2d/base/parallel.h"
+#include "rezero2d/codec/bmp_rle.h"
+#include "rezero2d/codec/pixel_converter.h"
 #include "rezero2d/utils/int_operations.h"
+#include "rezero2d/utils/pixel_operations.h"
 
 namespace rezero {
 
@@ -115,34 +123,352 @@ struct DIBHeader {
 
 } // namespace bmp
 
-BMPCodec::BMPCodec() = default;
+namespace {
 
-BMPCodec::~BMPCodec() = default;
+constexpr std::uint32_t kFileHeaderSize = 14;
 
-std::shared_ptr<Data> BMPCodec::EncodeToFileData(Format format, std::uint32_t width,
-                                                 std::uint32_t height, void* data) {
-  auto result = std::make_shared<Data>();
+// Writes little-endian fields that have already been swapped to file order.
+class HeaderWriter {
+ public:
+  explicit HeaderWriter(std::uint8_t* p) : p_(p) {}
+
+  template <typename T>
+  void Put(const T& value) {
+    std::memcpy(p_, &value, sizeof(T));
+    p_ += sizeof(T);
+  }
 
+ private:
+  std::uint8_t* p_;
+};
+
+std::uint64_t CalculateRowSize(std::uint32_t width, std::uint32_t bits_per_pixel) {
+  // Rows are padded to 4 bytes.
+  return ((std::uint64_t(width) * bits_per_pixel + 31) / 32) * 4;
+}
+
+// Serializes the file and V4 info headers into `out`, which must hold at
+// least `kFileHeaderSize + bmp::kHeaderSizeV4` bytes.
+void WriteHeaders(bmp::BitmapFileHeader file_header, bmp::DIBHeader dib_header, std::uint8_t* out) {
+  if (GetEndianOrder() == Endianness::kBigEndian) {
+    file_header.EndianSwap();
+    dib_header.EndianSwap();
+  }
+
+  HeaderWriter writer(out);
+
+  // File header
+  writer.Put('B');
+  writer.Put('M');
+  writer.Put(file_header.file_size);
+  writer.Put(file_header.reserved);
+  writer.Put(file_header.offset);
+
+  // DIB Header
+  writer.Put(dib_header.header_size);
+  writer.Put(dib_header.width);
+  writer.Put(dib_header.height);
+  writer.Put(dib_header.planes);
+  writer.Put(dib_header.bits_per_pixel);
+  writer.Put(dib_header.compression_method);
+  writer.Put(dib_header.image_size);
+  writer.Put(dib_header.h_resolution);
+  writer.Put(dib_header.v_resolution);
+  writer.Put(dib_header.color_palettes_count);
+  writer.Put(dib_header.important_colors_count);
+
+  writer.Put(dib_header.r_mask);
+  writer.Put(dib_header.g_mask);
+  writer.Put(dib_header.b_mask);
+  writer.Put(dib_header.a_mask);
+
+  writer.Put(dib_header.color_space);
+  writer.Put(dib_header.r);
+  writer.Put(dib_header.g);
+  writer.Put(dib_header.b);
+  writer.Put(dib_header.r_gamma);
+  writer.Put(dib_header.g_gamma);
+  writer.Put(dib_header.b_gamma);
+}
+
+class HeaderReader {
+ public:
+  HeaderReader(const std::uint8_t* p, std::size_t size) : p_(p), end_(p + size) {}
+
+  template <typename T>
+  bool Get(T& value) {
+    if (std::size_t(end_ - p_) < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, p_, sizeof(T));
+    p_ += sizeof(T);
+    return true;
+  }
+
+ private:
+  const std::uint8_t* p_;
+  const std::uint8_t* end_;
+};
+
+struct ParsedBMP {
   bmp::BitmapFileHeader file_header;
-  bmp::DIBHeader dib_header;
+  bmp::DIBHeader dib_header = {};
 
-  FormatInformation format_info(format);
+  std::uint32_t width;
+  std::uint32_t height;
+  bool top_down;
+
+  std::uint32_t masks[4];
+
+  const std::uint8_t* palette = nullptr;
+  std::uint32_t palette_count = 0;
+};
+
+bool IsSupportedHeaderSize(std::uint32_t header_size) {
+  return header_size == bmp::kHeaderSizeV1 || header_size == bmp::kHeaderSizeV2 ||
+         header_size == bmp::kHeaderSizeV3 || header_size == bmp::kHeaderSizeV4 ||
+         header_size == bmp::kHeaderSizeV5;
+}
+
+bool ParseHeaders(const std::uint8_t* p, std::size_t size, ParsedBMP& parsed) {
+  bmp::BitmapFileHeader& file_header = parsed.file_header;
+  bmp::DIBHeader& dib_header = parsed.dib_header;
+
+  if (size < kFileHeaderSize + 4 || p[0] != 'B' || p[1] != 'M') {
+    return false;
+  }
+
+  HeaderReader reader(p + 2, size - 2);
+  reader.Get(file_header.file_size);
+  reader.Get(file_header.reserved);
+  reader.Get(file_header.offset);
+  reader.Get(dib_header.header_size);
+
+  bool big_endian = GetEndianOrder() == Endianness::kBigEndian;
+  std::uint32_t header_size = big_endian ? ByteSwap(dib_header.header_size) : dib_header.header_size;
+  if (!IsSupportedHeaderSize(header_size) || size < kFileHeaderSize + header_size) {
+    return false;
+  }
+
+  reader.Get(dib_header.width);
+  reader.Get(dib_header.height);
+  reader.Get(dib_header.planes);
+  reader.Get(dib_header.bits_per_pixel);
+  reader.Get(dib_header.compression_method);
+  reader.Get(dib_header.image_size);
+  reader.Get(dib_header.h_resolution);
+  reader.Get(dib_header.v_resolution);
+  reader.Get(dib_header.color_palettes_count);
+  reader.Get(dib_header.important_colors_count);
+
+  if (header_size >= bmp::kHeaderSizeV2) {
+    reader.Get(dib_header.r_mask);
+    reader.Get(dib_header.g_mask);
+    reader.Get(dib_header.b_mask);
+  }
+  if (header_size >= bmp::kHeaderSizeV3) {
+    reader.Get(dib_header.a_mask);
+  }
+  if (header_size >= bmp::kHeaderSizeV4) {
+    reader.Get(dib_header.color_space);
+    reader.Get(dib_header.r);
+    reader.Get(dib_header.g);
+    reader.Get(dib_header.b);
+    reader.Get(dib_header.r_gamma);
+    reader.Get(dib_header.g_gamma);
+    reader.Get(dib_header.b_gamma);
+  }
+
+  std::size_t cursor = kFileHeaderSize + header_size;
+
+  // V1 headers store the bit fields right after the header.
+  std::uint32_t compression = big_endian ? ByteSwap(dib_header.compression_method)
+                                         : dib_header.compression_method;
+  if (header_size == bmp::kHeaderSizeV1 &&
+      (compression == bmp::kCompressionBitFields || compression == bmp::kCompressionAlphaBitFields)) {
+    std::uint32_t mask_count = compression == bmp::kCompressionAlphaBitFields ? 4 : 3;
+    HeaderReader mask_reader(p + cursor, size - cursor);
+    for (std::uint32_t i = 0; i < mask_count; ++i) {
+      if (!mask_reader.Get(dib_header.masks[i])) {
+        return false;
+      }
+    }
+    cursor += mask_count * 4;
+  }
+
+  if (big_endian) {
+    file_header.EndianSwap();
+    dib_header.EndianSwap();
+  }
+
+  if (dib_header.width <= 0 || dib_header.height == 0 ||
+      dib_header.height == std::numeric_limits<std::int32_t>::min()) {
+    return false;
+  }
+
+  parsed.width = static_cast<std::uint32_t>(dib_header.width);
+  parsed.top_down = dib_header.height < 0;
+
+  // Compressed bitmaps cannot be top-down.
+  if (parsed.top_down && (dib_header.compression_method == bmp::kCompressionRLE8 ||
+                          dib_header.compression_method == bmp::kCompressionRLE4)) {
+    return false;
+  }
+  parsed.height = static_cast<std::uint32_t>(parsed.top_down ? -dib_header.height : dib_header.height);
+
+  if (dib_header.bits_per_pixel <= 8) {
+    std::uint32_t count = dib_header.color_palettes_count;
+    if (count == 0 || count > (1u << dib_header.bits_per_pixel)) {
+      count = 1u << dib_header.bits_per_pixel;
+    }
+
+    // Tolerate files that declare more entries than they store.
+    std::size_t palette_end = std::min<std::size_t>(file_header.offset, size);
+    std::size_t available = palette_end > cursor ? (palette_end - cursor) / 4 : 0;
+
+    parsed.palette = p + cursor;
+    parsed.palette_count = static_cast<std::uint32_t>(std::min<std::size_t>(count, available));
+  }
+
+  return true;
+}
+
+// Resolves the channel masks for uncompressed and bit field images.
+bool ResolveMasks(ParsedBMP& parsed) {
+  const bmp::DIBHeader& dib_header = parsed.dib_header;
+
+  switch (dib_header.compression_method) {
+    case bmp::kCompressionRGB:
+      if (dib_header.bits_per_pixel == 16) {
+        parsed.masks[0] = 0x7C00;
+        parsed.masks[1] = 0x03E0;
+        parsed.masks[2] = 0x001F;
+        parsed.masks[3] = 0;
+      } else {
+        parsed.masks[0] = 0x00FF0000;
+        parsed.masks[1] = 0x0000FF00;
+        parsed.masks[2] = 0x000000FF;
+        // BI_RGB has no alpha, but writers that emit a V3+ header with an
+        // alpha mask expect it to be honored.
+        parsed.masks[3] = dib_header.bits_per_pixel == 32 && dib_header.header_size >= bmp::kHeaderSizeV3
+                              ? dib_header.a_mask : 0;
+      }
+      return true;
+
+    case bmp::kCompressionBitFields:
+    case bmp::kCompressionAlphaBitFields:
+      parsed.masks[0] = dib_header.r_mask;
+      parsed.masks[1] = dib_header.g_mask;
+      parsed.masks[2] = dib_header.b_mask;
+      parsed.masks[3] = (dib_header.header_size >= bmp::kHeaderSizeV3 ||
+                         dib_header.compression_method == bmp::kCompressionAlphaBitFields)
+                            ? dib_header.a_mask : 0;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+std::uint32_t GetPaletteCount(Format format) {
+  return format == Format::kA8 ? 256 : 0;
+}
+
+bool IsRunLengthEncoded(Format format, const EncodeOptions& options) {
+  return options.compress && format == Format::kA8;
+}
+
+bool IsRunLength(std::uint32_t compression) {
+  return compression == bmp::kCompressionRLE8 || compression == bmp::kCompressionRLE4;
+}
+
+bool IsGrayPalette(const ParsedBMP& parsed) {
+  if (!parsed.palette_count) {
+    return false;
+  }
+
+  for (std::uint32_t i = 0; i < parsed.palette_count; ++i) {
+    const std::uint8_t* entry = parsed.palette + i * 4;
+    if (entry[0] != entry[1] || entry[1] != entry[2]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Pixels a run-length encoded image may have at most. End-of-line markers
+// and deltas let a short stream cover any number of pixels, so the stream
+// size bounds nothing, and DecodeRLE rejects streams that end early.
+constexpr std::uint64_t kMaxRunLengthPixels = std::uint64_t(1) << 28;
+
+// Whether the file holds the pixels its headers describe, and a kARGB8888
+// row of them fits a 32-bit stride. Checked before the caller allocates a
+// bitmap of the size the headers claim.
+bool CheckImageSize(const ParsedBMP& parsed, std::size_t size) {
+  if (std::uint64_t(parsed.width) * 4 > std::numeric_limits<std::uint32_t>::max() ||
+      parsed.file_header.offset > size) {
+    return false;
+  }
+
+  std::size_t src_size = size - parsed.file_header.offset;
+  if (IsRunLength(parsed.dib_header.compression_method)) {
+    return std::uint64_t(parsed.width) * parsed.height <= kMaxRunLengthPixels;
+  }
+
+  std::uint64_t row_size = CalculateRowSize(parsed.width, parsed.dib_header.bits_per_pixel);
+  return row_size && src_size / row_size >= parsed.height;
+}
+
+// Copies a row of `format` pixels into the file, which stores straight alpha.
+void WriteRow(Format format, std::uint8_t* dst, const std::uint8_t* src, std::uint32_t width) {
+  if (format == Format::kARGB8888) {
+    UnpremultiplyRow(dst, src, width);
+  } else {
+    std::memcpy(dst, src, width);
+  }
+}
+
+// Rows per chunk when rows are encoded in parallel, about 1 MiB of input.
+std::uint32_t CalculateChunkRows(std::uint64_t row_size) {
+  static constexpr std::uint64_t kChunkSize = 1 << 20;
+  return static_cast<std::uint32_t>(
+      std::max<std::uint64_t>(1, kChunkSize / std::max<std::uint64_t>(1, row_size)));
+}
+
+// Writes the file header, the V4 info header and, for palettized formats,
+// the gray palette. Everything after it is the pixel array.
+bool WriteHeaderAndPalette(const FormatInformation& format_info, std::uint32_t width,
+                           std::uint32_t height, std::uint32_t bits_per_pixel,
+                           std::uint32_t palette_count, std::uint32_t compression,
+                           std::uint64_t image_size, const EncodeSink& sink) {
+  std::uint32_t offset = kFileHeaderSize + bmp::kHeaderSizeV4 + palette_count * 4;
+  if (image_size > std::numeric_limits<std::uint32_t>::max() - offset) {
+    REZERO_LOG(ERROR) << "The image is too large for a BMP file.";
+    return false;
+  }
+
+  bmp::BitmapFileHeader file_header;
+  bmp::DIBHeader dib_header;
 
   dib_header.header_size = bmp::kHeaderSizeV4;
   dib_header.width = width;
   dib_header.height = height;
-  dib_header.bits_per_pixel = format_info.GetBytesPerPixel() * 8;
-  dib_header.compression_method = bmp::kCompressionRGB;
-  dib_header.image_size = width * height * format_info.GetBytesPerPixel();
+  dib_header.bits_per_pixel = bits_per_pixel;
+  dib_header.compression_method = compression;
+  dib_header.image_size = static_cast<std::uint32_t>(image_size);
   dib_header.h_resolution = 0;
   dib_header.v_resolution = 0;
-  dib_header.color_palettes_count = 0;
+  dib_header.color_palettes_count = palette_count;
   dib_header.important_colors_count = 0;
 
-  dib_header.r_mask = (format_info.HasRChannel() ? 0xFF : 0) << format_info.GetRShift();
-  dib_header.g_mask = (format_info.HasGChannel() ? 0xFF : 0) << format_info.GetGShift();
-  dib_header.b_mask = (format_info.HasBChannel() ? 0xFF : 0) << format_info.GetBShift();
-  dib_header.a_mask = (format_info.HasAChannel() ? 0xFF : 0) << format_info.GetAShift();
+  if (palette_count) {
+    dib_header.r_mask = dib_header.g_mask = dib_header.b_mask = dib_header.a_mask = 0;
+  } else {
+    dib_header.r_mask = (format_info.HasRChannel() ? 0xFF : 0) << format_info.GetRShift();
+    dib_header.g_mask = (format_info.HasGChannel() ? 0xFF : 0) << format_info.GetGShift();
+    dib_header.b_mask = (format_info.HasBChannel() ? 0xFF : 0) << format_info.GetBShift();
+    dib_header.a_mask = (format_info.HasAChannel() ? 0xFF : 0) << format_info.GetAShift();
+  }
 
   dib_header.color_space = 0x57696E20; // 'Win '
   dib_header.r = { 0, 0, 0 };
@@ -152,60 +478,286 @@ std::shared_ptr<Data> BMPCodec::EncodeToFileData(Format format, std::uint32_t wi
   dib_header.g_gamma = 0;
   dib_header.b_gamma = 0;
 
-  file_header.offset = 14 + bmp::kHeaderSizeV4;
+  file_header.offset = offset;
   file_header.file_size = file_header.offset + dib_header.image_size;
 
-  if (GetEndianOrder() == Endianness::kBigEndian) {
-    file_header.EndianSwap();
-    dib_header.EndianSwap();
+  std::uint8_t headers[kFileHeaderSize + bmp::kHeaderSizeV4];
+  WriteHeaders(file_header, dib_header, headers);
+
+  if (!sink(headers, sizeof(headers))) {
+    return false;
   }
 
-  result->Init(file_header.file_size, nullptr);
+  if (palette_count) {
+    // kA8 is stored as gray levels.
+    std::uint8_t palette[256 * 4];
+    std::uint32_t step = 255 / (palette_count - 1);
+    for (std::uint32_t i = 0; i < palette_count; ++i) {
+      auto level = static_cast<std::uint8_t>(i * step);
+      palette[i * 4 + 0] = palette[i * 4 + 1] = palette[i * 4 + 2] = level;
+      palette[i * 4 + 3] = 0;
+    }
+
+    return sink(palette, palette_count * 4);
+  }
 
-  auto* p = static_cast<char*>(result->GetData());
+  return true;
+}
 
-  // File header
-  *p = 'B'; ++p;
-  *p = 'M'; ++p;
-  std::memcpy(p, &file_header.file_size, 4); p += 4;
-  p += 4; // Reserved
-  std::memcpy(p, &file_header.offset, 4); p += 4;
+} // namespace
 
-  // DIB Header
-  std::memcpy(p, &dib_header.header_size, 4); p += 4;
-  std::memcpy(p, &dib_header.width, 4), p += 4;
-  std::memcpy(p, &dib_header.height, 4); p += 4;
-  std::memcpy(p, &dib_header.planes, 2); p += 2;
-  std::memcpy(p, &dib_header.bits_per_pixel, 2); p += 2;
-  std::memcpy(p, &dib_header.compression_method, 4); p += 4;
-  std::memcpy(p, &dib_header.image_size, 4); p += 4;
-  std::memcpy(p, &dib_header.h_resolution, 4); p += 4;
-  std::memcpy(p, &dib_header.v_resolution, 4); p += 4;
-  std::memcpy(p, &dib_header.color_palettes_count, 4); p += 4;
-  std::memcpy(p, &dib_header.important_colors_count, 4); p += 4;
-
-  std::memcpy(p, &dib_header.r_mask, 4); p += 4;
-  std::memcpy(p, &dib_header.g_mask, 4); p += 4;
-  std::memcpy(p, &dib_header.b_mask, 4); p += 4;
-  std::memcpy(p, &dib_header.a_mask, 4); p += 4;
-
-  std::memcpy(p, &dib_header.color_space, 4); p += 4;
-  std::memcpy(p, &dib_header.r.x, 4); p += 4;
-  std::memcpy(p, &dib_header.r.y, 4); p += 4;
-  std::memcpy(p, &dib_header.r.z, 4); p += 4;
-  std::memcpy(p, &dib_header.g.x, 4); p += 4;
-  std::memcpy(p, &dib_header.g.y, 4); p += 4;
-  std::memcpy(p, &dib_header.g.z, 4); p += 4;
-  std::memcpy(p, &dib_header.b.x, 4); p += 4;
-  std::memcpy(p, &dib_header.b.y, 4); p += 4;
-  std::memcpy(p, &dib_header.b.z, 4); p += 4;
-  std::memcpy(p, &dib_header.r_gamma, 4); p += 4;
-  std::memcpy(p, &dib_header.g_gamma, 4); p += 4;
-  std::memcpy(p, &dib_header.b_gamma, 4); p += 4;
-
-  std::memcpy(p, data, width * height * format_info.GetBytesPerPixel());
+BMPCodec::BMPCodec() = default;
+
+BMPCodec::~BMPCodec() = default;
+
+std::shared_ptr<Data> BMPCodec::EncodeToFileData(Format format, std::uint32_t width,
+                                                 std::uint32_t height, const PixelRows& pixels,
+                                                 const EncodeOptions& options) {
+  // The size of a run-length encoded file is only known after encoding.
+  if (IsRunLengthEncoded(format, options)) {
+    return EncodeToGrowingData(format, width, height, pixels, options);
+  }
+
+  FormatInformation format_info(format);
+
+  std::uint32_t bits_per_pixel = format_info.GetBytesPerPixel() * 8;
+  std::uint32_t src_stride = width * format_info.GetBytesPerPixel();
+  std::uint64_t row_size = CalculateRowSize(width, bits_per_pixel);
+  std::uint32_t palette_count = GetPaletteCount(format);
+  std::uint32_t compression = palette_count ? bmp::kCompressionRGB : bmp::kCompressionBitFields;
+
+  std::size_t header_size = kFileHeaderSize + bmp::kHeaderSizeV4 + palette_count * 4;
+  auto result = Data::MakeUninitialized(header_size + std::size_t(row_size) * height);
+  auto* p = static_cast<std::uint8_t*>(result->GetData());
+
+  auto sink = [&p](const void* chunk, std::size_t size) {
+    std::memcpy(p, chunk, size);
+    p += size;
+    return true;
+  };
+
+  if (!WriteHeaderAndPalette(format_info, width, height, bits_per_pixel, palette_count,
+                             compression, row_size * height, sink)) {
+    return nullptr;
+  }
+
+  // Rows land at fixed offsets, so chunks of them are copied in parallel.
+  // File rows `[begin_row, end_row)` are the bottom-up image rows
+  // `[height - end_row, height - begin_row)`.
+  std::uint32_t chunk_rows = CalculateChunkRows(row_size);
+  ParallelForRange(height, chunk_rows, options.thread_count, [&](std::size_t begin_row,
+                                                                std::size_t end_row) {
+    std::vector<std::uint8_t> scratch;
+    auto count = static_cast<std::uint32_t>(end_row - begin_row);
+    const std::uint8_t* rows = pixels.Read(height - static_cast<std::uint32_t>(end_row), count,
+                                           scratch);
+
+    for (std::size_t y = begin_row; y < end_row; ++y) {
+      std::uint8_t* dst = p + std::size_t(y) * row_size;
+      WriteRow(format, dst, rows + (end_row - 1 - y) * src_stride, width);
+      std::memset(dst + src_stride, 0, row_size - src_stride);
+    }
+  });
 
   return result;
 }
 
+bool BMPCodec::EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                            const PixelRows& pixels, const EncodeOptions& options,
+                            const EncodeSink& sink) {
+  FormatInformation format_info(format);
+
+  std::uint32_t bits_per_pixel = format_info.GetBytesPerPixel() * 8;
+  std::uint32_t src_stride = width * format_info.GetBytesPerPixel();
+  std::uint64_t row_size = CalculateRowSize(width, bits_per_pixel);
+  std::uint32_t palette_count = GetPaletteCount(format);
+
+  std::uint32_t compression = palette_count ? bmp::kCompressionRGB : bmp::kCompressionBitFields;
+  std::uint64_t image_size = row_size * height;
+  std::uint32_t chunk_rows = CalculateChunkRows(src_stride);
+  std::vector<std::uint8_t> scratch;
+
+  // Each chunk of rows is run-length encoded on its own and the results are
+  // written back to back.
+  std::vector<std::vector<std::uint8_t>> encoded;
+  if (IsRunLengthEncoded(format, options)) {
+    bool sixteen_levels = true;
+    for (std::uint32_t y = 0; y < height && sixteen_levels; y += chunk_rows) {
+      std::uint32_t count = std::min(chunk_rows, height - y);
+      sixteen_levels = bmp::HasSixteenLevels(pixels.Read(y, count, scratch), width, count,
+                                             src_stride);
+    }
+
+    if (sixteen_levels) {
+      bits_per_pixel = 4;
+      palette_count = 16;
+      compression = bmp::kCompressionRLE4;
+    } else {
+      compression = bmp::kCompressionRLE8;
+    }
+
+    encoded.resize((height + chunk_rows - 1) / chunk_rows);
+
+    // File rows `[begin_row, end_row)` are encoded from the image rows that
+    // hold them.
+    ParallelFor(encoded.size(), options.thread_count, [&](std::size_t i) {
+      auto begin_row = static_cast<std::uint32_t>(i * chunk_rows);
+      std::uint32_t end_row = std::min(height, begin_row + chunk_rows);
+      std::uint32_t count = end_row - begin_row;
+
+      std::vector<std::uint8_t> chunk_scratch;
+      const std::uint8_t* rows = pixels.Read(height - end_row, count, chunk_scratch);
+      if (sixteen_levels) {
+        bmp::EncodeRLE4(rows, width, height, src_stride, begin_row, end_row, encoded[i]);
+      } else {
+        bmp::EncodeRLE8(rows, width, height, src_stride, begin_row, end_row, encoded[i]);
+      }
+    });
+
+    image_size = 0;
+    for (const auto& chunk : encoded) {
+      image_size += chunk.size();
+    }
+  }
+
+  if (!WriteHeaderAndPalette(format_info, width, height, bits_per_pixel, palette_count,
+                             compression, image_size, sink)) {
+    return false;
+  }
+
+  if (!encoded.empty()) {
+    for (const auto& chunk : encoded) {
+      if (!sink(chunk.data(), chunk.size())) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // A positive height means the rows are stored bottom-up.
+  static constexpr std::uint8_t kPadding[4] = {0, 0, 0, 0};
+  auto padding = static_cast<std::uint32_t>(row_size - src_stride);
+  std::vector<std::uint8_t> converted(src_stride);
+
+  for (std::uint32_t end_row = height; end_row > 0;) {
+    std::uint32_t begin_row = end_row > chunk_rows ? end_row - chunk_rows : 0;
+    const std::uint8_t* rows = pixels.Read(begin_row, end_row - begin_row, scratch);
+
+    for (std::uint32_t y = end_row; y-- > begin_row;) {
+      WriteRow(format, converted.data(), rows + std::size_t(y - begin_row) * src_stride, width);
+      if (!sink(converted.data(), src_stride)) {
+        return false;
+      }
+      if (padding && !sink(kPadding, padding)) {
+        return false;
+      }
+    }
+
+    end_row = begin_row;
+  }
+
+  return true;
+}
+
+bool BMPCodec::Sniff(const void* header, std::size_t size) const {
+  const auto* p = static_cast<const std::uint8_t*>(header);
+  return size >= 2 && p[0] == 'B' && p[1] == 'M';
+}
+
+bool BMPCodec::CanDecodePixels() const {
+  return true;
+}
+
+bool BMPCodec::DecodeInfo(const Data& data, ImageInfo& info) {
+  ParsedBMP parsed;
+  if (!ParseHeaders(static_cast<const std::uint8_t*>(data.GetData()), data.GetSize(), parsed) ||
+      !CheckImageSize(parsed, data.GetSize())) {
+    return false;
+  }
+
+  info.width = parsed.width;
+  info.height = parsed.height;
+  // Gray palettes also come from grayscale and black and white images, so
+  // they decode to kARGB8888 unless the caller asks for kA8.
+  info.format = Format::kARGB8888;
+  return true;
+}
+
+bool BMPCodec::DecodePixels(const Data& data, const ImageInfo& info,
+                            void* pixels, std::uint32_t stride) {
+  const auto* p = static_cast<const std::uint8_t*>(data.GetData());
+
+  ParsedBMP parsed;
+  if (!ParseHeaders(p, data.GetSize(), parsed) || info.width != parsed.width ||
+      info.height != parsed.height) {
+    return false;
+  }
+
+  const bmp::DIBHeader& dib_header = parsed.dib_header;
+
+  if (info.format == Format::kA8 && !IsGrayPalette(parsed)) {
+    return false;
+  }
+
+  if (!CheckImageSize(parsed, data.GetSize())) {
+    return false;
+  }
+
+  const std::uint8_t* src = p + parsed.file_header.offset;
+  std::size_t src_size = data.GetSize() - parsed.file_header.offset;
+  auto* dst = static_cast<std::uint8_t*>(pixels);
+
+  PixelConverter converter;
+
+  if (IsRunLength(dib_header.compression_method)) {
+    std::uint32_t expected_bits = dib_header.compression_method == bmp::kCompressionRLE8 ? 8 : 4;
+    if (dib_header.bits_per_pixel != expected_bits) {
+      return false;
+    }
+
+    // Indices are expanded to one byte each, then mapped through the palette.
+    std::vector<std::uint8_t> indices(std::size_t(parsed.width) * parsed.height, 0);
+    if (!bmp::DecodeRLE(src, src_size, expected_bits, parsed.width, parsed.height,
+                        indices.data(), parsed.width) ||
+        !converter.InitFromPalette(8, parsed.palette, parsed.palette_count, info.format)) {
+      return false;
+    }
+
+    for (std::uint32_t y = 0; y < parsed.height; ++y) {
+      converter.ConvertRow(dst + std::size_t(y) * stride,
+                           indices.data() + std::size_t(y) * parsed.width, parsed.width);
+    }
+    return true;
+  }
+
+  if (dib_header.bits_per_pixel <= 8) {
+    if (dib_header.compression_method != bmp::kCompressionRGB ||
+        !converter.InitFromPalette(dib_header.bits_per_pixel, parsed.palette, parsed.palette_count,
+                                   info.format)) {
+      return false;
+    }
+  } else {
+    if (info.format != Format::kARGB8888 || !ResolveMasks(parsed) ||
+        !converter.InitFromMasks(dib_header.bits_per_pixel, parsed.masks)) {
+      return false;
+    }
+  }
+
+  std::uint64_t row_size = CalculateRowSize(parsed.width, dib_header.bits_per_pixel);
+
+  // Palette entries are opaque, so only images with an alpha mask need
+  // premultiplying.
+  bool premultiply = dib_header.bits_per_pixel > 8 && parsed.masks[3];
+  for (std::uint32_t y = 0; y < parsed.height; ++y) {
+    std::uint32_t src_y = parsed.top_down ? y : parsed.height - 1 - y;
+    std::uint8_t* dst_row = dst + std::size_t(y) * stride;
+    converter.ConvertRow(dst_row, src + std::size_t(src_y) * row_size, parsed.width);
+    if (premultiply) {
+      PremultiplyRow(dst_row, dst_row, parsed.width);
+    }
+  }
+
+  return true;
+}
+
 } // namespace rezero
@@ -13,7 +13,23 @@ class BMPCodec : public Codec {
   ~BMPCodec() override;
 
   std::shared_ptr<Data> EncodeToFileData(Format format, std::uint32_t width,
-                                         std::uint32_t height, void* data) override;
+                                         std::uint32_t height, const PixelRows& pixels,
+                                         const EncodeOptions& options) override;
+
+  bool EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                    const PixelRows& pixels, const EncodeOptions& options,
+                    const EncodeSink& sink) override;
+
+  bool Sniff(const void* header, std::size_t size) const override;
+
+  bool CanDecodePixels() const override;
+
+  bool DecodeInfo(const Data& data, ImageInfo& info) override;
+
+  // Images with a gray palette, such as the ones written for kA8, may also be
+  // decoded to kA8 by setting `info.format` after DecodeInfo.
+  bool DecodePixels(const Data& data, const ImageInfo& info,
+                    void* pixels, std::uint32_t stride) override;
 };
 
 } // namespace rezero
@@ -0,0 +1,250 @@
+// Created by DONG Zhong on 2024/03/22.
+
+#include "rezero2d/codec/bmp_rle.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rezero {
+
+namespace bmp {
+
+namespace {
+
+constexpr std::uint64_t kLowBits = 0x0101010101010101ull;
+constexpr std::uint64_t kHighBits = 0x8080808080808080ull;
+
+constexpr std::uint32_t kMaxCount = 255;
+
+// Loads 8 bytes so that the first byte in memory is the least significant.
+std::uint64_t LoadLE64(const std::uint8_t* p) {
+  std::uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  return value;
+}
+
+std::uint32_t FirstSetByte(std::uint64_t value) {
+  return static_cast<std::uint32_t>(__builtin_ctzll(value)) >> 3;
+}
+
+// Returns the number of leading bytes equal to `p[0]`, at most `limit`.
+// Compares a word at a time.
+std::uint32_t ScanRun(const std::uint8_t* p, std::uint32_t limit) {
+  std::uint64_t pattern = kLowBits * p[0];
+
+  std::uint32_t n = 0;
+  for (; n + 8 <= limit; n += 8) {
+    std::uint64_t diff = LoadLE64(p + n) ^ pattern;
+    if (diff) {
+      return n + FirstSetByte(diff);
+    }
+  }
+
+  while (n < limit && p[n] == p[0]) {
+    ++n;
+  }
+  return n;
+}
+
+// Returns the offset of the first run of three equal bytes, or `limit` if
+// there is none. Tests eight positions per step: a zero byte in
+// `(w0 ^ w1) | (w1 ^ w2)` marks the start of such a run.
+std::uint32_t ScanLiteral(const std::uint8_t* p, std::uint32_t limit) {
+  std::uint32_t n = 0;
+  for (; n + 10 <= limit; n += 8) {
+    std::uint64_t w0 = LoadLE64(p + n);
+    std::uint64_t w1 = LoadLE64(p + n + 1);
+    std::uint64_t w2 = LoadLE64(p + n + 2);
+
+    std::uint64_t x = (w0 ^ w1) | (w1 ^ w2);
+    // Only bytes above a real zero byte can be falsely flagged, so the lowest
+    // flag is exact.
+    std::uint64_t zero = (x - kLowBits) & ~x & kHighBits;
+    if (zero) {
+      return n + FirstSetByte(zero);
+    }
+  }
+
+  for (; n + 2 < limit; ++n) {
+    if (p[n] == p[n + 1] && p[n + 1] == p[n + 2]) {
+      return n;
+    }
+  }
+  return limit;
+}
+
+template <std::uint32_t kBitsPerPixel>
+void EncodeRow(const std::uint8_t* row, std::uint32_t width, std::vector<std::uint8_t>& out) {
+  std::uint32_t x = 0;
+
+  while (x < width) {
+    std::uint32_t remaining = width - x;
+    std::uint32_t run = ScanRun(row + x, std::min(remaining, kMaxCount));
+    std::uint32_t literal = run >= 3 ? 0 : std::min(ScanLiteral(row + x, remaining), kMaxCount);
+
+    // Encoded mode.
+    if (literal < 3) {
+      out.push_back(static_cast<std::uint8_t>(run));
+      out.push_back(kBitsPerPixel == 8 ? row[x] : static_cast<std::uint8_t>(row[x] * 0x11));
+      x += run;
+      continue;
+    }
+
+    // Absolute mode, padded to a 16-bit boundary.
+    out.push_back(0);
+    out.push_back(static_cast<std::uint8_t>(literal));
+
+    std::uint32_t byte_count;
+    if (kBitsPerPixel == 8) {
+      out.insert(out.end(), row + x, row + x + literal);
+      byte_count = literal;
+    } else {
+      byte_count = (literal + 1) / 2;
+      for (std::uint32_t i = 0; i < literal; i += 2) {
+        std::uint8_t low = i + 1 < literal ? row[x + i + 1] : 0;
+        out.push_back(static_cast<std::uint8_t>((row[x + i] << 4) | low));
+      }
+    }
+    if (byte_count & 1) {
+      out.push_back(0);
+    }
+
+    x += literal;
+  }
+}
+
+void EncodeEndOfLine(std::uint32_t y, std::uint32_t height, std::vector<std::uint8_t>& out) {
+  out.push_back(0);
+  // The last line ends the bitmap instead.
+  out.push_back(y + 1 == height ? 1 : 0);
+}
+
+} // namespace
+
+bool HasSixteenLevels(const std::uint8_t* pixels, std::uint32_t width,
+                      std::uint32_t height, std::uint32_t stride) {
+  for (std::uint32_t y = 0; y < height; ++y) {
+    const std::uint8_t* row = pixels + std::size_t(y) * stride;
+    for (std::uint32_t x = 0; x < width; ++x) {
+      if (row[x] % 0x11) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void EncodeRLE8(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height,
+                std::uint32_t stride, std::uint32_t begin_row, std::uint32_t end_row,
+                std::vector<std::uint8_t>& out) {
+  for (std::uint32_t y = begin_row; y < end_row; ++y) {
+    EncodeRow<8>(pixels + std::size_t(end_row - 1 - y) * stride, width, out);
+    EncodeEndOfLine(y, height, out);
+  }
+}
+
+void EncodeRLE4(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height,
+                std::uint32_t stride, std::uint32_t begin_row, std::uint32_t end_row,
+                std::vector<std::uint8_t>& out) {
+  std::vector<std::uint8_t> indices(width);
+
+  for (std::uint32_t y = begin_row; y < end_row; ++y) {
+    const std::uint8_t* row = pixels + std::size_t(end_row - 1 - y) * stride;
+    for (std::uint32_t x = 0; x < width; ++x) {
+      indices[x] = row[x] / 0x11;
+    }
+
+    EncodeRow<4>(indices.data(), width, out);
+    EncodeEndOfLine(y, height, out);
+  }
+}
+
+bool DecodeRLE(const std::uint8_t* src, std::size_t size, std::uint32_t bits_per_pixel,
+               std::uint32_t width, std::uint32_t height, std::uint8_t* indices, std::uint32_t stride) {
+  const std::uint8_t* end = src + size;
+
+  std::uint32_t x = 0;
+  std::uint32_t y = 0;
+
+  auto row_at = [&](std::uint32_t line) {
+    return indices + std::size_t(height - 1 - line) * stride;
+  };
+
+  while (end - src >= 2 && y < height) {
+    std::uint32_t count = src[0];
+    std::uint8_t value = src[1];
+    src += 2;
+
+    if (count) {
+      std::uint8_t* row = row_at(y);
+      std::uint32_t n = std::min(count, width > x ? width - x : 0);
+      if (bits_per_pixel == 8) {
+        std::memset(row + x, value, n);
+      } else {
+        for (std::uint32_t i = 0; i < n; ++i) {
+          row[x + i] = (i & 1) ? (value & 0x0F) : (value >> 4);
+        }
+      }
+      x += count;
+      continue;
+    }
+
+    switch (value) {
+      case 0:
+        // End of line.
+        x = 0;
+        ++y;
+        break;
+
+      case 1:
+        // End of bitmap.
+        return true;
+
+      case 2:
+        // Delta.
+        if (end - src < 2) {
+          return false;
+        }
+        x += src[0];
+        y += src[1];
+        src += 2;
+        break;
+
+      default: {
+        // Absolute mode.
+        std::uint32_t literal = value;
+        std::uint32_t byte_count = bits_per_pixel == 8 ? literal : (literal + 1) / 2;
+        std::uint32_t padded = (byte_count + 1) & ~1u;
+        if (std::size_t(end - src) < byte_count) {
+          return false;
+        }
+
+        std::uint8_t* row = row_at(y);
+        std::uint32_t n = std::min(literal, width > x ? width - x : 0);
+        if (bits_per_pixel == 8) {
+          std::memcpy(row + x, src, n);
+        } else {
+          for (std::uint32_t i = 0; i < n; ++i) {
+            std::uint8_t byte = src[i >> 1];
+            row[x + i] = (i & 1) ? (byte & 0x0F) : (byte >> 4);
+          }
+        }
+
+        x += literal;
+        src += std::min<std::size_t>(padded, end - src);
+        break;
+      }
+    }
+  }
+
+  // Without an end-of-bitmap marker, the stream must have reached the end of
+  // the last row. Anything shorter was truncated.
+  return y >= height || (y == height - 1 && x >= width);
+}
+
+} // namespace bmp
+
+} // namespace rezero
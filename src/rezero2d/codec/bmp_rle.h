@@ -0,0 +1,45 @@
+// Created by DONG Zhong on 2024/03/22.
+
+#ifndef REZERO_CODEC_BMP_RLE_H_
+#define REZERO_CODEC_BMP_RLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rezero {
+
+namespace bmp {
+
+// Returns true if every byte is one of the 16 levels `0x00, 0x11, ..., 0xFF`,
+// which RLE4 with a 16 entry gray palette stores losslessly.
+bool HasSixteenLevels(const std::uint8_t* pixels, std::uint32_t width,
+                      std::uint32_t height, std::uint32_t stride);
+
+// Appends the RLE8 stream of 8-bit indices for file rows `[begin_row,
+// end_row)` of an image `height` rows tall. File rows are stored bottom-up,
+// so `pixels` holds image rows `[height - end_row, height - begin_row)`, top
+// row first. Every row ends on its own marker, and only the last row of the
+// image ends the bitmap, so ranges encoded separately concatenate into the
+// stream of the whole image.
+void EncodeRLE8(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height,
+                std::uint32_t stride, std::uint32_t begin_row, std::uint32_t end_row,
+                std::vector<std::uint8_t>& out);
+
+// Same as EncodeRLE8, but each byte is first divided by 17 to get a 4-bit
+// index. Requires HasSixteenLevels.
+void EncodeRLE4(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height,
+                std::uint32_t stride, std::uint32_t begin_row, std::uint32_t end_row,
+                std::vector<std::uint8_t>& out);
+
+// Decodes an RLE8 or RLE4 stream into one index per byte, top-down. Pixels
+// skipped by deltas or early end-of-line markers are left untouched. Returns
+// false for streams that end before an end-of-bitmap marker or the last row.
+bool DecodeRLE(const std::uint8_t* src, std::size_t size, std::uint32_t bits_per_pixel,
+               std::uint32_t width, std::uint32_t height, std::uint8_t* indices, std::uint32_t stride);
+
+} // namespace bmp
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_BMP_RLE_H_
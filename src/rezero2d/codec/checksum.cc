@@ -0,0 +1,115 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#include "rezero2d/codec/checksum.h"
+
+#include <cstring>
+
+namespace rezero {
+
+namespace {
+
+constexpr std::uint32_t kCrcPolynomial = 0xEDB88320u;
+constexpr std::uint32_t kAdlerBase = 65521;
+// Largest n such that 255 * n * (n + 1) / 2 + (n + 1) * (kAdlerBase - 1) fits 32 bits.
+constexpr std::size_t kAdlerMaxRun = 5552;
+
+// Slice-by-8 tables: table[k][b] is the CRC of byte `b` followed by k zeros.
+struct CrcTables {
+  CrcTables() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (kCrcPolynomial & (0u - (crc & 1)));
+      }
+      table[0][i] = crc;
+    }
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+      }
+    }
+  }
+
+  std::uint32_t table[8][256];
+};
+
+const CrcTables& GetCrcTables() {
+  static const CrcTables tables;
+  return tables;
+}
+
+} // namespace
+
+std::uint32_t Crc32(std::uint32_t crc, const void* data, std::size_t size) {
+  const auto& table = GetCrcTables().table;
+  const auto* p = static_cast<const std::uint8_t*>(data);
+
+  crc = ~crc;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (size >= 8) {
+    std::uint32_t low;
+    std::uint32_t high;
+    std::memcpy(&low, p, 4);
+    std::memcpy(&high, p + 4, 4);
+    low ^= crc;
+
+    crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^
+          table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+          table[3][high & 0xFF] ^ table[2][(high >> 8) & 0xFF] ^
+          table[1][(high >> 16) & 0xFF] ^ table[0][high >> 24];
+
+    p += 8;
+    size -= 8;
+  }
+#endif
+
+  while (size--) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];
+  }
+
+  return ~crc;
+}
+
+std::uint32_t Adler32(std::uint32_t adler, const void* data, std::size_t size) {
+  const auto* p = static_cast<const std::uint8_t*>(data);
+
+  std::uint32_t a = adler & 0xFFFF;
+  std::uint32_t b = adler >> 16;
+
+  while (size > 0) {
+    std::size_t run = size < kAdlerMaxRun ? size : kAdlerMaxRun;
+    size -= run;
+
+    while (run--) {
+      a += *p++;
+      b += a;
+    }
+
+    a %= kAdlerBase;
+    b %= kAdlerBase;
+  }
+
+  return (b << 16) | a;
+}
+
+std::uint32_t Adler32Combine(std::uint32_t adler1, std::uint32_t adler2, std::size_t size2) {
+  std::uint32_t remainder = static_cast<std::uint32_t>(size2 % kAdlerBase);
+
+  std::uint32_t a1 = adler1 & 0xFFFF;
+  std::uint32_t b1 = adler1 >> 16;
+  std::uint32_t a2 = adler2 & 0xFFFF;
+  std::uint32_t b2 = adler2 >> 16;
+
+  // a = a1 + a2 - 1, b = b1 + b2 + remainder * (a1 - 1), all modulo the base.
+  std::uint32_t a = a1 + a2 + kAdlerBase - 1;
+  std::uint32_t b = static_cast<std::uint32_t>((std::uint64_t(remainder) * a1) % kAdlerBase);
+  b += b1 + b2 + kAdlerBase - remainder;
+
+  a %= kAdlerBase;
+  b %= kAdlerBase;
+
+  return (b << 16) | a;
+}
+
+} // namespace rezero
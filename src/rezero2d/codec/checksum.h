@@ -0,0 +1,23 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#ifndef REZERO_CODEC_CHECKSUM_H_
+#define REZERO_CODEC_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rezero {
+
+// CRC-32 as used by PNG and gzip. Pass 0 to start a new checksum.
+std::uint32_t Crc32(std::uint32_t crc, const void* data, std::size_t size);
+
+// Adler-32 as used by zlib. Pass 1 to start a new checksum.
+std::uint32_t Adler32(std::uint32_t adler, const void* data, std::size_t size);
+
+// Returns the Adler-32 of the concatenation of two buffers, given the
+// checksum of each and the length of the second.
+std::uint32_t Adler32Combine(std::uint32_t adler1, std::uint32_t adler2, std::size_t size2);
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_CHECKSUM_H_
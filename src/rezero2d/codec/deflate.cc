@@ -0,0 +1,616 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#include "rezero2d/codec/deflate.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rezero {
+
+namespace {
+
+constexpr std::uint32_t kWindowSize = 32768;
+constexpr std::uint32_t kWindowMask = kWindowSize - 1;
+constexpr std::uint32_t kHashBits = 15;
+constexpr std::uint32_t kHashSize = 1u << kHashBits;
+
+constexpr std::uint32_t kMinMatch = 3;
+constexpr std::uint32_t kMaxMatch = 258;
+constexpr std::uint32_t kMaxChain = 32;
+
+constexpr std::size_t kMaxBlockTokens = 1u << 15;
+constexpr std::size_t kMaxStoredBlockSize = 65535;
+
+constexpr std::uint32_t kLitLenCodeCount = 286;
+constexpr std::uint32_t kDistCodeCount = 30;
+constexpr std::uint32_t kCodeLengthCodeCount = 19;
+constexpr std::uint32_t kEndOfBlock = 256;
+
+constexpr std::uint32_t kMaxCodeLength = 15;
+constexpr std::uint32_t kMaxCodeLengthCodeLength = 7;
+
+constexpr std::uint16_t kLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::uint8_t kLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+constexpr std::uint16_t kDistBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::uint8_t kDistExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+constexpr std::uint8_t kCodeLengthOrder[kCodeLengthCodeCount] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+struct HuffmanTable {
+  // Codes are stored bit-reversed, ready to be written LSB first.
+  std::uint16_t codes[288];
+  std::uint8_t lengths[288];
+};
+
+std::uint32_t ReverseBits(std::uint32_t code, std::uint32_t length) {
+  std::uint32_t result = 0;
+  for (std::uint32_t i = 0; i < length; ++i) {
+    result = (result << 1) | (code & 1);
+    code >>= 1;
+  }
+  return result;
+}
+
+// Assigns canonical codes from code lengths (RFC 1951, 3.2.2).
+void AssignCodes(HuffmanTable& table, std::uint32_t count) {
+  std::uint32_t length_count[kMaxCodeLength + 1] = {};
+  for (std::uint32_t i = 0; i < count; ++i) {
+    ++length_count[table.lengths[i]];
+  }
+  length_count[0] = 0;
+
+  std::uint32_t next_code[kMaxCodeLength + 1] = {};
+  std::uint32_t code = 0;
+  for (std::uint32_t bits = 1; bits <= kMaxCodeLength; ++bits) {
+    code = (code + length_count[bits - 1]) << 1;
+    next_code[bits] = code;
+  }
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::uint32_t length = table.lengths[i];
+    table.codes[i] = length ? static_cast<std::uint16_t>(ReverseBits(next_code[length]++, length)) : 0;
+  }
+}
+
+struct StaticTables {
+  StaticTables() {
+    for (std::uint32_t code = 0; code < 29; ++code) {
+      std::uint32_t end = code == 28 ? kMaxMatch + 1 : kLengthBase[code + 1];
+      for (std::uint32_t length = kLengthBase[code]; length < end; ++length) {
+        length_code[length] = static_cast<std::uint8_t>(code);
+      }
+    }
+    // 258 has its own code, even though 227 + 31 could also express it.
+    length_code[kMaxMatch] = 28;
+
+    for (std::uint32_t code = 0; code < 30; ++code) {
+      std::uint32_t end = code == 29 ? kWindowSize + 1 : kDistBase[code + 1];
+      for (std::uint32_t dist = kDistBase[code]; dist < end; ++dist) {
+        if (dist <= 256) {
+          dist_code_small[dist - 1] = static_cast<std::uint8_t>(code);
+        } else {
+          dist_code_large[(dist - 1) >> 7] = static_cast<std::uint8_t>(code);
+        }
+      }
+    }
+
+    for (std::uint32_t i = 0; i < 288; ++i) {
+      fixed_lit.lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+    }
+    AssignCodes(fixed_lit, 288);
+
+    for (std::uint32_t i = 0; i < kDistCodeCount; ++i) {
+      fixed_dist.lengths[i] = 5;
+    }
+    AssignCodes(fixed_dist, kDistCodeCount);
+  }
+
+  std::uint32_t DistCode(std::uint32_t dist) const {
+    return dist <= 256 ? dist_code_small[dist - 1] : dist_code_large[(dist - 1) >> 7];
+  }
+
+  std::uint8_t length_code[kMaxMatch + 1];
+  std::uint8_t dist_code_small[256];
+  std::uint8_t dist_code_large[256];
+
+  HuffmanTable fixed_lit;
+  HuffmanTable fixed_dist;
+};
+
+const StaticTables& GetStaticTables() {
+  static const StaticTables tables;
+  return tables;
+}
+
+// Moffat and Katajainen's in-place computation of minimum-redundancy code
+// lengths. `a` holds ascending frequencies and receives the code lengths.
+void CalculateMinimumRedundancy(std::int32_t* a, std::int32_t n) {
+  if (n == 0) {
+    return;
+  }
+  if (n == 1) {
+    a[0] = 1;
+    return;
+  }
+
+  a[0] += a[1];
+  std::int32_t root = 0;
+  std::int32_t leaf = 2;
+  for (std::int32_t next = 1; next < n - 1; ++next) {
+    if (leaf >= n || a[root] < a[leaf]) {
+      a[next] = a[root];
+      a[root++] = next;
+    } else {
+      a[next] = a[leaf++];
+    }
+
+    if (leaf >= n || (root < next && a[root] < a[leaf])) {
+      a[next] += a[root];
+      a[root++] = next;
+    } else {
+      a[next] += a[leaf++];
+    }
+  }
+
+  a[n - 2] = 0;
+  for (std::int32_t next = n - 3; next >= 0; --next) {
+    a[next] = a[a[next]] + 1;
+  }
+
+  std::int32_t available = 1;
+  std::int32_t used = 0;
+  std::int32_t depth = 0;
+  root = n - 2;
+  std::int32_t next = n - 1;
+  while (available > 0) {
+    while (root >= 0 && a[root] == depth) {
+      ++used;
+      --root;
+    }
+    while (available > used) {
+      a[next--] = depth;
+      --available;
+    }
+    available = 2 * used;
+    ++depth;
+    used = 0;
+  }
+}
+
+// Builds length-limited code lengths for `count` symbols.
+void BuildLengths(const std::uint32_t* freqs, std::uint32_t count, std::uint32_t limit,
+                  std::uint8_t* lengths) {
+  struct Symbol {
+    std::uint32_t freq;
+    std::uint32_t index;
+  };
+
+  Symbol symbols[288];
+  std::uint32_t used = 0;
+  for (std::uint32_t i = 0; i < count; ++i) {
+    lengths[i] = 0;
+    if (freqs[i]) {
+      symbols[used++] = {freqs[i], i};
+    }
+  }
+
+  // Keep every code complete: a lone symbol gets a sibling.
+  if (used == 0) {
+    return;
+  }
+  if (used == 1) {
+    lengths[symbols[0].index] = 1;
+    lengths[symbols[0].index == 0 ? 1 : 0] = 1;
+    return;
+  }
+
+  std::sort(symbols, symbols + used, [](const Symbol& a, const Symbol& b) {
+    return a.freq < b.freq || (a.freq == b.freq && a.index < b.index);
+  });
+
+  std::int32_t depths[288];
+  for (std::uint32_t i = 0; i < used; ++i) {
+    depths[i] = static_cast<std::int32_t>(symbols[i].freq);
+  }
+  CalculateMinimumRedundancy(depths, static_cast<std::int32_t>(used));
+
+  std::uint32_t length_count[33] = {};
+  for (std::uint32_t i = 0; i < used; ++i) {
+    ++length_count[depths[i]];
+  }
+
+  // Fold overlong codes into the limit, then rebalance the Kraft sum.
+  for (std::uint32_t i = limit + 1; i <= 32; ++i) {
+    length_count[limit] += length_count[i];
+    length_count[i] = 0;
+  }
+  std::uint32_t total = 0;
+  for (std::uint32_t i = limit; i > 0; --i) {
+    total += length_count[i] << (limit - i);
+  }
+  while (total != (1u << limit)) {
+    --length_count[limit];
+    for (std::uint32_t i = limit - 1; i > 0; --i) {
+      if (length_count[i]) {
+        --length_count[i];
+        length_count[i + 1] += 2;
+        break;
+      }
+    }
+    --total;
+  }
+
+  // The most frequent symbols get the shortest codes.
+  std::uint32_t j = used;
+  for (std::uint32_t length = 1; length <= limit; ++length) {
+    for (std::uint32_t n = length_count[length]; n > 0; --n) {
+      lengths[symbols[--j].index] = static_cast<std::uint8_t>(length);
+    }
+  }
+}
+
+std::uint32_t MatchLength(const std::uint8_t* a, const std::uint8_t* b, std::uint32_t max) {
+  std::uint32_t n = 0;
+  while (n + 8 <= max) {
+    std::uint64_t x;
+    std::uint64_t y;
+    std::memcpy(&x, a + n, 8);
+    std::memcpy(&y, b + n, 8);
+    std::uint64_t diff = x ^ y;
+    if (diff) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      return n + (static_cast<std::uint32_t>(__builtin_clzll(diff)) >> 3);
+#else
+      return n + (static_cast<std::uint32_t>(__builtin_ctzll(diff)) >> 3);
+#endif
+    }
+    n += 8;
+  }
+  while (n < max && a[n] == b[n]) {
+    ++n;
+  }
+  return n;
+}
+
+std::uint32_t Hash3(const std::uint8_t* p) {
+  std::uint32_t value = std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16);
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+} // namespace
+
+class Deflater::BitWriter {
+ public:
+  explicit BitWriter(std::vector<std::uint8_t>& out) : out_(out) {}
+
+  void Write(std::uint32_t bits, std::uint32_t count) {
+    bits_ |= std::uint64_t(bits) << count_;
+    count_ += count;
+    if (count_ >= 32) {
+      std::uint8_t bytes[4] = {
+          static_cast<std::uint8_t>(bits_), static_cast<std::uint8_t>(bits_ >> 8),
+          static_cast<std::uint8_t>(bits_ >> 16), static_cast<std::uint8_t>(bits_ >> 24)};
+      out_.insert(out_.end(), bytes, bytes + 4);
+      bits_ >>= 32;
+      count_ -= 32;
+    }
+  }
+
+  // Pads with zero bits up to the next byte boundary and flushes.
+  void AlignToByte() {
+    while (count_ > 0) {
+      out_.push_back(static_cast<std::uint8_t>(bits_));
+      bits_ >>= 8;
+      count_ = count_ > 8 ? count_ - 8 : 0;
+    }
+    bits_ = 0;
+  }
+
+  void WriteBytes(const std::uint8_t* data, std::size_t size) {
+    out_.insert(out_.end(), data, data + size);
+  }
+
+ private:
+  std::vector<std::uint8_t>& out_;
+  std::uint64_t bits_ = 0;
+  std::uint32_t count_ = 0;
+};
+
+Deflater::Deflater(Level level) : level_(level) {
+  if (level_ != Level::kStore) {
+    head_ = std::make_unique<std::int32_t[]>(kHashSize);
+    prev_ = std::make_unique<std::int32_t[]>(kWindowSize);
+    tokens_.reserve(kMaxBlockTokens);
+  }
+}
+
+Deflater::~Deflater() = default;
+
+void Deflater::Compress(const std::uint8_t* data, std::size_t size, bool final,
+                        std::vector<std::uint8_t>& out) {
+  BitWriter writer(out);
+
+  if (level_ == Level::kStore || size == 0) {
+    tokens_.clear();
+    WriteBlock(writer, data, size, final);
+  } else {
+    std::fill(head_.get(), head_.get() + kHashSize, -1);
+
+    std::size_t position = 0;
+    while (position < size) {
+      std::size_t block_start = position;
+      tokens_.clear();
+      FindTokens(data, size, position);
+      WriteBlock(writer, data + block_start, position - block_start, final && position == size);
+    }
+  }
+
+  if (!final) {
+    // An empty stored block ends byte-aligned.
+    writer.Write(0, 3);
+    writer.AlignToByte();
+    static constexpr std::uint8_t kEmptyStored[4] = {0x00, 0x00, 0xFF, 0xFF};
+    writer.WriteBytes(kEmptyStored, sizeof(kEmptyStored));
+  }
+
+  writer.AlignToByte();
+}
+
+void Deflater::FindTokens(const std::uint8_t* data, std::size_t size, std::size_t& position) {
+  std::int32_t* head = head_.get();
+  std::int32_t* prev = prev_.get();
+
+  std::uint32_t max_chain = level_ == Level::kFast ? 1 : kMaxChain;
+  bool insert_all = level_ != Level::kFast;
+
+  std::size_t pos = position;
+  while (pos < size && tokens_.size() < kMaxBlockTokens) {
+    std::uint32_t best_length = 0;
+    std::uint32_t best_distance = 0;
+
+    if (pos + kMinMatch <= size) {
+      std::uint32_t hash = Hash3(data + pos);
+      std::int32_t candidate = head[hash];
+      prev[pos & kWindowMask] = candidate;
+      head[hash] = static_cast<std::int32_t>(pos);
+
+      std::uint32_t max_length = static_cast<std::uint32_t>(std::min<std::size_t>(kMaxMatch, size - pos));
+      std::uint32_t chain = max_chain;
+
+      while (candidate >= 0 && pos - candidate <= kWindowSize && chain--) {
+        std::uint32_t length = MatchLength(data + candidate, data + pos, max_length);
+        if (length > best_length) {
+          best_length = length;
+          best_distance = static_cast<std::uint32_t>(pos - candidate);
+          if (length == max_length) {
+            break;
+          }
+        }
+
+        // Slots are reused once the window wraps; stop at the first one that
+        // does not point further back.
+        std::int32_t next = prev[candidate & kWindowMask];
+        if (next >= candidate) {
+          break;
+        }
+        candidate = next;
+      }
+    }
+
+    if (best_length >= kMinMatch) {
+      tokens_.push_back({static_cast<std::uint16_t>(best_length), static_cast<std::uint16_t>(best_distance)});
+
+      if (insert_all) {
+        std::size_t end = std::min(pos + best_length, size >= kMinMatch ? size - kMinMatch + 1 : 0);
+        for (std::size_t i = pos + 1; i < end; ++i) {
+          std::uint32_t hash = Hash3(data + i);
+          prev[i & kWindowMask] = head[hash];
+          head[hash] = static_cast<std::int32_t>(i);
+        }
+      }
+      pos += best_length;
+    } else {
+      tokens_.push_back({data[pos], 0});
+      ++pos;
+    }
+  }
+
+  position = pos;
+}
+
+void Deflater::WriteBlock(BitWriter& writer, const std::uint8_t* data, std::size_t size, bool final) {
+  const StaticTables& tables = GetStaticTables();
+
+  // Statistics.
+  std::uint32_t lit_freqs[kLitLenCodeCount] = {};
+  std::uint32_t dist_freqs[kDistCodeCount] = {};
+  std::uint64_t extra_bits = 0;
+
+  for (const Token& token : tokens_) {
+    if (token.distance == 0) {
+      ++lit_freqs[token.value];
+    } else {
+      std::uint32_t length_code = tables.length_code[token.value];
+      std::uint32_t dist_code = tables.DistCode(token.distance);
+      ++lit_freqs[257 + length_code];
+      ++dist_freqs[dist_code];
+      extra_bits += kLengthExtra[length_code] + kDistExtra[dist_code];
+    }
+  }
+  lit_freqs[kEndOfBlock] = 1;
+
+  // Dynamic code lengths.
+  HuffmanTable lit_table;
+  HuffmanTable dist_table;
+  BuildLengths(lit_freqs, kLitLenCodeCount, kMaxCodeLength, lit_table.lengths);
+  BuildLengths(dist_freqs, kDistCodeCount, kMaxCodeLength, dist_table.lengths);
+  if (!tokens_.empty() && std::all_of(dist_table.lengths, dist_table.lengths + kDistCodeCount,
+                                      [](std::uint8_t length) { return length == 0; })) {
+    // At least one distance code must be defined.
+    dist_table.lengths[0] = dist_table.lengths[1] = 1;
+  }
+
+  std::uint32_t lit_count = kLitLenCodeCount;
+  while (lit_count > 257 && lit_table.lengths[lit_count - 1] == 0) {
+    --lit_count;
+  }
+  std::uint32_t dist_count = kDistCodeCount;
+  while (dist_count > 1 && dist_table.lengths[dist_count - 1] == 0) {
+    --dist_count;
+  }
+
+  // Run-length encode the code lengths with symbols 16, 17 and 18.
+  std::uint8_t all_lengths[kLitLenCodeCount + kDistCodeCount];
+  std::memcpy(all_lengths, lit_table.lengths, lit_count);
+  std::memcpy(all_lengths + lit_count, dist_table.lengths, dist_count);
+  std::uint32_t total = lit_count + dist_count;
+
+  struct CodeLengthSymbol {
+    std::uint8_t symbol;
+    std::uint8_t extra;
+  };
+  CodeLengthSymbol cl_symbols[kLitLenCodeCount + kDistCodeCount];
+  std::uint32_t cl_symbol_count = 0;
+  std::uint32_t cl_freqs[kCodeLengthCodeCount] = {};
+
+  auto emit = [&](std::uint8_t symbol, std::uint8_t extra) {
+    cl_symbols[cl_symbol_count++] = {symbol, extra};
+    ++cl_freqs[symbol];
+  };
+
+  for (std::uint32_t i = 0; i < total;) {
+    std::uint8_t length = all_lengths[i];
+    std::uint32_t run = 1;
+    while (i + run < total && all_lengths[i + run] == length) {
+      ++run;
+    }
+    i += run;
+
+    if (length == 0) {
+      while (run >= 11) {
+        std::uint32_t n = std::min<std::uint32_t>(run, 138);
+        emit(18, static_cast<std::uint8_t>(n - 11));
+        run -= n;
+      }
+      if (run >= 3) {
+        emit(17, static_cast<std::uint8_t>(run - 3));
+        run = 0;
+      }
+    } else {
+      emit(length, 0);
+      --run;
+      while (run >= 3) {
+        std::uint32_t n = std::min<std::uint32_t>(run, 6);
+        emit(16, static_cast<std::uint8_t>(n - 3));
+        run -= n;
+      }
+    }
+    while (run--) {
+      emit(length, 0);
+    }
+  }
+
+  HuffmanTable cl_table;
+  BuildLengths(cl_freqs, kCodeLengthCodeCount, kMaxCodeLengthCodeLength, cl_table.lengths);
+
+  std::uint32_t cl_count = kCodeLengthCodeCount;
+  while (cl_count > 4 && cl_table.lengths[kCodeLengthOrder[cl_count - 1]] == 0) {
+    --cl_count;
+  }
+
+  // Pick the cheapest block type.
+  std::uint64_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * cl_count + extra_bits;
+  std::uint64_t fixed_bits = 3 + extra_bits;
+  for (std::uint32_t i = 0; i < kCodeLengthCodeCount; ++i) {
+    dynamic_bits += std::uint64_t(cl_freqs[i]) * cl_table.lengths[i];
+  }
+  dynamic_bits += cl_freqs[16] * 2 + cl_freqs[17] * 3 + cl_freqs[18] * 7;
+  for (std::uint32_t i = 0; i < kLitLenCodeCount; ++i) {
+    dynamic_bits += std::uint64_t(lit_freqs[i]) * lit_table.lengths[i];
+    fixed_bits += std::uint64_t(lit_freqs[i]) * tables.fixed_lit.lengths[i];
+  }
+  for (std::uint32_t i = 0; i < kDistCodeCount; ++i) {
+    dynamic_bits += std::uint64_t(dist_freqs[i]) * dist_table.lengths[i];
+    fixed_bits += std::uint64_t(dist_freqs[i]) * tables.fixed_dist.lengths[i];
+  }
+
+  std::size_t stored_blocks = std::max<std::size_t>(1, (size + kMaxStoredBlockSize - 1) / kMaxStoredBlockSize);
+  std::uint64_t stored_bits = std::uint64_t(size) * 8 + stored_blocks * (3 + 7 + 32);
+
+  if (tokens_.empty() || (stored_bits <= dynamic_bits && stored_bits <= fixed_bits)) {
+    std::size_t offset = 0;
+    do {
+      std::size_t length = std::min(size - offset, kMaxStoredBlockSize);
+      bool last = offset + length == size;
+      writer.Write(final && last ? 1 : 0, 3);
+      writer.AlignToByte();
+      std::uint8_t header[4] = {
+          static_cast<std::uint8_t>(length), static_cast<std::uint8_t>(length >> 8),
+          static_cast<std::uint8_t>(~length), static_cast<std::uint8_t>(~length >> 8)};
+      writer.WriteBytes(header, sizeof(header));
+      writer.WriteBytes(data + offset, length);
+      offset += length;
+    } while (offset < size);
+    return;
+  }
+
+  const HuffmanTable* lit = &tables.fixed_lit;
+  const HuffmanTable* dist = &tables.fixed_dist;
+
+  if (dynamic_bits < fixed_bits) {
+    AssignCodes(lit_table, kLitLenCodeCount);
+    AssignCodes(dist_table, kDistCodeCount);
+    AssignCodes(cl_table, kCodeLengthCodeCount);
+
+    writer.Write((final ? 1 : 0) | (2 << 1), 3);
+    writer.Write(lit_count - 257, 5);
+    writer.Write(dist_count - 1, 5);
+    writer.Write(cl_count - 4, 4);
+    for (std::uint32_t i = 0; i < cl_count; ++i) {
+      writer.Write(cl_table.lengths[kCodeLengthOrder[i]], 3);
+    }
+
+    static constexpr std::uint8_t kRepeatBits[3] = {2, 3, 7};
+    for (std::uint32_t i = 0; i < cl_symbol_count; ++i) {
+      std::uint8_t symbol = cl_symbols[i].symbol;
+      writer.Write(cl_table.codes[symbol], cl_table.lengths[symbol]);
+      if (symbol >= 16) {
+        writer.Write(cl_symbols[i].extra, kRepeatBits[symbol - 16]);
+      }
+    }
+
+    lit = &lit_table;
+    dist = &dist_table;
+  } else {
+    writer.Write((final ? 1 : 0) | (1 << 1), 3);
+  }
+
+  for (const Token& token : tokens_) {
+    if (token.distance == 0) {
+      writer.Write(lit->codes[token.value], lit->lengths[token.value]);
+      continue;
+    }
+
+    std::uint32_t length_code = tables.length_code[token.value];
+    writer.Write(lit->codes[257 + length_code], lit->lengths[257 + length_code]);
+    writer.Write(token.value - kLengthBase[length_code], kLengthExtra[length_code]);
+
+    std::uint32_t dist_code = tables.DistCode(token.distance);
+    writer.Write(dist->codes[dist_code], dist->lengths[dist_code]);
+    writer.Write(token.distance - kDistBase[dist_code], kDistExtra[dist_code]);
+  }
+
+  writer.Write(lit->codes[kEndOfBlock], lit->lengths[kEndOfBlock]);
+}
+
+} // namespace rezero
@@ -0,0 +1,64 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#ifndef REZERO_CODEC_DEFLATE_H_
+#define REZERO_CODEC_DEFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "rezero2d/base/macros.h"
+
+namespace rezero {
+
+// A raw deflate (RFC 1951) compressor tuned for speed. Every call to
+// Compress is independent, with no match window shared across calls, so
+// separately compressed chunks can be produced in parallel and concatenated.
+class Deflater {
+ public:
+  enum class Level : std::uint8_t {
+    // Stored blocks only.
+    kStore = 0,
+    // Single hash probe per position.
+    kFast = 1,
+    // Bounded hash chains.
+    kDefault = 2,
+  };
+
+  explicit Deflater(Level level);
+  ~Deflater();
+
+  // Appends the compressed form of `data` to `out`. With `final` unset the
+  // output ends with an empty stored block, leaving the stream byte-aligned
+  // so that another chunk can follow directly.
+  void Compress(const std::uint8_t* data, std::size_t size, bool final, std::vector<std::uint8_t>& out);
+
+  // The two bytes that terminate a stream of non-final chunks.
+  static constexpr std::uint8_t kFinalEmptyBlock[2] = {0x03, 0x00};
+
+ private:
+  class BitWriter;
+
+  struct Token {
+    // A literal byte when `distance` is 0, otherwise the match length.
+    std::uint16_t value;
+    std::uint16_t distance;
+  };
+
+  void FindTokens(const std::uint8_t* data, std::size_t size, std::size_t& position);
+
+  void WriteBlock(BitWriter& writer, const std::uint8_t* data, std::size_t size, bool final);
+
+  Level level_;
+
+  std::unique_ptr<std::int32_t[]> head_;
+  std::unique_ptr<std::int32_t[]> prev_;
+  std::vector<Token> tokens_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Deflater);
+};
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_DEFLATE_H_
@@ -0,0 +1,266 @@
+// Created by DONG Zhong on 2024/03/20.
+
+#include "rezero2d/codec/pixel_converter.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "rezero2d/base/api.h"
+
+namespace rezero {
+
+namespace {
+
+std::uint32_t CountTrailingZeros(std::uint32_t value) {
+  return static_cast<std::uint32_t>(__builtin_ctz(value));
+}
+
+std::uint32_t CountBits(std::uint32_t value) {
+  return static_cast<std::uint32_t>(__builtin_popcount(value));
+}
+
+bool IsContiguous(std::uint32_t mask) {
+  std::uint32_t value = mask >> CountTrailingZeros(mask);
+  return (value & (value + 1)) == 0;
+}
+
+// Returns the index of the byte selected by `mask`, or -1 when the mask is
+// not exactly one byte wide.
+int GetByteIndex(std::uint32_t mask, std::uint32_t bytes_per_pixel) {
+  for (std::uint32_t i = 0; i < bytes_per_pixel; ++i) {
+    if (mask == (0xFFu << (i * 8))) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+} // namespace
+
+PixelConverter::PixelConverter() = default;
+
+PixelConverter::~PixelConverter() = default;
+
+bool PixelConverter::InitFromMasks(std::uint32_t bits_per_pixel, const std::uint32_t masks[4]) {
+  if (bits_per_pixel != 16 && bits_per_pixel != 24 && bits_per_pixel != 32) {
+    return false;
+  }
+
+  bits_per_pixel_ = bits_per_pixel;
+  bytes_per_pixel_ = bits_per_pixel / 8;
+
+  std::uint32_t pixel_mask = bits_per_pixel == 32 ? 0xFFFFFFFFu : ((1u << bits_per_pixel) - 1);
+
+  bool byte_aligned = bits_per_pixel != 16;
+  fill_mask_ = 0;
+
+  for (std::uint32_t i = 0; i < 4; ++i) {
+    std::uint32_t mask = masks[i] & pixel_mask;
+    Channel& channel = channels_[i];
+
+    if (!mask) {
+      channel = {0, 0, 0};
+      if (i == 3) {
+        fill_mask_ = 0xFF000000u;
+      }
+      continue;
+    }
+
+    if (!IsContiguous(mask)) {
+      return false;
+    }
+
+    std::uint32_t shift = CountTrailingZeros(mask);
+    std::uint32_t bits = CountBits(mask);
+
+    // Keep the products below 32 bits by dropping excess low bits.
+    if (bits > 16) {
+      shift += bits - 16;
+      bits = 16;
+    }
+
+    std::uint32_t max = (1u << bits) - 1;
+    channel.mask = max;
+    channel.shift = shift;
+    channel.scale = (255u * 65536u + max - 1) / max;
+
+    if (GetByteIndex(mask, bytes_per_pixel_) < 0) {
+      byte_aligned = false;
+    }
+  }
+
+  if (byte_aligned) {
+    // Destination byte order in memory is B, G, R, A.
+    static constexpr std::uint32_t kDstChannel[4] = {2, 1, 0, 3};
+
+    for (std::uint32_t pixel = 0; pixel < 4; ++pixel) {
+      for (std::uint32_t byte = 0; byte < 4; ++byte) {
+        std::uint32_t mask = masks[kDstChannel[byte]] & pixel_mask;
+        std::uint8_t index = 0x80;
+        if (mask) {
+          index = static_cast<std::uint8_t>(pixel * bytes_per_pixel_ + GetByteIndex(mask, bytes_per_pixel_));
+        }
+        shuffle_[pixel * 4 + byte] = index;
+      }
+    }
+
+    convert_func_ = ConvertShuffle;
+#if defined(__x86_64__) || defined(__i386__)
+    if (HasCpuFeature(CpuFeature::kSSSE3)) {
+      convert_func_ = bytes_per_pixel_ == 4 ? ConvertShuffle32SSSE3 : ConvertShuffle24SSSE3;
+    }
+#endif
+  } else {
+    convert_func_ = ConvertMasked;
+  }
+
+  return true;
+}
+
+bool PixelConverter::InitFromPalette(std::uint32_t bits_per_pixel, const std::uint8_t* palette,
+                                     std::uint32_t count, Format dst_format) {
+  if (bits_per_pixel != 1 && bits_per_pixel != 4 && bits_per_pixel != 8) {
+    return false;
+  }
+
+  bits_per_pixel_ = bits_per_pixel;
+  bytes_per_pixel_ = 0;
+
+  if (count > 256) {
+    count = 256;
+  }
+
+  for (std::uint32_t i = 0; i < 256; ++i) {
+    palette_[i] = 0xFF000000u;
+  }
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const std::uint8_t* entry = palette + i * 4;
+    palette_[i] = 0xFF000000u | (std::uint32_t(entry[2]) << 16) |
+                  (std::uint32_t(entry[1]) << 8) | std::uint32_t(entry[0]);
+  }
+
+  convert_func_ = dst_format == Format::kA8 ? ConvertIndexedA8 : ConvertIndexed;
+  return true;
+}
+
+void PixelConverter::ConvertMasked(const PixelConverter& self, void* dst_pixels,
+                                   const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint32_t*>(dst_pixels);
+  static constexpr std::uint32_t kDstShift[4] = {16, 8, 0, 24};
+
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t pixel = 0;
+    std::memcpy(&pixel, src, self.bytes_per_pixel_);
+    src += self.bytes_per_pixel_;
+
+    std::uint32_t result = self.fill_mask_;
+    for (std::uint32_t i = 0; i < 4; ++i) {
+      const Channel& channel = self.channels_[i];
+      std::uint32_t value = (pixel >> channel.shift) & channel.mask;
+      result |= ((value * channel.scale) >> 16) << kDstShift[i];
+    }
+    dst[x] = result;
+  }
+}
+
+void PixelConverter::ConvertShuffle(const PixelConverter& self, void* dst_pixels,
+                                    const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint32_t*>(dst_pixels);
+  const std::uint8_t* shuffle = self.shuffle_;
+
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t result = self.fill_mask_;
+    for (std::uint32_t byte = 0; byte < 4; ++byte) {
+      if (shuffle[byte] != 0x80) {
+        result |= std::uint32_t(src[shuffle[byte]]) << (byte * 8);
+      }
+    }
+    dst[x] = result;
+    src += self.bytes_per_pixel_;
+  }
+}
+
+void PixelConverter::ConvertIndexed(const PixelConverter& self, void* dst_pixels,
+                                    const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint32_t*>(dst_pixels);
+  switch (self.bits_per_pixel_) {
+    case 8:
+      for (std::uint32_t x = 0; x < width; ++x) {
+        dst[x] = self.palette_[src[x]];
+      }
+      break;
+    case 4:
+      for (std::uint32_t x = 0; x < width; ++x) {
+        std::uint8_t byte = src[x >> 1];
+        dst[x] = self.palette_[(x & 1) ? (byte & 0x0F) : (byte >> 4)];
+      }
+      break;
+    default:
+      for (std::uint32_t x = 0; x < width; ++x) {
+        dst[x] = self.palette_[(src[x >> 3] >> (7 - (x & 7))) & 1];
+      }
+      break;
+  }
+}
+
+void PixelConverter::ConvertIndexedA8(const PixelConverter& self, void* dst_pixels,
+                                      const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint8_t*>(dst_pixels);
+
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t index;
+    if (self.bits_per_pixel_ == 8) {
+      index = src[x];
+    } else if (self.bits_per_pixel_ == 4) {
+      index = (x & 1) ? (src[x >> 1] & 0x0F) : (src[x >> 1] >> 4);
+    } else {
+      index = (src[x >> 3] >> (7 - (x & 7))) & 1;
+    }
+    dst[x] = static_cast<std::uint8_t>(self.palette_[index]);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("ssse3")))
+void PixelConverter::ConvertShuffle32SSSE3(const PixelConverter& self, void* dst_pixels,
+                                           const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint32_t*>(dst_pixels);
+  __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(self.shuffle_));
+  __m128i fill = _mm_set1_epi32(static_cast<int>(self.fill_mask_));
+
+  std::uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+    pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), fill);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), pixels);
+  }
+
+  ConvertShuffle(self, dst + x, src + x * 4, width - x);
+}
+
+__attribute__((target("ssse3")))
+void PixelConverter::ConvertShuffle24SSSE3(const PixelConverter& self, void* dst_pixels,
+                                           const std::uint8_t* src, std::uint32_t width) {
+  auto* dst = static_cast<std::uint32_t*>(dst_pixels);
+  __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(self.shuffle_));
+  __m128i fill = _mm_set1_epi32(static_cast<int>(self.fill_mask_));
+
+  // Each load reads 16 bytes but consumes 12, so stop while a full load is
+  // still inside the row.
+  std::uint32_t x = 0;
+  for (; x + 6 <= width; x += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 3));
+    pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), fill);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), pixels);
+  }
+
+  ConvertShuffle(self, dst + x, src + x * 3, width - x);
+}
+
+#endif
+
+} // namespace rezero
@@ -0,0 +1,78 @@
+// Created by DONG Zhong on 2024/03/20.
+
+#ifndef REZERO_CODEC_PIXEL_CONVERTER_H_
+#define REZERO_CODEC_PIXEL_CONVERTER_H_
+
+#include <cstdint>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/format.h"
+
+namespace rezero {
+
+// Converts rows of packed or indexed pixels into kARGB8888, or indexed gray
+// pixels into kA8. The conversion kernel is chosen once in Init*, so
+// ConvertRow is a single indirect call.
+class PixelConverter {
+ public:
+  PixelConverter();
+  ~PixelConverter();
+
+  // `masks` holds the r, g, b and a masks. A zero alpha mask means opaque.
+  bool InitFromMasks(std::uint32_t bits_per_pixel, const std::uint32_t masks[4]);
+
+  // `palette` holds `count` BGRx entries as stored in the file. For kA8 the
+  // blue channel of each entry is used.
+  bool InitFromPalette(std::uint32_t bits_per_pixel, const std::uint8_t* palette, std::uint32_t count,
+                       Format dst_format = Format::kARGB8888);
+
+  void ConvertRow(void* dst, const void* src, std::uint32_t width) const {
+    convert_func_(*this, dst, static_cast<const std::uint8_t*>(src), width);
+  }
+
+ private:
+  using ConvertFunc = void (*)(const PixelConverter& self, void* dst,
+                               const std::uint8_t* src, std::uint32_t width);
+
+  struct Channel {
+    std::uint32_t mask;
+    std::uint32_t shift;
+    // Scales a channel of any depth to 8 bits: `(value * scale) >> 16`.
+    std::uint32_t scale;
+  };
+
+  static void ConvertMasked(const PixelConverter& self, void* dst,
+                            const std::uint8_t* src, std::uint32_t width);
+  static void ConvertShuffle(const PixelConverter& self, void* dst,
+                             const std::uint8_t* src, std::uint32_t width);
+  static void ConvertIndexed(const PixelConverter& self, void* dst,
+                             const std::uint8_t* src, std::uint32_t width);
+  static void ConvertIndexedA8(const PixelConverter& self, void* dst,
+                               const std::uint8_t* src, std::uint32_t width);
+#if defined(__x86_64__) || defined(__i386__)
+  static void ConvertShuffle32SSSE3(const PixelConverter& self, void* dst,
+                                    const std::uint8_t* src, std::uint32_t width);
+  static void ConvertShuffle24SSSE3(const PixelConverter& self, void* dst,
+                                    const std::uint8_t* src, std::uint32_t width);
+#endif
+
+  ConvertFunc convert_func_ = nullptr;
+
+  std::uint32_t bytes_per_pixel_ = 0;
+  std::uint32_t bits_per_pixel_ = 0;
+
+  Channel channels_[4];
+  std::uint32_t fill_mask_ = 0;
+
+  // For byte aligned masks: the source byte of each BGRA destination byte,
+  // repeated for four pixels. 0x80 produces zero.
+  alignas(16) std::uint8_t shuffle_[16];
+
+  std::uint32_t palette_[256];
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(PixelConverter);
+};
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_PIXEL_CONVERTER_H_
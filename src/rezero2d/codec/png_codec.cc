@@ -0,0 +1,332 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#include "rezero2d/codec/png_codec.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "rezero2d/base/parallel.h"
+#include "rezero2d/codec/checksum.h"
+#include "rezero2d/codec/deflate.h"
+#include "rezero2d/utils/pixel_operations.h"
+
+namespace rezero {
+
+namespace png {
+
+static constexpr std::uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+static constexpr std::uint8_t kColorTypeGray = 0;
+static constexpr std::uint8_t kColorTypeRGB = 2;
+static constexpr std::uint8_t kColorTypePalette = 3;
+static constexpr std::uint8_t kColorTypeGrayAlpha = 4;
+static constexpr std::uint8_t kColorTypeRGBA = 6;
+
+static constexpr std::uint32_t kIHDRSize = 13;
+
+static constexpr std::uint8_t kFilterNone = 0;
+static constexpr std::uint8_t kFilterSub = 1;
+static constexpr std::uint8_t kFilterUp = 2;
+static constexpr std::uint8_t kFilterAverage = 3;
+static constexpr std::uint8_t kFilterPaeth = 4;
+
+// Strips are sized by their filtered bytes, not by the thread count, so the
+// output does not depend on how many threads encoded it.
+static constexpr std::size_t kStripSize = 256 * 1024;
+
+} // namespace png
+
+namespace {
+
+void StoreBE32(std::uint8_t* p, std::uint32_t value) {
+  p[0] = static_cast<std::uint8_t>(value >> 24);
+  p[1] = static_cast<std::uint8_t>(value >> 16);
+  p[2] = static_cast<std::uint8_t>(value >> 8);
+  p[3] = static_cast<std::uint8_t>(value);
+}
+
+std::uint32_t LoadBE32(const std::uint8_t* p) {
+  return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+         (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+// Writes one chunk whose payload is `prefix` followed by `data`.
+bool WriteChunk(const EncodeSink& sink, const char type[4],
+                const std::uint8_t* prefix, std::size_t prefix_size,
+                const std::uint8_t* data, std::size_t size) {
+  std::uint8_t header[8];
+  StoreBE32(header, static_cast<std::uint32_t>(prefix_size + size));
+  std::memcpy(header + 4, type, 4);
+
+  std::uint32_t crc = Crc32(0, header + 4, 4);
+  crc = Crc32(crc, prefix, prefix_size);
+  crc = Crc32(crc, data, size);
+
+  std::uint8_t trailer[4];
+  StoreBE32(trailer, crc);
+
+  return sink(header, sizeof(header)) &&
+         (prefix_size == 0 || sink(prefix, prefix_size)) &&
+         (size == 0 || sink(data, size)) &&
+         sink(trailer, sizeof(trailer));
+}
+
+// Converts one source row into PNG channel order, with straight alpha.
+void ConvertRow(Format format, const std::uint8_t* src, std::uint32_t width, std::uint8_t* dst) {
+  if (format == Format::kA8) {
+    std::memcpy(dst, src, width);
+    return;
+  }
+
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, src + x * 4, 4);
+    pixel = UnpremultiplyPixel(pixel);
+    dst[x * 4 + 0] = static_cast<std::uint8_t>(pixel >> 16);
+    dst[x * 4 + 1] = static_cast<std::uint8_t>(pixel >> 8);
+    dst[x * 4 + 2] = static_cast<std::uint8_t>(pixel);
+    dst[x * 4 + 3] = static_cast<std::uint8_t>(pixel >> 24);
+  }
+}
+
+std::uint8_t Paeth(std::uint8_t a, std::uint8_t b, std::uint8_t c) {
+  int p = int(a) + int(b) - int(c);
+  int pa = std::abs(p - int(a));
+  int pb = std::abs(p - int(b));
+  int pc = std::abs(p - int(c));
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+void FilterRow(std::uint8_t filter, const std::uint8_t* row, const std::uint8_t* prior,
+               std::size_t size, std::uint32_t bpp, std::uint8_t* out) {
+  switch (filter) {
+    case png::kFilterNone:
+      std::memcpy(out, row, size);
+      break;
+    case png::kFilterSub:
+      for (std::size_t i = 0; i < size; ++i) {
+        out[i] = row[i] - (i >= bpp ? row[i - bpp] : 0);
+      }
+      break;
+    case png::kFilterUp:
+      for (std::size_t i = 0; i < size; ++i) {
+        out[i] = row[i] - prior[i];
+      }
+      break;
+    case png::kFilterAverage:
+      for (std::size_t i = 0; i < size; ++i) {
+        std::uint32_t left = i >= bpp ? row[i - bpp] : 0;
+        out[i] = row[i] - static_cast<std::uint8_t>((left + prior[i]) >> 1);
+      }
+      break;
+    default:
+      for (std::size_t i = 0; i < size; ++i) {
+        std::uint8_t left = i >= bpp ? row[i - bpp] : 0;
+        std::uint8_t upper_left = i >= bpp ? prior[i - bpp] : 0;
+        out[i] = row[i] - Paeth(left, prior[i], upper_left);
+      }
+      break;
+  }
+}
+
+// Picks the filter with the smallest sum of absolute residuals.
+std::uint8_t FilterRowAdaptive(const std::uint8_t* row, const std::uint8_t* prior, std::size_t size,
+                               std::uint32_t bpp, std::uint8_t* out, std::uint8_t* scratch) {
+  std::uint8_t best_filter = png::kFilterNone;
+  std::uint64_t best_cost = ~std::uint64_t(0);
+
+  for (std::uint8_t filter = png::kFilterNone; filter <= png::kFilterPaeth; ++filter) {
+    FilterRow(filter, row, prior, size, bpp, scratch);
+
+    std::uint64_t cost = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      cost += static_cast<std::uint64_t>(std::abs(static_cast<std::int8_t>(scratch[i])));
+    }
+
+    if (cost < best_cost) {
+      best_cost = cost;
+      best_filter = filter;
+      std::memcpy(out, scratch, size);
+    }
+  }
+
+  return best_filter;
+}
+
+struct Strip {
+  std::uint32_t begin_row;
+  std::uint32_t end_row;
+
+  std::vector<std::uint8_t> compressed;
+  std::uint32_t adler;
+  std::size_t raw_size;
+};
+
+void EncodeStrip(Format format, std::uint32_t width, const PixelRows& pixels,
+                 std::uint32_t bpp, bool adaptive, Strip& strip) {
+  std::size_t row_size = std::size_t(width) * bpp;
+  std::size_t row_count = strip.end_row - strip.begin_row;
+
+  std::vector<std::uint8_t> raw(row_count * (row_size + 1));
+  std::vector<std::uint8_t> prior(row_size, 0);
+  std::vector<std::uint8_t> current(row_size);
+  std::vector<std::uint8_t> scratch(adaptive ? row_size : 0);
+
+  // The first row of a strip is filtered against the last row of the
+  // previous strip, exactly as a sequential encoder would, so that row is
+  // read along with the strip.
+  std::uint32_t first_row = strip.begin_row > 0 ? strip.begin_row - 1 : 0;
+  std::vector<std::uint8_t> read_scratch;
+  const std::uint8_t* rows = pixels.Read(first_row, strip.end_row - first_row, read_scratch);
+  std::size_t src_stride = pixels.GetRowSize();
+  if (strip.begin_row > 0) {
+    ConvertRow(format, rows, width, prior.data());
+    rows += src_stride;
+  }
+
+  std::uint8_t* out = raw.data();
+  for (std::uint32_t y = strip.begin_row; y < strip.end_row; ++y, rows += src_stride) {
+    ConvertRow(format, rows, width, current.data());
+
+    if (adaptive) {
+      out[0] = FilterRowAdaptive(current.data(), prior.data(), row_size, bpp, out + 1, scratch.data());
+    } else {
+      out[0] = png::kFilterUp;
+      FilterRow(png::kFilterUp, current.data(), prior.data(), row_size, bpp, out + 1);
+    }
+
+    out += row_size + 1;
+    std::swap(prior, current);
+  }
+
+  strip.raw_size = raw.size();
+  strip.adler = Adler32(1, raw.data(), raw.size());
+
+  Deflater deflater(adaptive ? Deflater::Level::kDefault : Deflater::Level::kFast);
+  deflater.Compress(raw.data(), raw.size(), false, strip.compressed);
+}
+
+} // namespace
+
+PNGCodec::PNGCodec() = default;
+
+PNGCodec::~PNGCodec() = default;
+
+std::shared_ptr<Data> PNGCodec::EncodeToFileData(Format format, std::uint32_t width,
+                                                 std::uint32_t height, const PixelRows& pixels,
+                                                 const EncodeOptions& options) {
+  return EncodeToGrowingData(format, width, height, pixels, options);
+}
+
+bool PNGCodec::Sniff(const void* header, std::size_t size) const {
+  return size >= sizeof(png::kSignature) &&
+         std::memcmp(header, png::kSignature, sizeof(png::kSignature)) == 0;
+}
+
+bool PNGCodec::DecodeInfo(const Data& data, ImageInfo& info) {
+  const auto* p = static_cast<const std::uint8_t*>(data.GetData());
+
+  // IHDR must be the first chunk.
+  static constexpr std::size_t kIHDROffset = sizeof(png::kSignature) + 8;
+  if (data.GetSize() < kIHDROffset + png::kIHDRSize || !Sniff(p, data.GetSize()) ||
+      LoadBE32(p + 8) != png::kIHDRSize || std::memcmp(p + 12, "IHDR", 4) != 0) {
+    return false;
+  }
+
+  const std::uint8_t* ihdr = p + kIHDROffset;
+  std::uint32_t width = LoadBE32(ihdr);
+  std::uint32_t height = LoadBE32(ihdr + 4);
+  std::uint8_t color_type = ihdr[9];
+  if (!width || !height || width > 0x7FFFFFFF || height > 0x7FFFFFFF) {
+    return false;
+  }
+
+  switch (color_type) {
+    case png::kColorTypeGray:
+      info.format = Format::kA8;
+      break;
+    case png::kColorTypeRGB:
+    case png::kColorTypePalette:
+    case png::kColorTypeGrayAlpha:
+    case png::kColorTypeRGBA:
+      info.format = Format::kARGB8888;
+      break;
+    default:
+      return false;
+  }
+
+  info.width = width;
+  info.height = height;
+  return true;
+}
+
+bool PNGCodec::EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                            const PixelRows& pixels, const EncodeOptions& options,
+                            const EncodeSink& sink) {
+  std::uint32_t bpp = format == Format::kA8 ? 1 : 4;
+  std::size_t filtered_row_size = std::size_t(width) * bpp + 1;
+
+  auto strip_rows = static_cast<std::uint32_t>(std::max<std::size_t>(1, png::kStripSize / filtered_row_size));
+  std::uint32_t strip_count = (height + strip_rows - 1) / strip_rows;
+
+  std::vector<Strip> strips(strip_count);
+  for (std::uint32_t i = 0; i < strip_count; ++i) {
+    strips[i].begin_row = i * strip_rows;
+    strips[i].end_row = std::min(height, (i + 1) * strip_rows);
+  }
+
+  ParallelFor(strip_count, options.thread_count, [&](std::size_t i) {
+    EncodeStrip(format, width, pixels, bpp, options.compress, strips[i]);
+  });
+
+  if (!sink(png::kSignature, sizeof(png::kSignature))) {
+    return false;
+  }
+
+  std::uint8_t ihdr[png::kIHDRSize];
+  StoreBE32(ihdr, width);
+  StoreBE32(ihdr + 4, height);
+  ihdr[8] = 8;
+  ihdr[9] = format == Format::kA8 ? png::kColorTypeGray : png::kColorTypeRGBA;
+  ihdr[10] = 0; // Deflate.
+  ihdr[11] = 0; // Adaptive filtering.
+  ihdr[12] = 0; // No interlace.
+  if (!WriteChunk(sink, "IHDR", nullptr, 0, ihdr, sizeof(ihdr))) {
+    return false;
+  }
+
+  // Each strip becomes one IDAT chunk. The zlib header leads the first one.
+  const std::uint8_t zlib_header[2] = {0x78, static_cast<std::uint8_t>(options.compress ? 0x5E : 0x01)};
+
+  std::uint32_t adler = 1;
+  for (std::uint32_t i = 0; i < strip_count; ++i) {
+    const Strip& strip = strips[i];
+    adler = Adler32Combine(adler, strip.adler, strip.raw_size);
+
+    if (!WriteChunk(sink, "IDAT", zlib_header, i == 0 ? sizeof(zlib_header) : 0,
+                    strip.compressed.data(), strip.compressed.size())) {
+      return false;
+    }
+  }
+
+  std::uint8_t tail[2 + sizeof(Deflater::kFinalEmptyBlock) + 4];
+  std::size_t tail_size = 0;
+  if (strip_count == 0) {
+    std::memcpy(tail, zlib_header, sizeof(zlib_header));
+    tail_size += sizeof(zlib_header);
+  }
+  std::memcpy(tail + tail_size, Deflater::kFinalEmptyBlock, sizeof(Deflater::kFinalEmptyBlock));
+  tail_size += sizeof(Deflater::kFinalEmptyBlock);
+  StoreBE32(tail + tail_size, adler);
+  tail_size += 4;
+
+  return WriteChunk(sink, "IDAT", nullptr, 0, tail, tail_size) &&
+         WriteChunk(sink, "IEND", nullptr, 0, nullptr, 0);
+}
+
+} // namespace rezero
@@ -0,0 +1,34 @@
+// Created by DONG Zhong on 2024/03/25.
+
+#ifndef REZERO_CODEC_PNG_CODEC_H_
+#define REZERO_CODEC_PNG_CODEC_H_
+
+#include "rezero2d/codec.h"
+
+namespace rezero {
+
+// Encodes kARGB8888 as 8-bit RGBA and kA8 as 8-bit gray. The image is split
+// into horizontal strips that are filtered and deflated independently on
+// worker threads, then stitched into a single zlib stream.
+class PNGCodec : public Codec {
+ public:
+  PNGCodec();
+  ~PNGCodec() override;
+
+  std::shared_ptr<Data> EncodeToFileData(Format format, std::uint32_t width,
+                                         std::uint32_t height, const PixelRows& pixels,
+                                         const EncodeOptions& options) override;
+
+  bool EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                    const PixelRows& pixels, const EncodeOptions& options,
+                    const EncodeSink& sink) override;
+
+  bool Sniff(const void* header, std::size_t size) const override;
+
+  // Reads IHDR only; pixel decoding is not supported.
+  bool DecodeInfo(const Data& data, ImageInfo& info) override;
+};
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_PNG_CODEC_H_
@@ -0,0 +1,325 @@
+// Created by DONG Zhong on 2024/03/28.
+
+#include "rezero2d/codec/qoi_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "rezero2d/base/logging.h"
+#include "rezero2d/utils/pixel_operations.h"
+
+namespace rezero {
+
+namespace qoi {
+
+static constexpr std::uint8_t kMagic[4] = {'q', 'o', 'i', 'f'};
+static constexpr std::size_t kHeaderSize = 14;
+static constexpr std::uint8_t kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+// Images above this many pixels are rejected, as in the reference decoder.
+static constexpr std::uint64_t kPixelsMax = 400000000;
+
+static constexpr std::uint8_t kOpIndex = 0x00;
+static constexpr std::uint8_t kOpDiff = 0x40;
+static constexpr std::uint8_t kOpLuma = 0x80;
+static constexpr std::uint8_t kOpRun = 0xC0;
+static constexpr std::uint8_t kOpRGB = 0xFE;
+static constexpr std::uint8_t kOpRGBA = 0xFF;
+static constexpr std::uint8_t kOpMask = 0xC0;
+
+static constexpr std::uint32_t kRunMax = 62;
+// Largest encoding of a single pixel (kOpRGBA).
+static constexpr std::size_t kPixelSizeMax = 5;
+
+} // namespace qoi
+
+namespace {
+
+constexpr std::size_t kOutputBufferSize = 64 * 1024;
+
+// Pixels are kept as native kARGB8888 words throughout.
+inline std::uint32_t Hash(std::uint32_t pixel) {
+  std::uint32_t a = pixel >> 24;
+  std::uint32_t r = (pixel >> 16) & 0xFF;
+  std::uint32_t g = (pixel >> 8) & 0xFF;
+  std::uint32_t b = pixel & 0xFF;
+  return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+}
+
+inline void StoreBE32(std::uint8_t* p, std::uint32_t value) {
+  p[0] = static_cast<std::uint8_t>(value >> 24);
+  p[1] = static_cast<std::uint8_t>(value >> 16);
+  p[2] = static_cast<std::uint8_t>(value >> 8);
+  p[3] = static_cast<std::uint8_t>(value);
+}
+
+inline std::uint32_t LoadBE32(const std::uint8_t* p) {
+  return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+         (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+class Encoder {
+ public:
+  // Encodes one row and returns the new end of `out`, which must have room
+  // for `width * qoi::kPixelSizeMax` bytes.
+  std::uint8_t* EncodeRow(const std::uint32_t* row, std::uint32_t width, std::uint8_t* out) {
+    for (std::uint32_t x = 0; x < width; ++x) {
+      std::uint32_t pixel = row[x];
+
+      if (pixel == previous_) {
+        if (++run_ == qoi::kRunMax) {
+          *out++ = qoi::kOpRun | (run_ - 1);
+          run_ = 0;
+        }
+        continue;
+      }
+
+      if (run_) {
+        *out++ = qoi::kOpRun | (run_ - 1);
+        run_ = 0;
+      }
+
+      std::uint32_t hash = Hash(pixel);
+      if (index_[hash] == pixel) {
+        *out++ = qoi::kOpIndex | hash;
+        previous_ = pixel;
+        continue;
+      }
+      index_[hash] = pixel;
+
+      if ((pixel ^ previous_) >> 24) {
+        *out++ = qoi::kOpRGBA;
+        *out++ = static_cast<std::uint8_t>(pixel >> 16);
+        *out++ = static_cast<std::uint8_t>(pixel >> 8);
+        *out++ = static_cast<std::uint8_t>(pixel);
+        *out++ = static_cast<std::uint8_t>(pixel >> 24);
+        previous_ = pixel;
+        continue;
+      }
+
+      auto dr = static_cast<std::int8_t>((pixel >> 16) - (previous_ >> 16));
+      auto dg = static_cast<std::int8_t>((pixel >> 8) - (previous_ >> 8));
+      auto db = static_cast<std::int8_t>(pixel - previous_);
+      int dr_dg = dr - dg;
+      int db_dg = db - dg;
+
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        *out++ = qoi::kOpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+      } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+        *out++ = qoi::kOpLuma | (dg + 32);
+        *out++ = static_cast<std::uint8_t>(((dr_dg + 8) << 4) | (db_dg + 8));
+      } else {
+        *out++ = qoi::kOpRGB;
+        *out++ = static_cast<std::uint8_t>(pixel >> 16);
+        *out++ = static_cast<std::uint8_t>(pixel >> 8);
+        *out++ = static_cast<std::uint8_t>(pixel);
+      }
+      previous_ = pixel;
+    }
+    return out;
+  }
+
+  // Terminates a pending run. Runs may span rows, so this is only called
+  // after the last one.
+  std::uint8_t* Finish(std::uint8_t* out) {
+    if (run_) {
+      *out++ = qoi::kOpRun | (run_ - 1);
+      run_ = 0;
+    }
+    return out;
+  }
+
+ private:
+  std::uint32_t index_[64] = {};
+  std::uint32_t previous_ = 0xFF000000;
+  std::uint32_t run_ = 0;
+};
+
+bool ParseHeader(const std::uint8_t* p, std::size_t size, std::uint32_t& width, std::uint32_t& height) {
+  if (size < qoi::kHeaderSize + sizeof(qoi::kEndMarker) ||
+      std::memcmp(p, qoi::kMagic, sizeof(qoi::kMagic)) != 0) {
+    return false;
+  }
+
+  width = LoadBE32(p + 4);
+  height = LoadBE32(p + 8);
+  std::uint8_t channels = p[12];
+  std::uint8_t color_space = p[13];
+
+  // No op yields more than a run of pixels, so the stream bounds the size
+  // before any pixels are allocated.
+  std::uint64_t pixel_count = std::uint64_t(width) * height;
+  std::uint64_t op_size = size - qoi::kHeaderSize - sizeof(qoi::kEndMarker);
+  return width && height && (channels == 3 || channels == 4) && color_space <= 1 &&
+         pixel_count <= qoi::kPixelsMax && pixel_count <= op_size * qoi::kRunMax;
+}
+
+} // namespace
+
+QOICodec::QOICodec() = default;
+
+QOICodec::~QOICodec() = default;
+
+std::shared_ptr<Data> QOICodec::EncodeToFileData(Format format, std::uint32_t width,
+                                                 std::uint32_t height, const PixelRows& pixels,
+                                                 const EncodeOptions& options) {
+  return EncodeToGrowingData(format, width, height, pixels, options);
+}
+
+bool QOICodec::EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                            const PixelRows& pixels, const EncodeOptions& /*options*/,
+                            const EncodeSink& sink) {
+  if (format != Format::kARGB8888) {
+    REZERO_LOG(ERROR) << "QOI only encodes kARGB8888.";
+    return false;
+  }
+
+  std::uint8_t header[qoi::kHeaderSize];
+  std::memcpy(header, qoi::kMagic, sizeof(qoi::kMagic));
+  StoreBE32(header + 4, width);
+  StoreBE32(header + 8, height);
+  header[12] = 4; // RGBA.
+  header[13] = 0; // sRGB with linear alpha.
+
+  if (!sink(header, sizeof(header))) {
+    return false;
+  }
+
+  // Rows are encoded into a bounce buffer and flushed whenever it cannot fit
+  // the worst case of another row.
+  std::size_t row_size_max = std::size_t(width) * qoi::kPixelSizeMax;
+  std::vector<std::uint8_t> buffer(std::max(kOutputBufferSize, row_size_max + 1));
+  std::uint8_t* begin = buffer.data();
+  std::uint8_t* end = begin + buffer.size();
+  std::uint8_t* out = begin;
+
+  // QOI stores straight alpha.
+  std::vector<std::uint32_t> straight(width);
+  std::vector<std::uint8_t> scratch;
+
+  Encoder encoder;
+  for (std::uint32_t y = 0; y < height; ++y) {
+    if (std::size_t(end - out) < row_size_max + 1) {
+      if (!sink(begin, out - begin)) {
+        return false;
+      }
+      out = begin;
+    }
+    UnpremultiplyRow(straight.data(), pixels.Read(y, 1, scratch), width);
+    out = encoder.EncodeRow(straight.data(), width, out);
+  }
+  out = encoder.Finish(out);
+
+  return sink(begin, out - begin) && sink(qoi::kEndMarker, sizeof(qoi::kEndMarker));
+}
+
+bool QOICodec::Sniff(const void* header, std::size_t size) const {
+  return size >= sizeof(qoi::kMagic) && std::memcmp(header, qoi::kMagic, sizeof(qoi::kMagic)) == 0;
+}
+
+bool QOICodec::CanDecodePixels() const {
+  return true;
+}
+
+bool QOICodec::DecodeInfo(const Data& data, ImageInfo& info) {
+  std::uint32_t width;
+  std::uint32_t height;
+  if (!ParseHeader(static_cast<const std::uint8_t*>(data.GetData()), data.GetSize(), width, height)) {
+    return false;
+  }
+
+  info.width = width;
+  info.height = height;
+  info.format = Format::kARGB8888;
+  return true;
+}
+
+bool QOICodec::DecodePixels(const Data& data, const ImageInfo& info,
+                            void* pixels, std::uint32_t stride) {
+  const auto* p = static_cast<const std::uint8_t*>(data.GetData());
+
+  std::uint32_t width;
+  std::uint32_t height;
+  if (!ParseHeader(p, data.GetSize(), width, height) || info.width != width ||
+      info.height != height || info.format != Format::kARGB8888) {
+    return false;
+  }
+
+  // The end marker is never part of a chunk, so stopping before it makes
+  // every multi-byte op safe to read after a single bounds check.
+  const std::uint8_t* src = p + qoi::kHeaderSize;
+  const std::uint8_t* src_end = p + data.GetSize() - sizeof(qoi::kEndMarker);
+
+  std::uint32_t index[64] = {};
+  std::uint32_t pixel = 0xFF000000;
+  std::uint32_t run = 0;
+
+  auto* dst_row = static_cast<std::uint8_t*>(pixels);
+  for (std::uint32_t y = 0; y < height; ++y, dst_row += stride) {
+    auto* dst = reinterpret_cast<std::uint32_t*>(dst_row);
+
+    for (std::uint32_t x = 0; x < width; ++x) {
+      if (run) {
+        --run;
+        dst[x] = pixel;
+        continue;
+      }
+
+      if (src >= src_end) {
+        return false;
+      }
+
+      std::uint8_t op = *src++;
+      if (op == qoi::kOpRGB) {
+        pixel = (pixel & 0xFF000000) | (std::uint32_t(src[0]) << 16) |
+                (std::uint32_t(src[1]) << 8) | src[2];
+        src += 3;
+      } else if (op == qoi::kOpRGBA) {
+        pixel = (std::uint32_t(src[3]) << 24) | (std::uint32_t(src[0]) << 16) |
+                (std::uint32_t(src[1]) << 8) | src[2];
+        src += 4;
+      } else {
+        switch (op & qoi::kOpMask) {
+          case qoi::kOpIndex:
+            pixel = index[op];
+            dst[x] = pixel;
+            continue;
+          case qoi::kOpDiff: {
+            std::uint32_t r = ((pixel >> 16) + ((op >> 4) & 3) - 2) & 0xFF;
+            std::uint32_t g = ((pixel >> 8) + ((op >> 2) & 3) - 2) & 0xFF;
+            std::uint32_t b = (pixel + (op & 3) - 2) & 0xFF;
+            pixel = (pixel & 0xFF000000) | (r << 16) | (g << 8) | b;
+            break;
+          }
+          case qoi::kOpLuma: {
+            int dg = (op & 0x3F) - 32;
+            std::uint8_t second = *src++;
+            int dr = dg + (second >> 4) - 8;
+            int db = dg + (second & 0x0F) - 8;
+            std::uint32_t r = ((pixel >> 16) + dr) & 0xFF;
+            std::uint32_t g = ((pixel >> 8) + dg) & 0xFF;
+            std::uint32_t b = (pixel + db) & 0xFF;
+            pixel = (pixel & 0xFF000000) | (r << 16) | (g << 8) | b;
+            break;
+          }
+          default:
+            // The run includes the current pixel.
+            run = op & 0x3F;
+            dst[x] = pixel;
+            continue;
+        }
+      }
+
+      index[Hash(pixel)] = pixel;
+      dst[x] = pixel;
+    }
+
+    // Decoding works on straight alpha, as the ops are relative to it.
+    PremultiplyRow(dst, dst, width);
+  }
+
+  return true;
+}
+
+} // namespace rezero
@@ -0,0 +1,37 @@
+// Created by DONG Zhong on 2024/03/28.
+
+#ifndef REZERO_CODEC_QOI_CODEC_H_
+#define REZERO_CODEC_QOI_CODEC_H_
+
+#include "rezero2d/codec.h"
+
+namespace rezero {
+
+// The "Quite OK Image" format: lossless, single pass, no entropy coding.
+// Encodes and decodes kARGB8888 only, always as four channels.
+class QOICodec : public Codec {
+ public:
+  QOICodec();
+  ~QOICodec() override;
+
+  std::shared_ptr<Data> EncodeToFileData(Format format, std::uint32_t width,
+                                         std::uint32_t height, const PixelRows& pixels,
+                                         const EncodeOptions& options) override;
+
+  bool EncodeToSink(Format format, std::uint32_t width, std::uint32_t height,
+                    const PixelRows& pixels, const EncodeOptions& options,
+                    const EncodeSink& sink) override;
+
+  bool Sniff(const void* header, std::size_t size) const override;
+
+  bool CanDecodePixels() const override;
+
+  bool DecodeInfo(const Data& data, ImageInfo& info) override;
+
+  bool DecodePixels(const Data& data, const ImageInfo& info,
+                    void* pixels, std::uint32_t stride) override;
+};
+
+} // namespace rezero
+
+#endif // REZERO_CODEC_QOI_CODEC_H_
@@ -0,0 +1,95 @@
+// Created by DONG Zhong on 2024/04/14.
+
+#include "rezero2d/damage_region.h"
+
+#include <limits>
+
+namespace rezero {
+
+namespace {
+
+// The pixels a merge adds on top of the two rectangles.
+std::int64_t CalculateMergeWaste(const IntRect& a, const IntRect& b) {
+  return a.Union(b).GetArea() - a.GetArea() - b.GetArea() + a.Intersect(b).GetArea();
+}
+
+} // namespace
+
+DamageRegion::DamageRegion() = default;
+
+DamageRegion::~DamageRegion() = default;
+
+void DamageRegion::Add(const IntRect& rect) {
+  if (rect.IsEmpty()) {
+    return;
+  }
+
+  // Merging can make the result reach other rectangles, so repeat until
+  // nothing overlaps it.
+  IntRect merged = rect;
+  for (std::size_t i = 0; i < rects_.size();) {
+    if (rects_[i].Intersects(merged) || CalculateMergeWaste(rects_[i], merged) <= kMergeSlack) {
+      merged = merged.Union(rects_[i]);
+      rects_[i] = rects_.back();
+      rects_.pop_back();
+      i = 0;
+    } else {
+      ++i;
+    }
+  }
+  rects_.push_back(merged);
+
+  while (rects_.size() > kMaxRectCount) {
+    std::size_t best_i = 0;
+    std::size_t best_j = 1;
+    std::int64_t best_waste = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t i = 0; i < rects_.size(); ++i) {
+      for (std::size_t j = i + 1; j < rects_.size(); ++j) {
+        std::int64_t waste = CalculateMergeWaste(rects_[i], rects_[j]);
+        if (waste < best_waste) {
+          best_waste = waste;
+          best_i = i;
+          best_j = j;
+        }
+      }
+    }
+
+    IntRect pair = rects_[best_i].Union(rects_[best_j]);
+    rects_[best_j] = rects_.back();
+    rects_.pop_back();
+    rects_[best_i] = rects_.back();
+    rects_.pop_back();
+    Add(pair);
+  }
+}
+
+bool DamageRegion::Intersects(const IntRect& rect) const {
+  for (const auto& r : rects_) {
+    if (r.Intersects(rect)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+IntRect DamageRegion::GetBounds() const {
+  if (rects_.empty()) {
+    return {0, 0, 0, 0};
+  }
+
+  IntRect bounds = rects_.front();
+  for (const auto& r : rects_) {
+    bounds = bounds.Union(r);
+  }
+  return bounds;
+}
+
+std::int64_t DamageRegion::GetArea() const {
+  std::int64_t area = 0;
+  for (const auto& r : rects_) {
+    area += r.GetArea();
+  }
+  return area;
+}
+
+} // namespace rezero
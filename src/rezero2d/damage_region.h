@@ -0,0 +1,49 @@
+// Created by DONG Zhong on 2024/04/14.
+
+#ifndef REZERO_DAMAGE_REGION_H_
+#define REZERO_DAMAGE_REGION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rezero2d/geometry.h"
+
+namespace rezero {
+
+// A set of pixel rectangles that never overlap. Rectangles that touch, or
+// that are close enough for their union to waste little area, are merged,
+// so the list stays short at the cost of covering a few extra pixels.
+class DamageRegion {
+ public:
+  // Rectangles beyond this count are merged with their cheapest neighbor.
+  static constexpr std::size_t kMaxRectCount = 16;
+
+  // A merge may cover up to this many pixels neither rectangle had.
+  static constexpr std::int64_t kMergeSlack = 64 * 64;
+
+  DamageRegion();
+  ~DamageRegion();
+
+  void Add(const IntRect& rect);
+
+  void Clear() { rects_.clear(); }
+
+  bool IsEmpty() const { return rects_.empty(); }
+
+  bool Intersects(const IntRect& rect) const;
+
+  // The union of all rectangles. Empty when the region is.
+  IntRect GetBounds() const;
+
+  std::int64_t GetArea() const;
+
+  const std::vector<IntRect>& GetRects() const { return rects_; }
+
+ private:
+  std::vector<IntRect> rects_;
+};
+
+} // namespace rezero
+
+#endif // REZERO_DAMAGE_REGION_H_
@@ -2,42 +2,240 @@
 
 #include "rezero2d/data.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rezero2d/base/file.h"
+#include "rezero2d/base/logging.h"
 
 namespace rezero {
 
-Data::Data() = default;
+class Data::Storage {
+ public:
+  enum class Kind : std::uint8_t {
+    kHeap,
+    kExternal,
+    kMapping,
+    kWritableMapping,
+  };
+
+  Storage(Kind kind, void* data, std::size_t size, ReleaseProc proc, void* context)
+      : kind_(kind), data_(data), size_(size), proc_(proc), context_(context) {}
 
-Data::~Data() {
-  if (data_) {
-    std::free(data_);
+  ~Storage() {
+    if (proc_) {
+      proc_(data_, size_, context_);
+    }
   }
+
+  Kind GetKind() const { return kind_; }
+  void SetAllocator(std::shared_ptr<Allocator> allocator) { allocator_ = std::move(allocator); }
+  void* GetData() const { return data_; }
+  std::size_t GetSize() const { return size_; }
+
+ private:
+  Kind kind_;
+  void* data_;
+  std::size_t size_;
+  ReleaseProc proc_;
+  void* context_;
+  // Keeps the allocator of `data_` alive until `proc_` has run.
+  std::shared_ptr<Allocator> allocator_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Storage);
+};
+
+namespace {
+
+void FreeProc(void* data, std::size_t /*size*/, void* /*context*/) {
+  std::free(data);
 }
 
-void Data::Init(std::size_t size, void* data) {
-  size_ = size;
-  data_ = std::malloc(size);
+void UnmapProc(void* data, std::size_t size, void* /*context*/) {
+  ::munmap(data, size);
+}
+
+// `context` is the Allocator, kept alive by the storage.
+void AllocatorFreeProc(void* data, std::size_t size, void* context) {
+  static_cast<Allocator*>(context)->Free(data, size);
+}
 
-  if (data) {
-    std::memcpy(data_, data, size);
-  } else {
-    std::memset(data_, 0, size);
+} // namespace
+
+std::shared_ptr<Data> Data::MakeWithCopy(const void* data, std::size_t size) {
+  auto result = MakeUninitialized(size);
+  if (size > 0) {
+    if (data) {
+      std::memcpy(result->data_, data, size);
+    } else {
+      std::memset(result->data_, 0, size);
+    }
   }
+  return result;
 }
 
-bool Data::SaveToFile(const std::string& file_path) {
-  std::ofstream ofs(file_path, std::ios::out | std::ios::binary);
-  if (ofs) {
-    if (size_ > 0) {
-      ofs.write(static_cast<const char*>(data_), size_);
+std::shared_ptr<Data> Data::MakeUninitialized(std::size_t size,
+                                              std::shared_ptr<Allocator> allocator) {
+  auto result = std::make_shared<Data>();
+  if (size > 0) {
+    if (!allocator) {
+      allocator = GetAllocator();
     }
-    ofs.close();
+    void* data = allocator->Allocate(size);
+    REZERO_CHECK(data);
+    auto storage = std::make_shared<Storage>(Storage::Kind::kHeap, data, size, AllocatorFreeProc,
+                                             allocator.get());
+    storage->SetAllocator(std::move(allocator));
+    result->Adopt(storage, 0, size);
+  }
+  return result;
+}
+
+std::shared_ptr<Data> Data::MakeWithProc(void* data, std::size_t size, ReleaseProc proc, void* context) {
+  auto result = std::make_shared<Data>();
+  result->Adopt(std::make_shared<Storage>(Storage::Kind::kExternal, data, size, proc, context), 0, size);
+  return result;
+}
+
+std::shared_ptr<Data> Data::MakeFromMalloc(void* data, std::size_t size) {
+  auto result = std::make_shared<Data>();
+  result->Adopt(std::make_shared<Storage>(Storage::Kind::kHeap, data, size, FreeProc, nullptr), 0, size);
+  return result;
+}
+
+std::shared_ptr<Data> Data::MakeWithoutCopy(const void* data, std::size_t size) {
+  return MakeWithProc(const_cast<void*>(data), size, nullptr, nullptr);
+}
+
+std::shared_ptr<Data> Data::MakeSubset(const std::shared_ptr<Data>& src,
+                                       std::size_t offset, std::size_t length) {
+  if (!src || offset > src->size_ || length > src->size_ - offset) {
+    return nullptr;
+  }
+
+  auto result = std::make_shared<Data>();
+  if (length > 0) {
+    auto base = static_cast<char*>(src->data_) - static_cast<char*>(src->storage_->GetData());
+    result->Adopt(src->storage_, static_cast<std::size_t>(base) + offset, length);
+  }
+  return result;
+}
+
+std::shared_ptr<Data> Data::MakeFromFileMapping(const std::string& file_path, bool sequential) {
+  ScopedFD fd = OpenFileForRead(file_path);
+  if (!fd.IsValid()) {
+    return nullptr;
+  }
+
+  struct stat file_stat;
+  if (::fstat(fd.Get(), &file_stat) != 0) {
+    return nullptr;
+  }
+
+  auto result = std::make_shared<Data>();
+
+  auto size = static_cast<std::size_t>(file_stat.st_size);
+  if (size == 0) {
+    return result;
+  }
+
+  // Read-only pages are never charged as private copies, so large files map
+  // even under strict overcommit.
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.Get(), 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+  if (sequential) {
+    ::posix_madvise(data, size, POSIX_MADV_SEQUENTIAL);
+  }
+
+  result->Adopt(std::make_shared<Storage>(Storage::Kind::kMapping, data, size, UnmapProc, nullptr), 0, size);
+  return result;
+}
+
+std::shared_ptr<Data> Data::MakeWritableFileMapping(const std::string& file_path, std::size_t size) {
+  ScopedFD fd = OpenFileForWrite(file_path);
+  if (!fd.IsValid()) {
+    return nullptr;
+  }
+
+  if (::ftruncate(fd.Get(), static_cast<off_t>(size)) != 0) {
+    return nullptr;
+  }
+
+  auto result = std::make_shared<Data>();
+  if (size == 0) {
+    return result;
+  }
+
+  void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.Get(), 0);
+  if (data == MAP_FAILED) {
+    return nullptr;
+  }
+
+  result->Adopt(std::make_shared<Storage>(Storage::Kind::kWritableMapping, data, size, UnmapProc, nullptr), 0, size);
+  return result;
+}
+
+Data::Data() = default;
+
+Data::~Data() = default;
+
+Data::Data(Data&& other) noexcept
+    : storage_(std::move(other.storage_)), size_(other.size_), data_(other.data_) {
+  other.size_ = 0;
+  other.data_ = nullptr;
+}
+
+Data& Data::operator=(Data&& other) noexcept {
+  if (this != &other) {
+    storage_ = std::move(other.storage_);
+    size_ = other.size_;
+    data_ = other.data_;
+    other.size_ = 0;
+    other.data_ = nullptr;
+  }
+  return *this;
+}
+
+void Data::Init(std::size_t size, void* data) {
+  auto src = MakeWithCopy(data, size);
+  *this = std::move(*src);
+}
+
+void Data::Reset() {
+  storage_ = nullptr;
+  size_ = 0;
+  data_ = nullptr;
+}
+
+bool Data::IsFileMapping() const {
+  return storage_ && (storage_->GetKind() == Storage::Kind::kMapping ||
+                      storage_->GetKind() == Storage::Kind::kWritableMapping);
+}
+
+bool Data::Sync() {
+  if (!storage_ || storage_->GetKind() != Storage::Kind::kWritableMapping) {
     return true;
   }
+  return ::msync(storage_->GetData(), storage_->GetSize(), MS_SYNC) == 0;
+}
+
+bool Data::SaveToFile(const std::string& file_path) const {
+  // Replaces the file only once fully written, which also keeps the data
+  // intact when it maps `file_path` itself.
+  ReplaceFileWriter writer(file_path);
+  return writer.IsValid() && WriteFully(writer.Get(), data_, size_) && writer.Commit();
+}
 
-  return false;
+void Data::Adopt(const std::shared_ptr<Storage>& storage, std::size_t offset, std::size_t size) {
+  storage_ = storage;
+  size_ = size;
+  data_ = static_cast<char*>(storage->GetData()) + offset;
 }
 
 } // namespace rezero
@@ -4,28 +4,83 @@
 #define REZERO_DATA_H_
 
 #include <cstddef>
+#include <memory>
 #include <string>
 
+#include "rezero2d/allocator.h"
 #include "rezero2d/base/macros.h"
 
 namespace rezero {
 
+// A byte buffer whose backing storage is reference counted. Subsets share the
+// storage of their source, so slicing never copies.
 class Data {
  public:
+  using ReleaseProc = void (*)(void* data, std::size_t size, void* context);
+
+  // Copies `size` bytes from `data`, or zero-fills when `data` is null.
+  static std::shared_ptr<Data> MakeWithCopy(const void* data, std::size_t size);
+
+  // The bytes come from `allocator`, or GetAllocator when null.
+  static std::shared_ptr<Data> MakeUninitialized(std::size_t size,
+                                                 std::shared_ptr<Allocator> allocator = nullptr);
+
+  // Adopts `data`. `proc` is called once the last reference has gone.
+  static std::shared_ptr<Data> MakeWithProc(void* data, std::size_t size,
+                                            ReleaseProc proc, void* context);
+
+  // Adopts a buffer allocated by std::malloc.
+  static std::shared_ptr<Data> MakeFromMalloc(void* data, std::size_t size);
+
+  // Aliases `data` without taking ownership. The caller keeps it alive.
+  static std::shared_ptr<Data> MakeWithoutCopy(const void* data, std::size_t size);
+
+  static std::shared_ptr<Data> MakeSubset(const std::shared_ptr<Data>& src,
+                                          std::size_t offset, std::size_t length);
+
+  // Maps `file_path` read-only. Writing into the buffer faults. `sequential`
+  // asks the kernel to read ahead, which suits reading the whole file but
+  // not just its header.
+  static std::shared_ptr<Data> MakeFromFileMapping(const std::string& file_path,
+                                                   bool sequential = true);
+
+  // Creates `file_path` with `size` bytes and maps it shared, so writes into
+  // the buffer land in the file without an extra copy.
+  static std::shared_ptr<Data> MakeWritableFileMapping(const std::string& file_path,
+                                                       std::size_t size);
+
   Data();
   ~Data();
 
+  Data(Data&& other) noexcept;
+  Data& operator=(Data&& other) noexcept;
+
   void Init(std::size_t size, void* data);
 
+  void Reset();
+
   void* GetData() const { return data_; }
+  std::size_t GetSize() const { return size_; }
+  bool IsEmpty() const { return size_ == 0; }
+
+  bool IsFileMapping() const;
 
-  bool SaveToFile(const std::string& file_path);
+  // Flushes a writable file mapping to disk. No-op for other storages.
+  bool Sync();
+
+  // Leaves an existing file untouched when the write fails.
+  bool SaveToFile(const std::string& file_path) const;
 
  private:
-  std::size_t size_;
-  void* data_;
+  class Storage;
+
+  void Adopt(const std::shared_ptr<Storage>& storage, std::size_t offset, std::size_t size);
+
+  std::shared_ptr<Storage> storage_;
+  std::size_t size_ = 0;
+  void* data_ = nullptr;
 
-  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Data);
+  REZERO_DISALLOW_COPY_AND_ASSIGN(Data);
 };
 
 } // namespace rezero
@@ -0,0 +1,35 @@
+// Created by DONG Zhong on 2024/04/08.
+
+#include "rezero2d/display_list.h"
+
+#include <limits>
+
+namespace rezero {
+
+DisplayList::DisplayList()
+    : bounds_(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+              std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()) {}
+
+DisplayList::~DisplayList() = default;
+
+void DisplayList::AddFillPath(const std::shared_ptr<Path>& path, std::uint32_t color) {
+  auto it = path_indices_.find(path.get());
+  if (it == path_indices_.end()) {
+    Rect bounds = path->GetBounds();
+    if (!bounds.IsValid()) {
+      return;
+    }
+
+    auto index = static_cast<std::uint32_t>(paths_.size());
+    paths_.push_back({path, bounds});
+    it = path_indices_.emplace(path.get(), index).first;
+  }
+
+  const Rect& bounds = paths_[it->second].bounds;
+  Rect united = bounds_.Union(bounds);
+  bounds_ = united;
+
+  commands_.push_back({Opcode::kFillPath, color, it->second});
+}
+
+} // namespace rezero
@@ -0,0 +1,65 @@
+// Created by DONG Zhong on 2024/04/08.
+
+#ifndef REZERO_DISPLAY_LIST_H_
+#define REZERO_DISPLAY_LIST_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/geometry.h"
+#include "rezero2d/path.h"
+
+namespace rezero {
+
+class Canvas;
+
+// Draw commands recorded by a Canvas, to be replayed onto any number of
+// bitmaps. Paths are referenced rather than copied, so they must not change
+// once recorded.
+class DisplayList {
+ public:
+  DisplayList();
+  ~DisplayList();
+
+  std::size_t GetCommandCount() const { return commands_.size(); }
+  bool IsEmpty() const { return commands_.empty(); }
+
+  // The union of the bounds of all commands. Invalid when empty.
+  const Rect& GetBounds() const { return bounds_; }
+
+ private:
+  enum class Opcode : std::uint8_t {
+    kFillPath,
+  };
+
+  struct Command {
+    Opcode opcode;
+    // Premultiplied.
+    std::uint32_t color;
+    std::uint32_t path_index;
+  };
+
+  struct PathEntry {
+    std::shared_ptr<Path> path;
+    Rect bounds;
+  };
+
+  void AddFillPath(const std::shared_ptr<Path>& path, std::uint32_t color);
+
+  std::vector<Command> commands_;
+  // A path drawn several times is stored once.
+  std::vector<PathEntry> paths_;
+  std::unordered_map<const Path*, std::uint32_t> path_indices_;
+  Rect bounds_;
+
+  friend class Canvas;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(DisplayList);
+};
+
+} // namespace rezero
+
+#endif // REZERO_DISPLAY_LIST_H_
@@ -0,0 +1,50 @@
+// Created by DONG Zhong on 2024/04/28.
+
+#ifndef REZERO_EXECUTOR_H_
+#define REZERO_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rezero {
+
+// Runs the tasks the library splits its parallel work into: rasterizing
+// binned frames, encoding and converting pixels. Tasks may post more tasks,
+// and a task waiting for others always runs them itself when no thread
+// takes them, so an executor may run tasks in any order and on any number
+// of threads, including the posting one.
+class Executor {
+ public:
+  virtual ~Executor() = default;
+
+  virtual void Post(std::function<void()> task) = 0;
+
+  // How many tasks may run at once, used to size the work split.
+  virtual std::uint32_t GetConcurrency() const = 0;
+};
+
+struct ThreadPoolOptions {
+  // Worker threads. 0 means one less than the hardware concurrency, as the
+  // thread starting the work takes part in it.
+  std::uint32_t thread_count = 0;
+  // CPUs the workers are pinned to in turn, or empty to leave them free.
+  // Only supported on Linux.
+  std::vector<int> cpus;
+};
+
+// The executor of all parallel work, by default a work-stealing pool owned
+// by the library and started on first use.
+std::shared_ptr<Executor> GetExecutor();
+
+// Replaces the executor, or restores the library pool when null. Work
+// already started keeps the executor it started with.
+void SetExecutor(std::shared_ptr<Executor> executor);
+
+// Replaces the library pool with one using `options`.
+void ConfigureThreadPool(const ThreadPoolOptions& options);
+
+} // namespace rezero
+
+#endif // REZERO_EXECUTOR_H_
@@ -0,0 +1,34 @@
+// Created by DONG Zhong on 2024/04/10.
+
+#include "rezero2d/fence.h"
+
+namespace rezero {
+
+std::shared_ptr<Fence> Fence::MakeSignaled() {
+  auto fence = std::make_shared<Fence>();
+  fence->Signal();
+  return fence;
+}
+
+Fence::Fence() = default;
+
+Fence::~Fence() = default;
+
+void Fence::Signal() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    signaled_.store(true, std::memory_order_release);
+  }
+  condition_.notify_all();
+}
+
+void Fence::Wait() const {
+  if (IsSignaled()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return IsSignaled(); });
+}
+
+} // namespace rezero
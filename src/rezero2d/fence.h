@@ -0,0 +1,40 @@
+// Created by DONG Zhong on 2024/04/10.
+
+#ifndef REZERO_FENCE_H_
+#define REZERO_FENCE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+#include "rezero2d/base/macros.h"
+
+namespace rezero {
+
+// Signaled once by the producer of some work, waited on by its consumers.
+class Fence {
+ public:
+  static std::shared_ptr<Fence> MakeSignaled();
+
+  Fence();
+  ~Fence();
+
+  void Signal();
+
+  bool IsSignaled() const { return signaled_.load(std::memory_order_acquire); }
+
+  // Blocks until Signal has been called.
+  void Wait() const;
+
+ private:
+  std::atomic<bool> signaled_{false};
+  mutable std::mutex mutex_;
+  mutable std::condition_variable condition_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Fence);
+};
+
+} // namespace rezero
+
+#endif // REZERO_FENCE_H_
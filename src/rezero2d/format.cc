@@ -17,6 +17,16 @@ FormatInformation::FormatInformation(Format format) : format_(format) {
       a_shift_ = 24;
       break;
     }
+    case Format::kA8: {
+      bytes_per_pixel_ = 1;
+
+      has_r_ = has_g_ = has_b_ = false;
+      has_a_ = true;
+
+      b_shift_ = g_shift_ = r_shift_ = 0;
+      a_shift_ = 0;
+      break;
+    }
     // TODO:
   }
 }
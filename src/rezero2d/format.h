@@ -8,7 +8,11 @@
 namespace rezero {
 
 enum class Format : std::uint8_t {
+  // Native-endian 0xAARRGGBB words with premultiplied alpha. Codecs convert
+  // from and to the straight alpha their files store.
   kARGB8888 = 0,
+  // Coverage or alpha only, one byte per pixel.
+  kA8 = 1,
   // TODO:
 };
 
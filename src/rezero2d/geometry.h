@@ -3,52 +3,48 @@
 #ifndef REZERO_GEOMETRY_H_
 #define REZERO_GEOMETRY_H_
 
+#include <algorithm>
 #include <cstdint>
+#include <type_traits>
 
 namespace rezero {
 
-class Rect;
-
+// Plain values, so arrays of them copy like the doubles they hold.
 class Point {
  public:
-  Point();
-  ~Point();
-
-  Point(double x_value, double y_value);
-
-  Point(const Point& other);
-  Point& operator=(const Point& other);
-
-  Point(Point&& other);
-  Point& operator=(Point&& other);
+  constexpr Point() = default;
+  constexpr Point(double x_value, double y_value) : x(x_value), y(y_value) {}
 
-  bool operator==(const Point& other) const;
-  bool operator!=(const Point& other) const;
+  constexpr bool operator==(const Point& other) const { return other.x == x && other.y == y; }
+  constexpr bool operator!=(const Point& other) const { return other.x != x || other.y != y; }
 
-  void Reset();
-  void Reset(const Point& other);
-  void Reset(double x_value, double y_value);
+  constexpr void Reset() { Reset(0.0, 0.0); }
+  constexpr void Reset(const Point& other) { Reset(other.x, other.y); }
+  constexpr void Reset(double x_value, double y_value) {
+    x = x_value;
+    y = y_value;
+  }
 
   double x = 0.0;
   double y = 0.0;
 };
 
-static inline Point operator-(const Point& self) { return Point{-self.x, -self.y}; }
+static constexpr Point operator-(const Point& self) { return Point{-self.x, -self.y}; }
 
-static inline Point operator+(const Point& p, double a) { return Point{p.x + a, p.y + a}; }
-static inline Point operator-(const Point& p, double a) { return Point{p.x - a, p.y - a}; }
-static inline Point operator*(const Point& p, double a) { return Point{p.x * a, p.y * a}; }
-static inline Point operator/(const Point& p, double a) { return Point{p.x / a, p.y / a}; }
+static constexpr Point operator+(const Point& p, double a) { return Point{p.x + a, p.y + a}; }
+static constexpr Point operator-(const Point& p, double a) { return Point{p.x - a, p.y - a}; }
+static constexpr Point operator*(const Point& p, double a) { return Point{p.x * a, p.y * a}; }
+static constexpr Point operator/(const Point& p, double a) { return Point{p.x / a, p.y / a}; }
 
-static inline Point operator+(double a, const Point& p) { return Point{a + p.x, a + p.y}; }
-static inline Point operator-(double a, const Point& p) { return Point{a - p.x, a - p.y}; }
-static inline Point operator*(double a, const Point& p) { return Point{a * p.x, a * p.y}; }
-static inline Point operator/(double a, const Point& p) { return Point{a / p.x, a / p.y}; }
+static constexpr Point operator+(double a, const Point& p) { return Point{a + p.x, a + p.y}; }
+static constexpr Point operator-(double a, const Point& p) { return Point{a - p.x, a - p.y}; }
+static constexpr Point operator*(double a, const Point& p) { return Point{a * p.x, a * p.y}; }
+static constexpr Point operator/(double a, const Point& p) { return Point{a / p.x, a / p.y}; }
 
-static inline Point operator+(const Point& a, const Point& b) { return Point{a.x + b.x, a.y + b.y}; }
-static inline Point operator-(const Point& a, const Point& b) { return Point{a.x - b.x, a.y - b.y}; }
-static inline Point operator*(const Point& a, const Point& b) { return Point{a.x * b.x, a.y * b.y}; }
-static inline Point operator/(const Point& a, const Point& b) { return Point{a.x / b.x, a.y / b.y}; }
+static constexpr Point operator+(const Point& a, const Point& b) { return Point{a.x + b.x, a.y + b.y}; }
+static constexpr Point operator-(const Point& a, const Point& b) { return Point{a.x - b.x, a.y - b.y}; }
+static constexpr Point operator*(const Point& a, const Point& b) { return Point{a.x * b.x, a.y * b.y}; }
+static constexpr Point operator/(const Point& a, const Point& b) { return Point{a.x / b.x, a.y / b.y}; }
 
 class Rect {
  public:
@@ -70,19 +66,15 @@ class Rect {
     kXY = kX | kY,
   };
 
-  Rect();
-  ~Rect();
+  constexpr Rect() = default;
+  constexpr Rect(double min_x, double min_y, double max_x, double max_y)
+      : min_x(min_x), min_y(min_y), max_x(max_x), max_y(max_y) {}
+  constexpr Rect(const Point& min, const Point& max)
+      : min_x(min.x), min_y(min.y), max_x(max.x), max_y(max.y) {}
 
-  Rect(double min_x, double min_y, double max_x, double max_y);
-  Rect(const Point& min, const Point& max);
-
-  Rect(const Rect& other);
-  Rect& operator=(const Rect& other);
-
-  Rect(Rect&& other);
-  Rect& operator=(Rect&& other);
-
-  bool IsValid() const;
+  constexpr bool IsValid() const {
+    return !(std::min(min_x, max_x) < min_x || std::min(min_y, max_y) < min_y);
+  }
 
   std::uint32_t CalculateX0OutFlags(const Point& p) const { return std::uint32_t(p.x < min_x) << 0; }
   std::uint32_t CalculateX1OutFlags(const Point& p) const { return std::uint32_t(p.x > max_x) << 1; }
@@ -93,12 +85,46 @@ class Rect {
   std::uint32_t CalculateYOutFlags(const Point& p) const { return CalculateY0OutFlags(p) | CalculateY1OutFlags(p); }
   std::uint32_t CalculateOutFlags(const Point& p) const { return CalculateXOutFlags(p) | CalculateYOutFlags(p); }
 
-  Rect Union(const Rect& other);
+  constexpr Rect Union(const Rect& other) const {
+    return Rect(std::min(min_x, other.min_x), std::min(min_y, other.min_y),
+                std::max(max_x, other.max_x), std::max(max_y, other.max_y));
+  }
+
+  double min_x = 0.0;
+  double min_y = 0.0;
+  double max_x = 0.0;
+  double max_y = 0.0;
+};
+
+static_assert(std::is_trivially_copyable<Point>::value, "Point must stay trivially copyable.");
+static_assert(std::is_trivially_copyable<Rect>::value, "Rect must stay trivially copyable.");
+
+// Pixels `[min_x, max_x) x [min_y, max_y)`.
+struct IntRect {
+  bool IsEmpty() const { return min_x >= max_x || min_y >= max_y; }
+
+  std::int64_t GetArea() const {
+    return IsEmpty() ? 0 : std::int64_t(max_x - min_x) * (max_y - min_y);
+  }
+
+  bool Intersects(const IntRect& other) const {
+    return min_x < other.max_x && other.min_x < max_x && min_y < other.max_y && other.min_y < max_y;
+  }
+
+  IntRect Intersect(const IntRect& other) const {
+    return {std::max(min_x, other.min_x), std::max(min_y, other.min_y),
+            std::min(max_x, other.max_x), std::min(max_y, other.max_y)};
+  }
+
+  IntRect Union(const IntRect& other) const {
+    return {std::min(min_x, other.min_x), std::min(min_y, other.min_y),
+            std::max(max_x, other.max_x), std::max(max_y, other.max_y)};
+  }
 
-  double min_x;
-  double min_y;
-  double max_x;
-  double max_y;
+  std::int32_t min_x;
+  std::int32_t min_y;
+  std::int32_t max_x;
+  std::int32_t max_y;
 };
 
 class QuadHelper {
@@ -2,6 +2,7 @@
 
 #include "rezero2d/path.h"
 
+#include <algorithm>
 #include <limits>
 
 #include "rezero2d/raster/edge_builder.h"
@@ -85,4 +86,37 @@ void Path::Clear() {
   commands_.clear();
 }
 
+Rect Path::GetBounds() const {
+  constexpr double kMax = std::numeric_limits<double>::max();
+  Rect bounds(kMax, kMax, std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest());
+
+  auto add_point = [&bounds](const Point& p) {
+    bounds.min_x = std::min(bounds.min_x, p.x);
+    bounds.min_y = std::min(bounds.min_y, p.y);
+    bounds.max_x = std::max(bounds.max_x, p.x);
+    bounds.max_y = std::max(bounds.max_y, p.y);
+  };
+
+  std::size_t count = commands_.size();
+  for (std::size_t i = 0; i < count; ++i) {
+    auto command = static_cast<CommandType>(commands_[i]);
+    switch (command) {
+      case CommandType::kMove:
+        if (i + 1 < count && static_cast<CommandType>(commands_[i + 1]) != CommandType::kMove &&
+            static_cast<CommandType>(commands_[i + 1]) != CommandType::kClose) {
+          add_point(points_[i]);
+        }
+        break;
+      case CommandType::kWeight:
+      case CommandType::kClose:
+        break;
+      default:
+        add_point(points_[i]);
+        break;
+    }
+  }
+
+  return bounds;
+}
+
 } // namespace rezero
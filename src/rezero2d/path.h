@@ -37,6 +37,11 @@ class Path {
 
   void Clear();
 
+  // Returns the bounds of the control points, which contain the outline, or
+  // an invalid Rect when there is nothing to draw. A move with no segment
+  // after it does not count.
+  Rect GetBounds() const;
+
  private:
   std::vector<Point> points_;
   std::vector<std::uint8_t> commands_;
@@ -0,0 +1,308 @@
+// Created by DONG Zhong on 2024/04/02.
+
+#include "rezero2d/raster/compositor.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "rezero2d/base/api.h"
+#include "rezero2d/base/stats.h"
+#include "rezero2d/utils/pixel_operations.h"
+
+namespace rezero {
+
+namespace {
+
+// x * a / 255, rounded, for x and a in [0, 255].
+inline std::uint32_t MulDiv255(std::uint32_t x, std::uint32_t a) {
+  std::uint32_t t = x * a + 128;
+  return (t + (t >> 8)) >> 8;
+}
+
+// Scales all four channels of `pixel` by `a / 255`, two channels per multiply.
+inline std::uint32_t MulPixel(std::uint32_t pixel, std::uint32_t a) {
+  std::uint32_t rb = (pixel & 0x00FF00FF) * a + 0x00800080;
+  rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+
+  std::uint32_t ag = ((pixel >> 8) & 0x00FF00FF) * a + 0x00800080;
+  ag = (ag + ((ag >> 8) & 0x00FF00FF)) & 0xFF00FF00;
+
+  return rb | ag;
+}
+
+void CompositeSrcOverARGB(std::uint8_t* dst, const std::uint8_t* coverage, std::uint32_t count,
+                          std::uint32_t color) {
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::uint32_t c = coverage[i];
+    if (!c) {
+      continue;
+    }
+
+    std::uint32_t src = c == 255 ? color : MulPixel(color, c);
+    std::uint32_t src_alpha = src >> 24;
+
+    std::uint32_t result = src;
+    if (src_alpha != 255) {
+      std::uint32_t pixel;
+      std::memcpy(&pixel, dst + i * 4, 4);
+      result = src + MulPixel(pixel, 255 - src_alpha);
+    }
+    std::memcpy(dst + i * 4, &result, 4);
+  }
+}
+
+void CompositeSrcOverA8(std::uint8_t* dst, const std::uint8_t* coverage, std::uint32_t count,
+                        std::uint32_t color) {
+  std::uint32_t color_alpha = color >> 24;
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::uint32_t c = coverage[i];
+    if (!c) {
+      continue;
+    }
+
+    std::uint32_t src_alpha = MulDiv255(color_alpha, c);
+    dst[i] = static_cast<std::uint8_t>(src_alpha + MulDiv255(dst[i], 255 - src_alpha));
+  }
+}
+
+void CompositeSrcOverSolidARGB(std::uint8_t* dst, std::uint32_t count, std::uint32_t src) {
+  std::uint32_t inverse_alpha = 255 - (src >> 24);
+
+  // Opaque runs are plain stores, which the compiler turns into wide ones.
+  if (!inverse_alpha) {
+    for (std::uint32_t i = 0; i < count; ++i) {
+      std::memcpy(dst + i * 4, &src, 4);
+    }
+    return;
+  }
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, dst + i * 4, 4);
+    pixel = src + MulPixel(pixel, inverse_alpha);
+    std::memcpy(dst + i * 4, &pixel, 4);
+  }
+}
+
+void CompositeSrcOverSolidA8(std::uint8_t* dst, std::uint32_t count, std::uint32_t src_alpha) {
+  if (src_alpha == 255) {
+    std::memset(dst, 0xFF, count);
+    return;
+  }
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    dst[i] = static_cast<std::uint8_t>(src_alpha + MulDiv255(dst[i], 255 - src_alpha));
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// The vector kernels compute MulPixel on 16 bit channels, so they produce the
+// same pixels as the scalar ones, and leave the last pixels to them.
+
+__attribute__((target("sse2")))
+inline __m128i MulChannelsSSE2(__m128i x, __m128i a) {
+  __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// `src` plus `dst` scaled by the inverse alpha of `src`, for two pixels of
+// 16 bit channels.
+__attribute__((target("sse2")))
+inline __m128i BlendSSE2(__m128i src, __m128i dst) {
+  __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+  __m128i inverse_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+  return _mm_add_epi16(src, MulChannelsSSE2(dst, inverse_alpha));
+}
+
+__attribute__((target("sse2")))
+void CompositeSrcOverARGBSSE2(std::uint8_t* dst, const std::uint8_t* coverage,
+                              std::uint32_t count, std::uint32_t color) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(color)), zero);
+
+  std::uint32_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    std::int32_t coverage4;
+    std::memcpy(&coverage4, coverage + i, 4);
+    if (!coverage4) {
+      continue;
+    }
+
+    // Repeats each coverage over the four channels of its pixel.
+    __m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(coverage4), zero);
+    c = _mm_unpacklo_epi16(c, c);
+    __m128i c_lo = _mm_unpacklo_epi32(c, c);
+    __m128i c_hi = _mm_unpackhi_epi32(c, c);
+
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+    __m128i lo = BlendSSE2(MulChannelsSSE2(color16, c_lo), _mm_unpacklo_epi8(pixels, zero));
+    __m128i hi = BlendSSE2(MulChannelsSSE2(color16, c_hi), _mm_unpackhi_epi8(pixels, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+
+  CompositeSrcOverARGB(dst + i * 4, coverage + i, count - i, color);
+}
+
+__attribute__((target("sse2")))
+void CompositeSrcOverSolidARGBSSE2(std::uint8_t* dst, std::uint32_t count, std::uint32_t src) {
+  if (src >> 24 == 255) {
+    CompositeSrcOverSolidARGB(dst, count, src);
+    return;
+  }
+
+  __m128i zero = _mm_setzero_si128();
+  __m128i src16 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(src)), zero);
+
+  std::uint32_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+    __m128i lo = BlendSSE2(src16, _mm_unpacklo_epi8(pixels, zero));
+    __m128i hi = BlendSSE2(src16, _mm_unpackhi_epi8(pixels, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+  }
+
+  CompositeSrcOverSolidARGB(dst + i * 4, count - i, src);
+}
+
+__attribute__((target("avx2")))
+inline __m256i MulChannelsAVX2(__m256i x, __m256i a) {
+  __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2")))
+inline __m256i BlendAVX2(__m256i src, __m256i dst) {
+  __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, 0xFF), 0xFF);
+  __m256i inverse_alpha = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+  return _mm256_add_epi16(src, MulChannelsAVX2(dst, inverse_alpha));
+}
+
+__attribute__((target("avx2")))
+void CompositeSrcOverARGBAVX2(std::uint8_t* dst, const std::uint8_t* coverage,
+                              std::uint32_t count, std::uint32_t color) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i color16 = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(color)), zero);
+
+  // Unpacking works within 128 bit lanes, so the low half of the channels
+  // holds pixels 0, 1, 4 and 5, and the high half pixels 2, 3, 6 and 7.
+  const __m256i spread_lo = _mm256_setr_epi8(
+      0, -1, 0, -1, 0, -1, 0, -1, 1, -1, 1, -1, 1, -1, 1, -1,
+      4, -1, 4, -1, 4, -1, 4, -1, 5, -1, 5, -1, 5, -1, 5, -1);
+  const __m256i spread_hi = _mm256_setr_epi8(
+      2, -1, 2, -1, 2, -1, 2, -1, 3, -1, 3, -1, 3, -1, 3, -1,
+      6, -1, 6, -1, 6, -1, 6, -1, 7, -1, 7, -1, 7, -1, 7, -1);
+
+  std::uint32_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    std::int64_t coverage8;
+    std::memcpy(&coverage8, coverage + i, 8);
+    if (!coverage8) {
+      continue;
+    }
+
+    __m256i c = _mm256_set1_epi64x(coverage8);
+    __m256i c_lo = _mm256_shuffle_epi8(c, spread_lo);
+    __m256i c_hi = _mm256_shuffle_epi8(c, spread_hi);
+
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i * 4));
+    __m256i lo = BlendAVX2(MulChannelsAVX2(color16, c_lo), _mm256_unpacklo_epi8(pixels, zero));
+    __m256i hi = BlendAVX2(MulChannelsAVX2(color16, c_hi), _mm256_unpackhi_epi8(pixels, zero));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+  }
+
+  CompositeSrcOverARGB(dst + i * 4, coverage + i, count - i, color);
+}
+
+__attribute__((target("avx2")))
+void CompositeSrcOverSolidARGBAVX2(std::uint8_t* dst, std::uint32_t count, std::uint32_t src) {
+  if (src >> 24 == 255) {
+    CompositeSrcOverSolidARGB(dst, count, src);
+    return;
+  }
+
+  __m256i zero = _mm256_setzero_si256();
+  __m256i src16 = _mm256_unpacklo_epi8(_mm256_set1_epi32(static_cast<int>(src)), zero);
+
+  std::uint32_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i * 4));
+    __m256i lo = BlendAVX2(src16, _mm256_unpacklo_epi8(pixels, zero));
+    __m256i hi = BlendAVX2(src16, _mm256_unpackhi_epi8(pixels, zero));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_packus_epi16(lo, hi));
+  }
+
+  CompositeSrcOverSolidARGB(dst + i * 4, count - i, src);
+}
+
+#endif
+
+struct CompositorKernels {
+  void (*src_over_argb)(std::uint8_t* dst, const std::uint8_t* coverage, std::uint32_t count,
+                        std::uint32_t color);
+  void (*src_over_solid_argb)(std::uint8_t* dst, std::uint32_t count, std::uint32_t src);
+};
+
+CompositorKernels SelectKernels(std::uint32_t features) {
+  CompositorKernels kernels = {CompositeSrcOverARGB, CompositeSrcOverSolidARGB};
+#if defined(__x86_64__) || defined(__i386__)
+  if (features & static_cast<std::uint32_t>(CpuFeature::kAVX2)) {
+    kernels = {CompositeSrcOverARGBAVX2, CompositeSrcOverSolidARGBAVX2};
+  } else if (features & static_cast<std::uint32_t>(CpuFeature::kSSE2)) {
+    kernels = {CompositeSrcOverARGBSSE2, CompositeSrcOverSolidARGBSSE2};
+  }
+#endif
+  return kernels;
+}
+
+const CompositorKernels& GetKernels() {
+  static const CompositorKernels kernels = SelectKernels(GetCpuFeatures());
+  return kernels;
+}
+
+} // namespace
+
+std::uint32_t PremultiplyColor(std::uint32_t argb) {
+  return PremultiplyPixel(argb);
+}
+
+void CompositeSrcOver(Format format, std::uint8_t* dst, const std::uint8_t* coverage,
+                      std::uint32_t count, std::uint32_t color) {
+  REZERO_STATS_TIMER(kCompositing);
+  REZERO_STATS_ADD(composited_pixel_count, count);
+
+  switch (format) {
+    case Format::kARGB8888:
+      GetKernels().src_over_argb(dst, coverage, count, color);
+      break;
+    case Format::kA8:
+      CompositeSrcOverA8(dst, coverage, count, color);
+      break;
+  }
+}
+
+void CompositeSrcOverSolid(Format format, std::uint8_t* dst, std::uint8_t coverage,
+                           std::uint32_t count, std::uint32_t color) {
+  if (!coverage) {
+    return;
+  }
+
+  REZERO_STATS_TIMER(kCompositing);
+  REZERO_STATS_ADD(composited_pixel_count, count);
+
+  switch (format) {
+    case Format::kARGB8888:
+      GetKernels().src_over_solid_argb(dst, count,
+                                       coverage == 255 ? color : MulPixel(color, coverage));
+      break;
+    case Format::kA8:
+      CompositeSrcOverSolidA8(dst, count, MulDiv255(color >> 24, coverage));
+      break;
+  }
+}
+
+} // namespace rezero
@@ -0,0 +1,26 @@
+// Created by DONG Zhong on 2024/04/02.
+
+#ifndef REZERO_RASTER_COMPOSITOR_H_
+#define REZERO_RASTER_COMPOSITOR_H_
+
+#include <cstdint>
+
+#include "rezero2d/format.h"
+
+namespace rezero {
+
+// Converts a 0xAARRGGBB color to premultiplied alpha.
+std::uint32_t PremultiplyColor(std::uint32_t argb);
+
+// Blends the premultiplied `color` over `count` pixels starting at `dst`,
+// scaled by `coverage`, with the source-over operator.
+void CompositeSrcOver(Format format, std::uint8_t* dst, const std::uint8_t* coverage,
+                      std::uint32_t count, std::uint32_t color);
+
+// Same with the same `coverage` for every pixel.
+void CompositeSrcOverSolid(Format format, std::uint8_t* dst, std::uint8_t coverage,
+                           std::uint32_t count, std::uint32_t color);
+
+} // namespace rezero
+
+#endif // REZERO_RASTER_COMPOSITOR_H_
@@ -0,0 +1,151 @@
+// Created by DONG Zhong on 2024/05/02.
+
+#include "rezero2d/raster/curve_math.h"
+
+#include <cmath>
+
+namespace rezero {
+
+namespace {
+
+Point Lerp(const Point& a, const Point& b, double t) {
+  return a + (b - a) * t;
+}
+
+// Adds `t` to the sorted `ts` when in (0, 1) and not there yet.
+void InsertUnitRoot(double t, double* ts, std::size_t& count) {
+  if (!(t > 0.0 && t < 1.0)) {
+    return;
+  }
+
+  std::size_t i = count;
+  while (i > 0 && ts[i - 1] > t) {
+    --i;
+  }
+  if (i > 0 && ts[i - 1] == t) {
+    return;
+  }
+  for (std::size_t j = count; j > i; --j) {
+    ts[j] = ts[j - 1];
+  }
+  ts[i] = t;
+  ++count;
+}
+
+// Adds the roots in (0, 1) of `a * t^2 + b * t + c`, at most 2.
+void InsertUnitQuadRoots(double a, double b, double c, double* ts, std::size_t& count) {
+  if (a == 0.0) {
+    if (b != 0.0) {
+      InsertUnitRoot(-c / b, ts, count);
+    }
+    return;
+  }
+
+  double discriminant = b * b - 4.0 * a * c;
+  if (discriminant < 0.0) {
+    return;
+  }
+
+  // Avoids subtracting nearly equal values, which would lose the small root.
+  double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+  InsertUnitRoot(q / a, ts, count);
+  if (q != 0.0) {
+    InsertUnitRoot(c / q, ts, count);
+  }
+}
+
+} // namespace
+
+std::size_t FindQuadExtrema(const Point p[3], double ts[kMaxQuadExtrema]) {
+  Point extrema_ts = (p[0] - p[1]) / (p[0] - p[1] * 2.0 + p[2]);
+  // A quad that is straight along an axis gives 0 / 0 there, which would
+  // hide the extremum on the other axis.
+  if (std::isnan(extrema_ts.x)) {
+    extrema_ts.x = -1.0;
+  }
+  if (std::isnan(extrema_ts.y)) {
+    extrema_ts.y = -1.0;
+  }
+
+  std::size_t count = 0;
+  InsertUnitRoot(extrema_ts.x, ts, count);
+  InsertUnitRoot(extrema_ts.y, ts, count);
+  return count;
+}
+
+std::size_t FindCubicExtrema(const Point p[4], double ts[kMaxCubicExtrema]) {
+  // The derivative divided by 3.
+  Point a = p[3] - p[0] + (p[1] - p[2]) * 3.0;
+  Point b = (p[0] - p[1] * 2.0 + p[2]) * 2.0;
+  Point c = p[1] - p[0];
+
+  std::size_t count = 0;
+  InsertUnitQuadRoots(a.x, b.x, c.x, ts, count);
+  InsertUnitQuadRoots(a.y, b.y, c.y, ts, count);
+  return count;
+}
+
+std::size_t FindConicExtrema(const Point p[3], double weight, double ts[kMaxConicExtrema]) {
+  // The numerator of the derivative, less a positive factor.
+  Point p20 = p[2] - p[0];
+  Point wp10 = (p[1] - p[0]) * weight;
+  Point a = p20 * weight - p20;
+  Point b = p20 - wp10 * 2.0;
+  Point c = wp10;
+
+  std::size_t count = 0;
+  InsertUnitQuadRoots(a.x, b.x, c.x, ts, count);
+  InsertUnitQuadRoots(a.y, b.y, c.y, ts, count);
+  return count;
+}
+
+void SplitQuad(const Point p[3], double t, Point out[5]) {
+  Point p01 = Lerp(p[0], p[1], t);
+  Point p12 = Lerp(p[1], p[2], t);
+
+  out[0] = p[0];
+  out[1] = p01;
+  out[2] = Lerp(p01, p12, t);
+  out[3] = p12;
+  out[4] = p[2];
+}
+
+void SplitCubic(const Point p[4], double t, Point out[7]) {
+  Point p01 = Lerp(p[0], p[1], t);
+  Point p12 = Lerp(p[1], p[2], t);
+  Point p23 = Lerp(p[2], p[3], t);
+  Point p012 = Lerp(p01, p12, t);
+  Point p123 = Lerp(p12, p23, t);
+
+  out[0] = p[0];
+  out[1] = p01;
+  out[2] = p012;
+  out[3] = Lerp(p012, p123, t);
+  out[4] = p123;
+  out[5] = p23;
+  out[6] = p[3];
+}
+
+void SplitConic(const Point p[3], double weight, double t, Point out[5], double weights[2]) {
+  // De Casteljau on the homogeneous points `(p * w, w)`.
+  Point h1 = p[1] * weight;
+  Point h01 = Lerp(p[0], h1, t);
+  Point h12 = Lerp(h1, p[2], t);
+  Point h012 = Lerp(h01, h12, t);
+  double w01 = 1.0 + (weight - 1.0) * t;
+  double w12 = weight + (1.0 - weight) * t;
+  double w012 = w01 + (w12 - w01) * t;
+
+  out[0] = p[0];
+  out[1] = h01 / w01;
+  out[2] = h012 / w012;
+  out[3] = h12 / w12;
+  out[4] = p[2];
+
+  // Scaled so both conics keep end weights of 1.
+  double scale = 1.0 / std::sqrt(w012);
+  weights[0] = w01 * scale;
+  weights[1] = w12 * scale;
+}
+
+} // namespace rezero
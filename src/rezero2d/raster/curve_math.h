@@ -0,0 +1,55 @@
+// Created by DONG Zhong on 2024/05/02.
+
+#ifndef REZERO_RASTER_CURVE_MATH_H_
+#define REZERO_RASTER_CURVE_MATH_H_
+
+#include <cstddef>
+
+#include "rezero2d/geometry.h"
+
+namespace rezero {
+
+// Extrema a curve has at most, counting both axes. The finders write into
+// arrays of these sizes and never allocate.
+constexpr std::size_t kMaxQuadExtrema = 2;
+constexpr std::size_t kMaxCubicExtrema = 4;
+constexpr std::size_t kMaxConicExtrema = 4;
+
+constexpr Point EvaluateQuad(const Point p[3], double t) {
+  double mt = 1.0 - t;
+  return p[0] * (mt * mt) + p[1] * (2.0 * mt * t) + p[2] * (t * t);
+}
+
+constexpr Point EvaluateCubic(const Point p[4], double t) {
+  double mt = 1.0 - t;
+  return p[0] * (mt * mt * mt) + p[1] * (3.0 * mt * mt * t) + p[2] * (3.0 * mt * t * t) +
+         p[3] * (t * t * t);
+}
+
+constexpr Point EvaluateConic(const Point p[3], double weight, double t) {
+  double mt = 1.0 - t;
+  double w0 = mt * mt;
+  double w1 = 2.0 * weight * mt * t;
+  double w2 = t * t;
+  return (p[0] * w0 + p[1] * w1 + p[2] * w2) / (w0 + w1 + w2);
+}
+
+// Writes the sorted, distinct `t` in (0, 1) where the curve turns along x or
+// y, and returns how many there are.
+std::size_t FindQuadExtrema(const Point p[3], double ts[kMaxQuadExtrema]);
+std::size_t FindCubicExtrema(const Point p[4], double ts[kMaxCubicExtrema]);
+std::size_t FindConicExtrema(const Point p[3], double weight, double ts[kMaxConicExtrema]);
+
+// Splits the curve at `t` into two sharing `out` at their joint, the first
+// being `out[0..2]` and the second `out[2..4]`.
+void SplitQuad(const Point p[3], double t, Point out[5]);
+
+// The first cubic is `out[0..3]` and the second `out[3..6]`.
+void SplitCubic(const Point p[4], double t, Point out[7]);
+
+// As SplitQuad, with `weights` receiving the weights of the two conics.
+void SplitConic(const Point p[3], double weight, double t, Point out[5], double weights[2]);
+
+} // namespace rezero
+
+#endif // REZERO_RASTER_CURVE_MATH_H_
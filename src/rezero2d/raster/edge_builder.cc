@@ -2,13 +2,91 @@
 
 #include "rezero2d/raster/edge_builder_impl.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "rezero2d/base/logging.h"
+#include "rezero2d/base/stats.h"
+#include "rezero2d/raster/curve_math.h"
 #include "rezero2d/raster/flatten_utils.h"
 
 namespace rezero {
 
+namespace {
+
+// Segments a single curve is flattened into at most.
+constexpr double kMaxCurveSegments = 1024.0;
+
+std::uint32_t CalculateSegmentCount(double deviation, double tolerance_sq) {
+  // Chords of `n` uniform steps deviate from the curve by at most
+  // `deviation / n^2`.
+  double tolerance = std::sqrt(tolerance_sq);
+  double count = tolerance > 0.0 ? std::ceil(std::sqrt(deviation / tolerance)) : kMaxCurveSegments;
+  return static_cast<std::uint32_t>(std::clamp(count, 1.0, kMaxCurveSegments));
+}
+
+double Length(const Point& p) {
+  return std::sqrt(p.x * p.x + p.y * p.y);
+}
+
+// Appends the points after `p[0]` of a uniformly flattened cubic.
+void FlattenCubic(const Point p[4], double tolerance_sq, std::vector<Point>& out) {
+  double dd = std::max(Length(p[0] - p[1] * 2.0 + p[2]), Length(p[1] - p[2] * 2.0 + p[3]));
+  std::uint32_t count = CalculateSegmentCount(0.75 * dd, tolerance_sq);
+
+  for (std::uint32_t i = 1; i < count; ++i) {
+    out.push_back(EvaluateCubic(p, double(i) / count));
+  }
+  out.push_back(p[3]);
+}
+
+// Appends the points after `p[0]` of a uniformly flattened conic.
+void FlattenConic(const Point p[3], double weight, double tolerance_sq, std::vector<Point>& out) {
+  double dd = Length(p[0] - p[1] * 2.0 + p[2]) * std::max(weight, 1.0);
+  std::uint32_t count = CalculateSegmentCount(0.25 * dd, tolerance_sq);
+
+  for (std::uint32_t i = 1; i < count; ++i) {
+    out.push_back(EvaluateConic(p, weight, double(i) / count));
+  }
+  out.push_back(p[2]);
+}
+
+#ifdef REZERO_ENABLE_STATS
+void CountSegments(StatsCollector& stats, const std::vector<std::uint8_t>& commands) {
+  std::uint64_t counts[4] = {};
+  for (std::size_t i = 0; i < commands.size(); ++i) {
+    switch (static_cast<CommandType>(commands[i])) {
+      case CommandType::kOnPath:
+        ++counts[0];
+        break;
+      case CommandType::kQuad:
+        ++counts[1];
+        i += 1;
+        break;
+      case CommandType::kCubic:
+        ++counts[2];
+        i += 2;
+        break;
+      case CommandType::kConic:
+        ++counts[3];
+        i += 2;
+        break;
+      default:
+        break;
+    }
+  }
+
+  stats.path_count.fetch_add(1, std::memory_order_relaxed);
+  stats.line_count.fetch_add(counts[0], std::memory_order_relaxed);
+  stats.quad_count.fetch_add(counts[1], std::memory_order_relaxed);
+  stats.cubic_count.fetch_add(counts[2], std::memory_order_relaxed);
+  stats.conic_count.fetch_add(counts[3], std::memory_order_relaxed);
+}
+#endif
+
+} // namespace
+
 EdgeBuilder::EdgeBuilder(EdgeStorage* edge_storage) : EdgeBuilder(edge_storage, Rect{}, 0.0) {}
 
 EdgeBuilder::EdgeBuilder(EdgeStorage* edge_storage, const Rect& clipping_box, double tolerance)
@@ -25,7 +103,7 @@ void EdgeBuilder::SetTolerance(double tolerance) {
 }
 
 void EdgeBuilder::Begin() {
-  border_X0Y0_ = border_X1Y0_ = clipping_box_.min_x;
+  border_X0Y0_ = border_X1Y0_ = clipping_box_.min_y;
   border_X0Y1_ = border_X1Y1_ = clipping_box_.min_y;
 }
 
@@ -38,6 +116,10 @@ void EdgeBuilder::End() {
 }
 
 bool EdgeBuilder::AddPath(const std::shared_ptr<Path>& path) {
+  return AddPath(path, EdgeTransform());
+}
+
+bool EdgeBuilder::AddPath(const std::shared_ptr<Path>& path, const EdgeTransform& transform) {
   if (!path) {
     return false;
   }
@@ -47,7 +129,17 @@ bool EdgeBuilder::AddPath(const std::shared_ptr<Path>& path) {
 
   REZERO_DCHECK(points.size() == commands.size());
 
-  EdgeSource edge_source(EdgeTransform(), &points.front(), (CommandType*)&commands.front(), commands.size());
+  if (commands.empty()) {
+    return true;
+  }
+
+#ifdef REZERO_ENABLE_STATS
+  if (StatsCollector* stats = GetCurrentStats()) {
+    CountSegments(*stats, commands);
+  }
+#endif
+
+  EdgeSource edge_source(transform, &points.front(), (CommandType*)&commands.front(), commands.size());
 
   Point begin_point;
   State state;
@@ -74,6 +166,11 @@ bool EdgeBuilder::AddPath(const std::shared_ptr<Path>& path) {
         break;
       }
     }
+
+    // Fills close open subpaths implicitly.
+    if (state.p0 != begin_point) {
+      LineTo(edge_source, begin_point, state);
+    }
   }
 
   return true;
@@ -113,7 +210,6 @@ DescendingBegin:
             BeginDescending();
             current_edge_.Append(x0_coord, y0_coord);
             current_edge_.Append(x1_coord, y1_coord);
-            bounding_box_.min_y = std::min(static_cast<std::int32_t>(bounding_box_.min_y), y0_coord);
 
             while (true) {
 DescendingLoop:
@@ -122,7 +218,6 @@ DescendingLoop:
 
               if (!source.MaybeNextLineTo(p1)) {
                 EndDescending();
-                bounding_box_.max_y = std::max(static_cast<std::int32_t>(bounding_box_.max_y), y0_coord);
                 p0 = p1;
                 return;
               }
@@ -152,7 +247,6 @@ AscendingBegin:
             BeginAscending();
             current_edge_.Append(x0_coord, y0_coord);
             current_edge_.Append(x1_coord, y1_coord);
-            bounding_box_.max_y = std::max(static_cast<std::int32_t>(bounding_box_.max_y), y0_coord);
 
             while (true) {
 AscendingLoop:
@@ -161,7 +255,6 @@ AscendingLoop:
 
               if (!source.MaybeNextLineTo(p1)) {
                 EndAscending();
-                bounding_box_.min_y = std::min(static_cast<std::int32_t>(bounding_box_.min_y), y0_coord);
                 p0 = p1;
                 return;
               }
@@ -323,27 +416,26 @@ RestartClipLoop:
           if (!source.MaybeNextLineTo(p1)) {
             p0_flags = clipping_box_.CalculateOutFlags(p0);
             border_y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
-            if (p0_flags != p1_flags) {
+            if (border_y0 != border_y1) {
               AccumulateRightBorder(border_y0, border_y1);
             }
             return;
           }
+        }
 
-          border_y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
-
-          if (border_y0 != border_y1) {
-            AccumulateRightBorder(border_y0, border_y1);
-          }
-
-          p0_flags = clipping_box_.CalculateOutFlags(p0);
-          p1_flags = clipping_box_.CalculateOutFlags(p1);
+        border_y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
+        if (border_y0 != border_y1) {
+          AccumulateRightBorder(border_y0, border_y1);
+        }
 
-          if (p0_flags & p1_flags) {
-            goto RestartClipLoop;
-          }
+        p0_flags = clipping_box_.CalculateOutFlags(p0);
+        p1_flags = clipping_box_.CalculateOutFlags(p1);
 
-          border_y0 = border_y1;
+        if (p0_flags & p1_flags) {
+          goto RestartClipLoop;
         }
+
+        border_y0 = border_y1;
       }
 
       diff_01 = p1 - p0;
@@ -400,11 +492,14 @@ RestartClipLoop:
       }
 
       if (p0_flags) {
-        border_y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
-        if (clipped_start.x <= clipping_box_.min_x) {
-          AccumulateLeftBorder(border_y0, border_y1);
-        } else if (clipped_start.x >= clipping_box_.max_x) {
-          AccumulateRightBorder(border_y0, border_y1);
+        // The line misses the clipping box, passing it on one side.
+        border_y1 = std::clamp(p1.y, clipping_box_.min_y, clipping_box_.max_y);
+        if (border_y0 != border_y1) {
+          if (clipped_start.x <= clipping_box_.min_x) {
+            AccumulateLeftBorder(border_y0, border_y1);
+          } else if (clipped_start.x >= clipping_box_.max_x) {
+            AccumulateRightBorder(border_y0, border_y1);
+          }
         }
 
         p0 = p1;
@@ -519,80 +614,80 @@ void EdgeBuilder::QuadTo(EdgeSource& source, State& state) {
     auto p1_flags = clipping_box_.CalculateOutFlags(p1);
     auto p2_flags = clipping_box_.CalculateOutFlags(p2);
 
+    // Skips the curves entirely on one side of the clipping box, which only
+    // leave a border behind when they are left or right of it.
     auto flags = p0_flags & p1_flags & p2_flags;
     if (flags) {
       bool end = false;
 
-      while (true) {
-        if (flags & std::uint32_t(Rect::OutSideFlags::kY0)) {
+      if (flags & std::uint32_t(Rect::OutSideFlags::kY0)) {
+        while (true) {
+          p0 = p2;
+          if (!source.MaybeNextQuadTo(p1, p2)) {
+            end = true;
+            break;
+          }
+
+          if (p1.y > clipping_box_.min_y || p2.y > clipping_box_.min_y) {
+            break;
+          }
+        }
+      } else if (flags & std::uint32_t(Rect::OutSideFlags::kY1)) {
+        while (true) {
+          p0 = p2;
+          if (!source.MaybeNextQuadTo(p1, p2)) {
+            end = true;
+            break;
+          }
+
+          if (p1.y < clipping_box_.max_y || p2.y < clipping_box_.max_y) {
+            break;
+          }
+        }
+      } else {
+        double y0 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
+
+        if (flags & std::uint32_t(Rect::OutSideFlags::kX0)) {
           while (true) {
             p0 = p2;
+
             if (!source.MaybeNextQuadTo(p1, p2)) {
               end = true;
               break;
             }
 
-            if (p1.y > clipping_box_.min_y || p2.y > clipping_box_.min_y) {
+            if (p1.x > clipping_box_.min_x || p2.x > clipping_box_.min_x) {
               break;
             }
           }
-        } else if (flags & std::uint32_t(Rect::OutSideFlags::kY1)) {
+
+          double y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
+          AccumulateLeftBorder(y0, y1);
+        } else {
           while (true) {
             p0 = p2;
+
             if (!source.MaybeNextQuadTo(p1, p2)) {
               end = true;
               break;
             }
 
-            if (p1.y < clipping_box_.max_y || p2.y < clipping_box_.max_y) {
+            if (p1.x < clipping_box_.max_x || p2.x < clipping_box_.max_x) {
               break;
             }
           }
-        } else {
-          double y0 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
 
-          if (flags & std::uint32_t(Rect::OutSideFlags::kX0)) {
-            while (true) {
-              p0 = p2;
-
-              if (!source.MaybeNextQuadTo(p1, p2)) {
-                end = true;
-                break;
-              }
-
-              if (p1.x > clipping_box_.min_x || p2.x > clipping_box_.max_x) {
-                break;
-              }
-            }
-
-            double y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
-            AccumulateLeftBorder(y0, y1);
-          } else {
-            while (true) {
-              p0 = p2;
-
-              if (!source.MaybeNextQuadTo(p1, p2)) {
-                end = true;
-                break;
-              }
-
-              if (p1.x < clipping_box_.max_x || p2.x < clipping_box_.max_x) {
-                break;
-              }
-            }
-
-            double y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
-            AccumulateRightBorder(y0, y1);
-          }
-        }
-
-        p0_flags = clipping_box_.CalculateOutFlags(p0);
-        if (end) {
-          return;
+          double y1 = std::clamp(p0.y, clipping_box_.min_y, clipping_box_.max_y);
+          AccumulateRightBorder(y0, y1);
         }
+      }
 
-        continue;
+      p0_flags = clipping_box_.CalculateOutFlags(p0);
+      if (end) {
+        return;
       }
+
+      continue;
     }
 
     spline[0] = p0;
@@ -611,18 +706,18 @@ void EdgeBuilder::QuadTo(EdgeSource& source, State& state) {
     flags = p0_flags | p1_flags | p2_flags;
     if (flags) {
       // Need clipping.
+      polyline_.clear();
       do {
-        EdgeDirection direction = (spline_ptr[0].y > spline_end[2].y) ?
+        EdgeDirection direction = (spline_ptr[0].y > spline_ptr[2].y) ?
                                       EdgeDirection::kAscending : EdgeDirection::kDescending;
         FlattenMonoCurveClipping<FlattenMonoQuad>(mono_curve, spline_ptr, direction);
       } while ((spline_ptr += 2) != spline_end);
 
-      p0 = spline_end[0];
-      p0_flags = p2_flags;
+      LineToPolyline(state);
     } else {
       // No clipping.
       do {
-        EdgeDirection direction = (spline_ptr[0].y > spline_end[2].y) ?
+        EdgeDirection direction = (spline_ptr[0].y > spline_ptr[2].y) ?
                                       EdgeDirection::kAscending : EdgeDirection::kDescending;
         FlattenMonoCurve<FlattenMonoQuad>(mono_curve, spline_ptr, direction);
       } while ((spline_ptr += 2) != spline_end);
@@ -638,28 +733,51 @@ void EdgeBuilder::QuadTo(EdgeSource& source, State& state) {
 
 void EdgeBuilder::CubicTo(EdgeSource& source, State& state) {
   Point points[4];
-  Point& p0 = state.p0;
-  Point& p1 = points[1];
-  Point& p2 = points[2];
-  Point& p3 = points[3];
-  source.NextCubicTo(p1, p2, p3);
-
-  // TODO:
+  points[0] = state.p0;
+  source.NextCubicTo(points[1], points[2], points[3]);
+
+  // Splitting at the extrema puts the turning points on the polyline, and
+  // each monotonic piece gets the segments its own curvature needs. The
+  // remaining piece is searched again, as its parameter no longer matches.
+  polyline_.clear();
+  for (std::size_t i = 0; i < kMaxCubicExtrema; ++i) {
+    double ts[kMaxCubicExtrema];
+    if (FindCubicExtrema(points, ts) == 0) {
+      break;
+    }
 
-  p0 = p3;
+    Point pieces[7];
+    SplitCubic(points, ts[0], pieces);
+    FlattenCubic(pieces, tolerance_sq_, polyline_);
+    std::copy(pieces + 3, pieces + 7, points);
+  }
+  FlattenCubic(points, tolerance_sq_, polyline_);
+  LineToPolyline(state);
 }
 
 void EdgeBuilder::ConicTo(EdgeSource& source, State& state) {
   Point points[3];
-  Point& p0 = state.p0;
-  Point& p1 = points[1];
-  Point& p2 = points[2];
+  points[0] = state.p0;
   double weight;
-  source.NextConicTo(p1, p2, weight);
-
-  // TODO:
+  source.NextConicTo(points[1], points[2], weight);
+
+  // Split at the extrema as in CubicTo.
+  polyline_.clear();
+  for (std::size_t i = 0; i < kMaxConicExtrema; ++i) {
+    double ts[kMaxConicExtrema];
+    if (FindConicExtrema(points, weight, ts) == 0) {
+      break;
+    }
 
-  p0 = p2;
+    Point pieces[5];
+    double weights[2];
+    SplitConic(points, weight, ts[0], pieces, weights);
+    FlattenConic(pieces, weights[0], tolerance_sq_, polyline_);
+    std::copy(pieces + 2, pieces + 5, points);
+    weight = weights[1];
+  }
+  FlattenConic(points, weight, tolerance_sq_, polyline_);
+  LineToPolyline(state);
 }
 
 void EdgeBuilder::BeginAscending() {
@@ -671,8 +789,11 @@ void EdgeBuilder::EndAscending() {
   if (current_edge_.IsValid()) {
     REZERO_DCHECK(current_edge_.direction == EdgeDirection::kAscending);
 
+    UpdateBoundingBox(current_edge_);
+
     auto band_id = edge_storage_->CalculateBandId(current_edge_.points.back().y);
     edge_storage_->bands[band_id].Append(current_edge_);
+    REZERO_STATS_ADD_BAND_EDGE(band_id);
   }
 
   current_edge_.Reset();
@@ -687,13 +808,25 @@ void EdgeBuilder::EndDescending() {
   if (current_edge_.IsValid()) {
     REZERO_DCHECK(current_edge_.direction == EdgeDirection::kDescending);
 
+    UpdateBoundingBox(current_edge_);
+
     auto band_id = edge_storage_->CalculateBandId(current_edge_.points.front().y);
     edge_storage_->bands[band_id].Append(current_edge_);
+    REZERO_STATS_ADD_BAND_EDGE(band_id);
   }
 
   current_edge_.Reset();
 }
 
+void EdgeBuilder::UpdateBoundingBox(const EdgeVector& edge) {
+  for (const auto& point : edge.points) {
+    bounding_box_.min_x = std::min(bounding_box_.min_x, double(point.x));
+    bounding_box_.min_y = std::min(bounding_box_.min_y, double(point.y));
+    bounding_box_.max_x = std::max(bounding_box_.max_x, double(point.x));
+    bounding_box_.max_y = std::max(bounding_box_.max_y, double(point.y));
+  }
+}
+
 void EdgeBuilder::AccumulateLeftBorder(double border_y0, double border_y1) {
   if (border_X0Y1_ == border_y0) {
     border_X0Y1_ = border_y1;
@@ -724,13 +857,26 @@ void EdgeBuilder::AddLineSegment(const Point& p0, const Point& p1) {
   std::int32_t x1_coord = static_cast<std::int32_t>(p1.x);
   std::int32_t y1_coord = static_cast<std::int32_t>(p1.y);
 
-  if (x0_coord == x1_coord) {
+  // Horizontal segments do not contribute to coverage.
+  if (y0_coord == y1_coord) {
     return;
   }
 
   AddCloseLine(x0_coord, y0_coord, x1_coord, y1_coord);
 }
 
+void EdgeBuilder::LineToPolyline(State& state) {
+  if (polyline_.empty()) {
+    return;
+  }
+
+  // The points are already transformed.
+  polyline_commands_.assign(polyline_.size(), CommandType::kOnPath);
+  EdgeSource source(EdgeTransform(), polyline_.data() + 1, polyline_commands_.data() + 1,
+                    polyline_.size() - 1);
+  LineTo(source, polyline_.front(), state);
+}
+
 void EdgeBuilder::FlushBorderAccumulators() {
   EmitLeftBorder();
   EmitRightBorder();
@@ -749,14 +895,9 @@ void EdgeBuilder::EmitLeftBorder() {
     return;
   }
 
-  auto min_y = std::min(y0, y1);
-  auto max_y = std::max(y0, y1);
-
-  bounding_box_.min_y = std::min(min_y, static_cast<std::int32_t>(bounding_box_.min_y));
-  bounding_box_.max_y = std::max(max_y, static_cast<std::int32_t>(bounding_box_.max_y));
-
   AddCloseLine(static_cast<std::int32_t>(clipping_box_.min_x), y0,
                static_cast<std::int32_t>(clipping_box_.min_x), y1);
+  REZERO_STATS_ADD(border_edge_count, 1);
 }
 
 void EdgeBuilder::EmitRightBorder() {
@@ -767,14 +908,9 @@ void EdgeBuilder::EmitRightBorder() {
     return;
   }
 
-  auto min_y = std::min(y0, y1);
-  auto max_y = std::max(y0, y1);
-
-  bounding_box_.min_y = std::min(min_y, static_cast<std::int32_t>(bounding_box_.min_y));
-  bounding_box_.max_y = std::max(max_y, static_cast<std::int32_t>(bounding_box_.max_y));
-
   AddCloseLine(static_cast<std::int32_t>(clipping_box_.max_x), y0,
                static_cast<std::int32_t>(clipping_box_.max_x), y1);
+  REZERO_STATS_ADD(border_edge_count, 1);
 }
 
 void EdgeBuilder::AddCloseLine(std::int32_t x0_coord, std::int32_t y0_coord,
@@ -782,12 +918,8 @@ void EdgeBuilder::AddCloseLine(std::int32_t x0_coord, std::int32_t y0_coord,
   EdgeDirection direction;
 
   if (y0_coord < y1_coord) {
-    bounding_box_.min_y = std::min(y0_coord, static_cast<std::int32_t>(bounding_box_.min_y));
-    bounding_box_.max_y = std::max(y1_coord, static_cast<std::int32_t>(bounding_box_.max_y));
     direction = EdgeDirection::kDescending;
   } else {
-    bounding_box_.min_y = std::min(y1_coord, static_cast<std::int32_t>(bounding_box_.min_y));
-    bounding_box_.max_y = std::max(y0_coord, static_cast<std::int32_t>(bounding_box_.max_y));
     direction = EdgeDirection::kAscending;
   }
 
@@ -795,9 +927,11 @@ void EdgeBuilder::AddCloseLine(std::int32_t x0_coord, std::int32_t y0_coord,
   edge.direction = direction;
   edge.Append(x0_coord, y0_coord);
   edge.Append(x1_coord, y1_coord);
+  UpdateBoundingBox(edge);
 
   auto band_id = edge_storage_->CalculateBandId(direction == EdgeDirection::kAscending ? y1_coord : y0_coord);
   edge_storage_->bands[band_id].Append(edge);
+  REZERO_STATS_ADD_BAND_EDGE(band_id);
 }
 
 } // namespace rezero
@@ -4,6 +4,7 @@
 #define REZERO_RASTER_EDGE_BUILDER_H_
 
 #include <memory>
+#include <vector>
 
 #include "rezero2d/base/macros.h"
 #include "rezero2d/raster/edge_source.h"
@@ -23,6 +24,7 @@ class EdgeBuilder {
   void End();
 
   bool AddPath(const std::shared_ptr<Path>& path);
+  bool AddPath(const std::shared_ptr<Path>& path, const EdgeTransform& transform);
 
  private:
   struct State {
@@ -42,6 +44,9 @@ class EdgeBuilder {
   void BeginDescending();
   void EndDescending();
 
+  // Grows `bounding_box_` by the points of an edge going into the storage.
+  void UpdateBoundingBox(const EdgeVector& edge);
+
   void AccumulateLeftBorder(double border_y0, double border_y1);
   void AccumulateRightBorder(double border_y0, double border_y1);
 
@@ -55,6 +60,9 @@ class EdgeBuilder {
 
   void AddCloseLine(std::int32_t x0_coord, std::int32_t y0_coord, std::int32_t x1_coord, std::int32_t y1_coord);
 
+  // Runs the points collected in `polyline_` through the clipping LineTo.
+  void LineToPolyline(State& state);
+
   template <typename MonoCurveType>
   void FlattenMonoCurve(MonoCurveType& mono_curve, const Point* src, EdgeDirection direction);
 
@@ -76,6 +84,10 @@ class EdgeBuilder {
   double border_X1Y0_;
   double border_X1Y1_;
 
+  // Flattened curve points that still need clipping.
+  std::vector<Point> polyline_;
+  std::vector<CommandType> polyline_commands_;
+
   REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(EdgeBuilder);
 };
 
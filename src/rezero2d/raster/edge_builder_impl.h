@@ -49,9 +49,27 @@ void EdgeBuilder::FlattenMonoCurve(MonoCurveType& mono_curve, const Point* src,
   }
 }
 
+// Flattens into `polyline_` instead of emitting edges, so the clipping is
+// left to LineToPolyline.
 template <typename MonoCurveType>
 void EdgeBuilder::FlattenMonoCurveClipping(MonoCurveType& mono_curve, const Point* src, EdgeDirection direction) {
-  // TODO:
+  mono_curve.Begin(src, direction);
+
+  while (true) {
+    typename MonoCurveType::Step step;
+    if (!mono_curve.IsFlat(step)) {
+      mono_curve.Split(step);
+      mono_curve.Push(step);
+      continue;
+    }
+
+    polyline_.push_back(mono_curve.Last());
+
+    if (!mono_curve.CanPop()) {
+      break;
+    }
+    mono_curve.Pop();
+  }
 }
 
 } // namespace rezero
@@ -20,13 +20,17 @@ enum class CommandType : std::uint8_t {
   kClose  = 6,
 };
 
-// TODO:
+// TODO: Support affine transforms.
 class EdgeTransform {
  public:
   EdgeTransform() = default;
+  explicit EdgeTransform(double scale) : scale_(scale) {}
   ~EdgeTransform() = default;
 
-  void Apply(Point& dst, const Point& src) { dst = src; }
+  void Apply(Point& dst, const Point& src) { dst = src * scale_; }
+
+ private:
+  double scale_ = 1.0;
 };
 
 class EdgeSource {
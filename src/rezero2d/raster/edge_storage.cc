@@ -2,6 +2,10 @@
 
 #include "rezero2d/raster/edge_storage.h"
 
+#include <algorithm>
+#include <limits>
+#include <new>
+
 #include "rezero2d/base/logging.h"
 
 namespace rezero {
@@ -18,27 +22,77 @@ void EdgeList::Append(const EdgeVector& edge_vector) {
   edges.push_back(edge_vector);
 }
 
-EdgeStorage::EdgeStorage(std::uint32_t band_count, std::uint32_t band_height)
+EdgeStorage::EdgeStorage(std::uint32_t band_count, std::uint32_t band_height,
+                         std::shared_ptr<Allocator> allocator)
     : band_count(band_count), band_height(band_height),
+      allocator(allocator ? std::move(allocator) : GetAllocator()),
       bounding_box_(std::numeric_limits<double>::max(),
                     std::numeric_limits<double>::max(),
-                    std::numeric_limits<double>::min(),
-                    std::numeric_limits<double>::min()) {
+                    std::numeric_limits<double>::lowest(),
+                    std::numeric_limits<double>::lowest()) {
   REZERO_DCHECK(band_count > 0);
 
   if (band_count > 0) {
-    bands = new EdgeList[band_count];
+    bands = static_cast<EdgeList*>(this->allocator->Allocate(sizeof(EdgeList) * band_count));
+    REZERO_CHECK(bands);
+    for (std::uint32_t i = 0; i < band_count; ++i) {
+      new (&bands[i]) EdgeList();
+    }
   }
 }
 
 EdgeStorage::~EdgeStorage() {
   if (bands) {
-    delete [] bands;
+    for (std::uint32_t i = 0; i < band_count; ++i) {
+      bands[i].~EdgeList();
+    }
+    allocator->Free(bands, sizeof(EdgeList) * band_count);
   }
 }
 
+void EdgeStorage::Reset() {
+  for (std::uint32_t i = 0; i < band_count; ++i) {
+    bands[i].edges.clear();
+  }
+
+  const Rect empty_box(std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::lowest(),
+                       std::numeric_limits<double>::lowest());
+  bounding_box_ = empty_box;
+}
+
 std::uint32_t EdgeStorage::CalculateBandId(std::uint32_t y_cood) {
-  return y_cood / band_height;
+  // The bottom edge of the clip box belongs to the last band.
+  return std::min(y_cood / band_height, band_count - 1);
+}
+
+void EdgeStorage::CalculateBandRange(std::uint32_t& band_begin, std::uint32_t& band_end) const {
+  band_begin = 0;
+  band_end = 0;
+
+  std::int32_t bottom = 0;
+  bool found = false;
+  for (std::uint32_t i = 0; i < band_count; ++i) {
+    const auto& edges = bands[i].edges;
+    if (edges.empty()) {
+      continue;
+    }
+
+    if (!found) {
+      band_begin = i;
+      found = true;
+    }
+
+    for (const auto& edge : edges) {
+      bottom = std::max({bottom, edge.points.front().y, edge.points.back().y});
+    }
+  }
+
+  if (found) {
+    auto end = static_cast<std::uint32_t>((bottom + band_height - 1) / band_height);
+    band_end = std::clamp(end, band_begin + 1, band_count);
+  }
 }
 
 } // namespace rezero
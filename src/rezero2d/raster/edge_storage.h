@@ -4,12 +4,19 @@
 #define REZERO_RASTER_EDGE_STORAGE_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
+#include "rezero2d/allocator.h"
 #include "rezero2d/geometry.h"
 
 namespace rezero {
 
+// Edges built for rasterization use fixed point coordinates with this many
+// fractional bits.
+static constexpr std::int32_t kEdgeFixedShift = 8;
+static constexpr double kEdgeFixedScale = double(1 << kEdgeFixedShift);
+
 struct EdgePoint {
   EdgePoint(std::int32_t x, std::int32_t y) : x(x), y(y) {}
 
@@ -40,15 +47,26 @@ struct EdgeList {
 };
 
 struct EdgeStorage {
-  EdgeStorage(std::uint32_t band_count, std::uint32_t band_height);
+  // The band array comes from `allocator`, or GetAllocator when null.
+  EdgeStorage(std::uint32_t band_count, std::uint32_t band_height,
+              std::shared_ptr<Allocator> allocator = nullptr);
   ~EdgeStorage();
 
+  // Drops all edges but keeps the band allocations for reuse.
+  void Reset();
+
   std::uint32_t CalculateBandId(std::uint32_t y_cood);
 
+  // Sets `[band_begin, band_end)` to the bands the edges reach into. Both
+  // are 0 when there are no edges.
+  void CalculateBandRange(std::uint32_t& band_begin, std::uint32_t& band_end) const;
+
   std::uint32_t band_count;
   std::uint32_t band_height;
-  EdgeList* bands;
+  EdgeList* bands = nullptr;
+  std::shared_ptr<Allocator> allocator;
 
+  // The bounds of all edges, in fixed point. Invalid when there are none.
   Rect bounding_box_;
 };
 
@@ -2,6 +2,8 @@
 
 #include "rezero2d/raster/flatten_utils.h"
 
+#include "rezero2d/base/stats.h"
+
 namespace rezero {
 
 FlattenMonoQuad::FlattenMonoQuad(double tolerance_sq) : tolerance_sq_(tolerance_sq) {}
@@ -25,28 +27,30 @@ bool FlattenMonoQuad::IsFlat(Step& step) {
   step.value = d * d;
   step.limit = tolerance_sq_ * length_sq;
 
-  return step.value <= step.limit;
+  return step.value <= step.limit || stack_size_ == kMaxDepth * 3;
 }
 
 void FlattenMonoQuad::Split(Step& step) {
+  REZERO_STATS_ADD(quad_split_count, 1);
+
   step.p01 = (p0_ + p1_) * 0.5;
   step.p12 = (p1_ + p2_) * 0.5;
   step.p012 = (step.p01 + step.p12) * 0.5;
 }
 
 void FlattenMonoQuad::Push(const Step& step) {
-  stack_.push_back(step.p012);
-  stack_.push_back(step.p12);
-  stack_.push_back(p2_);
+  stack_[stack_size_++] = step.p012;
+  stack_[stack_size_++] = step.p12;
+  stack_[stack_size_++] = p2_;
 
   p1_ = step.p01;
   p2_ = step.p012;
 }
 
 void FlattenMonoQuad::Pop() {
-  p2_ = stack_.back(); stack_.pop_back();
-  p1_ = stack_.back(); stack_.pop_back();
-  p0_ = stack_.back(); stack_.pop_back();
+  p2_ = stack_[--stack_size_];
+  p1_ = stack_[--stack_size_];
+  p0_ = stack_[--stack_size_];
 }
 
 } // namespace rezero
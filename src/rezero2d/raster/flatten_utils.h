@@ -3,7 +3,7 @@
 #ifndef REZERO_RASTER_FLATTEN_DATA_H_
 #define REZERO_RASTER_FLATTEN_DATA_H_
 
-#include <vector>
+#include <cstddef>
 
 #include "rezero2d/geometry.h"
 #include "rezero2d/raster/edge_storage.h"
@@ -32,7 +32,7 @@ class FlattenMonoQuad {
 
   void Push(const Step& step);
 
-  bool CanPop() const { return !stack_.empty(); }
+  bool CanPop() const { return stack_size_ != 0; }
 
   void Pop();
 
@@ -46,7 +46,12 @@ class FlattenMonoQuad {
   Point p1_;
   Point p2_;
 
-  std::vector<Point> stack_;
+  // Halving a curve this many times leaves it far below any tolerance, so
+  // deeper pieces are taken as flat and the stack never grows.
+  static constexpr std::size_t kMaxDepth = 32;
+
+  Point stack_[kMaxDepth * 3];
+  std::size_t stack_size_ = 0;
 };
 
 } // namespace rezero
@@ -0,0 +1,228 @@
+// Created by DONG Zhong on 2024/04/02.
+
+#include "rezero2d/raster/rasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "rezero2d/base/logging.h"
+#include "rezero2d/base/stats.h"
+#include "rezero2d/base/trace.h"
+
+namespace rezero {
+
+namespace {
+
+constexpr std::uint32_t kEmptyRowMin = std::numeric_limits<std::uint32_t>::max();
+
+} // namespace
+
+Rasterizer::Rasterizer(std::uint32_t width, std::uint32_t height, std::uint32_t band_height,
+                       std::shared_ptr<Allocator> allocator)
+    : width_(width), height_(height), band_height_(band_height), cell_stride_(std::size_t(width) + 2),
+      cells_(cell_stride_ * band_height, 0.0f, StdAllocator<float>(allocator)),
+      row_min_(band_height, kEmptyRowMin, StdAllocator<std::uint32_t>(allocator)),
+      row_max_(band_height, 0, StdAllocator<std::uint32_t>(allocator)),
+      coverage_(cell_stride_, StdAllocator<std::uint8_t>(allocator)),
+      active_edges_(StdAllocator<ActiveEdge>(allocator)) {
+  REZERO_DCHECK(band_height > 0);
+}
+
+Rasterizer::~Rasterizer() = default;
+
+void Rasterizer::Rasterize(const EdgeStorage& edge_storage, SpanSink& sink) {
+  Rasterize(edge_storage, sink, 0, edge_storage.band_count);
+}
+
+void Rasterizer::Rasterize(const EdgeStorage& edge_storage, SpanSink& sink,
+                           std::uint32_t band_begin, std::uint32_t band_end) {
+  REZERO_DCHECK(edge_storage.band_height == band_height_ << kEdgeFixedShift);
+  REZERO_STATS_TIMER(kRasterization);
+  REZERO_TRACE_SCOPE("Rasterize");
+
+  active_edges_.clear();
+
+  auto top = static_cast<std::int32_t>((band_begin * band_height_) << kEdgeFixedShift);
+  for (std::uint32_t band = 0; band < std::min(band_begin, edge_storage.band_count); ++band) {
+    for (const auto& edge : edge_storage.bands[band].edges) {
+      if (std::max(edge.points.front().y, edge.points.back().y) > top) {
+        active_edges_.push_back({&edge, 0});
+      }
+    }
+  }
+
+  std::uint32_t band_count = std::min(edge_storage.band_count, (height_ + band_height_ - 1) / band_height_);
+  band_end = std::min(band_end, band_count);
+  for (std::uint32_t band = band_begin; band < band_end; ++band) {
+    const auto& edges = edge_storage.bands[band].edges;
+    if (edges.empty() && active_edges_.empty()) {
+      continue;
+    }
+
+    band_y0_ = band * band_height_;
+    band_y1_ = std::min(height_, band_y0_ + band_height_);
+
+    for (const auto& edge : edges) {
+      active_edges_.push_back({&edge, 0});
+    }
+
+    std::size_t i = 0;
+    while (i < active_edges_.size()) {
+      if (AccumulateEdge(active_edges_[i])) {
+        ++i;
+      } else {
+        active_edges_[i] = active_edges_.back();
+        active_edges_.pop_back();
+      }
+    }
+
+    FlushBand(sink);
+  }
+}
+
+bool Rasterizer::AccumulateEdge(ActiveEdge& active) {
+  const auto& points = active.edge->points;
+  std::size_t count = points.size();
+  bool descending = active.edge->direction == EdgeDirection::kDescending;
+
+  // Visits the points from the top whatever the direction of the edge.
+  auto point_at = [&](std::size_t k) -> const EdgePoint& {
+    return descending ? points[k] : points[count - 1 - k];
+  };
+
+  auto band_top = static_cast<std::int32_t>(band_y0_ << kEdgeFixedShift);
+  auto band_bottom = static_cast<std::int32_t>(band_y1_ << kEdgeFixedShift);
+
+  std::size_t k = active.segment;
+  while (k + 1 < count && point_at(k + 1).y <= band_top) {
+    ++k;
+  }
+  active.segment = k;
+
+  for (; k + 1 < count; ++k) {
+    const EdgePoint& a = point_at(k);
+    const EdgePoint& b = point_at(k + 1);
+    if (a.y >= band_bottom) {
+      break;
+    }
+
+    // The winding sign comes from the original direction.
+    const EdgePoint& from = descending ? a : b;
+    const EdgePoint& to = descending ? b : a;
+    AccumulateLine(from.x / kEdgeFixedScale, from.y / kEdgeFixedScale,
+                   to.x / kEdgeFixedScale, to.y / kEdgeFixedScale);
+  }
+
+  return point_at(count - 1).y > band_bottom;
+}
+
+void Rasterizer::AccumulateLine(double x0, double y0, double x1, double y1) {
+  if (y0 == y1) {
+    return;
+  }
+
+  float dir = 1.0f;
+  if (y0 > y1) {
+    std::swap(x0, x1);
+    std::swap(y0, y1);
+    dir = -1.0f;
+  }
+
+  double y_start = std::max(y0, double(band_y0_));
+  double y_end = std::min(y1, double(band_y1_));
+  if (y_start >= y_end) {
+    return;
+  }
+
+  double dxdy = (x1 - x0) / (y1 - y0);
+  double x = x0 + (y_start - y0) * dxdy;
+  double max_x = double(width_);
+
+  auto row_begin = static_cast<std::uint32_t>(y_start);
+  auto row_end = static_cast<std::uint32_t>(std::ceil(y_end));
+
+  // Each row receives the signed area the segment covers to the right of it
+  // within every cell, so that a running sum over the row gives coverage.
+  for (std::uint32_t y = row_begin; y < row_end; ++y) {
+    double dy = std::min(y + 1.0, y_end) - std::max(double(y), y_start);
+    double x_next = x + dxdy * dy;
+    float d = static_cast<float>(dy) * dir;
+
+    double xa = std::clamp(std::min(x, x_next), 0.0, max_x);
+    double xb = std::clamp(std::max(x, x_next), 0.0, max_x);
+
+    std::uint32_t row = y - band_y0_;
+    float* cells = cells_.data() + row * cell_stride_;
+
+    double x0_floor = std::floor(xa);
+    auto x0i = static_cast<std::uint32_t>(x0_floor);
+    double x1_ceil = std::ceil(xb);
+    auto x1i = static_cast<std::uint32_t>(x1_ceil);
+
+    if (x1i <= x0i + 1) {
+      auto xmf = static_cast<float>(0.5 * (xa + xb) - x0_floor);
+      cells[x0i] += d - d * xmf;
+      cells[x0i + 1] += d * xmf;
+      x1i = x0i + 1;
+    } else {
+      double s = 1.0 / (xb - xa);
+      double x0f = xa - x0_floor;
+      double a0 = 0.5 * s * (1.0 - x0f) * (1.0 - x0f);
+      double x1f = xb - x1_ceil + 1.0;
+      double am = 0.5 * s * x1f * x1f;
+
+      cells[x0i] += static_cast<float>(d * a0);
+      if (x1i == x0i + 2) {
+        cells[x0i + 1] += static_cast<float>(d * (1.0 - a0 - am));
+      } else {
+        double a1 = s * (1.5 - x0f);
+        cells[x0i + 1] += static_cast<float>(d * (a1 - a0));
+        auto ds = static_cast<float>(d * s);
+        for (std::uint32_t xi = x0i + 2; xi < x1i - 1; ++xi) {
+          cells[xi] += ds;
+        }
+        double a2 = a1 + (x1i - x0i - 3) * s;
+        cells[x1i - 1] += static_cast<float>(d * (1.0 - a2 - am));
+      }
+      cells[x1i] += static_cast<float>(d * am);
+    }
+
+    row_min_[row] = std::min(row_min_[row], x0i);
+    row_max_[row] = std::max(row_max_[row], x1i);
+
+    x = x_next;
+  }
+}
+
+void Rasterizer::FlushBand(SpanSink& sink) {
+  for (std::uint32_t row = 0; row < band_y1_ - band_y0_; ++row) {
+    std::uint32_t min_x = row_min_[row];
+    std::uint32_t max_x = row_max_[row];
+    if (min_x == kEmptyRowMin) {
+      continue;
+    }
+
+    float* cells = cells_.data() + row * cell_stride_;
+
+    // Beyond `max_x` the sum is back to zero for closed outlines.
+    float accumulator = 0.0f;
+    for (std::uint32_t x = min_x; x <= max_x; ++x) {
+      accumulator += cells[x];
+      cells[x] = 0.0f;
+
+      float value = std::min(std::abs(accumulator), 1.0f);
+      coverage_[x - min_x] = static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+    }
+
+    std::uint32_t end_x = std::min(max_x + 1, width_);
+    if (end_x > min_x) {
+      sink.BlendSpan(band_y0_ + row, min_x, end_x, coverage_.data());
+    }
+
+    row_min_[row] = kEmptyRowMin;
+    row_max_[row] = 0;
+  }
+}
+
+} // namespace rezero
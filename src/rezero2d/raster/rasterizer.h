@@ -0,0 +1,83 @@
+// Created by DONG Zhong on 2024/04/02.
+
+#ifndef REZERO_RASTER_RASTERIZER_H_
+#define REZERO_RASTER_RASTERIZER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "rezero2d/base/macros.h"
+#include "rezero2d/base/std_allocator.h"
+#include "rezero2d/raster/edge_storage.h"
+
+namespace rezero {
+
+// Receives the coverage of one row from the rasterizer.
+class SpanSink {
+ public:
+  virtual ~SpanSink() = default;
+
+  // `coverage` holds `x1 - x0` values in [0, 255] for pixels `[x0, x1)` of
+  // row `y`.
+  virtual void BlendSpan(std::uint32_t y, std::uint32_t x0, std::uint32_t x1,
+                         const std::uint8_t* coverage) = 0;
+};
+
+// Converts the fixed point edges of an EdgeStorage into anti-aliased
+// coverage with the non-zero fill rule. Every band is accumulated into a
+// buffer of signed cell areas and then integrated row by row, so the cost
+// only depends on the rows and columns the edges touch.
+class Rasterizer {
+ public:
+  // The band buffers come from `allocator`, or GetAllocator when null.
+  Rasterizer(std::uint32_t width, std::uint32_t height, std::uint32_t band_height,
+             std::shared_ptr<Allocator> allocator = nullptr);
+  ~Rasterizer();
+
+  void Rasterize(const EdgeStorage& edge_storage, SpanSink& sink);
+
+  // Only produces the rows of bands `[band_begin, band_end)`. Edges starting
+  // in earlier bands are still picked up.
+  void Rasterize(const EdgeStorage& edge_storage, SpanSink& sink, std::uint32_t band_begin,
+                 std::uint32_t band_end);
+
+ private:
+  struct ActiveEdge {
+    const EdgeVector* edge;
+    // Index of the first segment, counted from the top, that may still
+    // reach into the current band.
+    std::size_t segment;
+  };
+
+  // Accumulates the segment, in pixel units, for the rows of the current band.
+  void AccumulateLine(double x0, double y0, double x1, double y1);
+
+  // Accumulates the part of `active` inside the current band. Returns false
+  // once the edge ends above the next band.
+  bool AccumulateEdge(ActiveEdge& active);
+
+  void FlushBand(SpanSink& sink);
+
+  std::uint32_t width_;
+  std::uint32_t height_;
+  std::uint32_t band_height_;
+
+  std::uint32_t band_y0_ = 0;
+  std::uint32_t band_y1_ = 0;
+
+  // `width_ + 2` cells per band row. A segment at the right border writes
+  // one cell past the last pixel.
+  std::size_t cell_stride_;
+  AllocatorVector<float> cells_;
+  AllocatorVector<std::uint32_t> row_min_;
+  AllocatorVector<std::uint32_t> row_max_;
+
+  AllocatorVector<std::uint8_t> coverage_;
+  AllocatorVector<ActiveEdge> active_edges_;
+
+  REZERO_DISALLOW_COPY_ASSIGN_AND_MOVE(Rasterizer);
+};
+
+} // namespace rezero
+
+#endif // REZERO_RASTER_RASTERIZER_H_
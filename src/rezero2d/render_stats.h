@@ -0,0 +1,48 @@
+// Created by DONG Zhong on 2024/04/24.
+
+#ifndef REZERO_RENDER_STATS_H_
+#define REZERO_RENDER_STATS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace rezero {
+
+// What a canvas session did, summed over every thread rendering it. The
+// counters are only collected when the library is built with the
+// REZERO_ENABLE_STATS CMake option. Otherwise they stay zero, and none of
+// the collecting code is compiled in.
+struct RenderStats {
+  // Paths whose edges were built, each path of a batch counting once.
+  std::uint64_t path_count = 0;
+
+  // Segments of those paths by type. Closing lines are not counted.
+  std::uint64_t line_count = 0;
+  std::uint64_t quad_count = 0;
+  std::uint64_t cubic_count = 0;
+  std::uint64_t conic_count = 0;
+
+  // Subdivisions done while flattening monotonic quads.
+  std::uint64_t quad_split_count = 0;
+
+  // Edges stored in each band of the bitmap, and among them the vertical
+  // ones clipping added along the sides of the clip box.
+  std::vector<std::uint64_t> band_edge_counts;
+  std::uint64_t border_edge_count = 0;
+
+  std::uint64_t composited_pixel_count = 0;
+
+  // Time spent in each stage. The stages nest, as rasterization composites
+  // every span it produces, but the time of a stage excludes the ones
+  // nested in it.
+  std::uint64_t edge_building_ns = 0;
+  std::uint64_t rasterization_ns = 0;
+  std::uint64_t compositing_ns = 0;
+};
+
+// Whether the library collects RenderStats.
+bool IsRenderStatsEnabled();
+
+} // namespace rezero
+
+#endif // REZERO_RENDER_STATS_H_
@@ -0,0 +1,25 @@
+// Created by DONG Zhong on 2024/04/26.
+
+#ifndef REZERO_TRACING_H_
+#define REZERO_TRACING_H_
+
+#include <string>
+
+namespace rezero {
+
+// Starts recording the begin and end of rendering stages and worker tasks on
+// every thread, dropping the events recorded before. Each thread keeps its
+// latest events in a ring buffer, so long traces lose their oldest events.
+void StartTracing();
+void StopTracing();
+bool IsTracing();
+
+// The recorded events in the Chrome trace event format, which
+// chrome://tracing and Perfetto open. It may be called while threads record,
+// in which case the events they overwrite meanwhile are left out.
+std::string ExportChromeTrace();
+bool WriteChromeTrace(const std::string& path);
+
+} // namespace rezero
+
+#endif // REZERO_TRACING_H_
@@ -0,0 +1,65 @@
+// Created by DONG Zhong on 2024/04/09.
+
+#ifndef REZERO_UTILS_PIXEL_OPERATIONS_H_
+#define REZERO_UTILS_PIXEL_OPERATIONS_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace rezero {
+
+// Scales the color channels of a straight alpha 0xAARRGGBB pixel by its
+// alpha, rounding like the compositor.
+inline std::uint32_t PremultiplyPixel(std::uint32_t pixel) {
+  std::uint32_t a = pixel >> 24;
+  if (a == 255) {
+    return pixel;
+  }
+
+  std::uint32_t rb = (pixel & 0x00FF00FF) * a + 0x00800080;
+  rb = ((rb + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+
+  std::uint32_t g = ((pixel >> 8) & 0xFF) * a + 0x80;
+  g = ((g + (g >> 8)) >> 8) & 0xFF;
+
+  return (a << 24) | rb | (g << 8);
+}
+
+// The inverse of PremultiplyPixel, up to the precision lost to small alphas.
+inline std::uint32_t UnpremultiplyPixel(std::uint32_t pixel) {
+  std::uint32_t a = pixel >> 24;
+  if (a == 255 || a == 0) {
+    return a == 255 ? pixel : 0;
+  }
+
+  auto channel = [a](std::uint32_t c) {
+    c = (c * 255 + a / 2) / a;
+    return c > 255 ? 255 : c;
+  };
+  return (a << 24) | (channel((pixel >> 16) & 0xFF) << 16) |
+         (channel((pixel >> 8) & 0xFF) << 8) | channel(pixel & 0xFF);
+}
+
+// Row versions for codecs. The rows need not be 4-byte aligned, and `dst`
+// may be `src`.
+inline void PremultiplyRow(void* dst, const void* src, std::uint32_t width) {
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, static_cast<const std::uint8_t*>(src) + x * 4, 4);
+    pixel = PremultiplyPixel(pixel);
+    std::memcpy(static_cast<std::uint8_t*>(dst) + x * 4, &pixel, 4);
+  }
+}
+
+inline void UnpremultiplyRow(void* dst, const void* src, std::uint32_t width) {
+  for (std::uint32_t x = 0; x < width; ++x) {
+    std::uint32_t pixel;
+    std::memcpy(&pixel, static_cast<const std::uint8_t*>(src) + x * 4, 4);
+    pixel = UnpremultiplyPixel(pixel);
+    std::memcpy(static_cast<std::uint8_t*>(dst) + x * 4, &pixel, 4);
+  }
+}
+
+} // namespace rezero
+
+#endif // REZERO_UTILS_PIXEL_OPERATIONS_H_
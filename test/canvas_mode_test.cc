@@ -0,0 +1,90 @@
+// Created by DONG Zhong on 2024/05/06.
+
+// Switches one Canvas between async, binned and sync sessions back to back,
+// and checks each renders what a fresh canvas does.
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include <rezero2d.h>
+
+namespace {
+
+constexpr std::uint32_t kWidth = 256;
+constexpr std::uint32_t kHeight = 256;
+
+// Enough paths that an async session is still rendering when End returns.
+void DrawScene(rezero::Canvas& canvas, std::uint32_t seed) {
+  for (std::uint32_t i = 0; i < 400; ++i) {
+    double offset = (i * 7 + seed * 13) % 200;
+    auto path = std::make_shared<rezero::Path>();
+    path->MoveTo(offset, 4.0 + i % 50);
+    path->QuadTo(offset + 120.0, 20.0, offset + 40.0, 250.0);
+    path->LineTo(offset * 0.5, 200.0);
+    path->Close();
+
+    canvas.SetFillColor(0x80000000u | ((i * 2654435761u + seed) & 0x00FFFFFF));
+    canvas.FillPath(path);
+  }
+}
+
+std::shared_ptr<rezero::Bitmap> MakeBitmap() {
+  auto bitmap = std::make_shared<rezero::Bitmap>();
+  bitmap->InitTiled(kWidth, kHeight, rezero::Format::kARGB8888);
+  return bitmap;
+}
+
+std::vector<std::uint32_t> ReadPixels(rezero::Bitmap& bitmap) {
+  std::vector<std::uint32_t> pixels(kWidth * kHeight);
+  bitmap.ReadPixels(pixels.data(), kWidth * 4);
+  return pixels;
+}
+
+std::vector<std::uint32_t> RenderReference(std::uint32_t seed) {
+  auto bitmap = MakeBitmap();
+  rezero::Canvas canvas;
+  canvas.Begin(bitmap, rezero::RenderMode::kSync);
+  DrawScene(canvas, seed);
+  canvas.End()->Wait();
+  return ReadPixels(*bitmap);
+}
+
+} // namespace
+
+int main() {
+  const rezero::RenderMode kModes[] = {rezero::RenderMode::kAsync, rezero::RenderMode::kBinned,
+                                       rezero::RenderMode::kSync};
+  const char* kModeNames[] = {"async", "binned", "sync"};
+
+  rezero::Canvas canvas;
+  canvas.SetThreadCount(2);
+
+  int failures = 0;
+  for (std::uint32_t round = 0; round < 4; ++round) {
+    std::shared_ptr<rezero::Bitmap> bitmaps[3];
+    std::shared_ptr<rezero::Fence> fences[3];
+    for (std::uint32_t i = 0; i < 3; ++i) {
+      bitmaps[i] = MakeBitmap();
+      if (!canvas.Begin(bitmaps[i], kModes[i])) {
+        std::fprintf(stderr, "Begin failed in %s mode.\n", kModeNames[i]);
+        return 1;
+      }
+      DrawScene(canvas, round * 3 + i);
+      // Not waited on, so the next session begins while this one renders.
+      fences[i] = canvas.End();
+    }
+
+    for (std::uint32_t i = 0; i < 3; ++i) {
+      fences[i]->Wait();
+      if (ReadPixels(*bitmaps[i]) != RenderReference(round * 3 + i)) {
+        std::fprintf(stderr, "Round %u: the %s session differs from the reference.\n", round,
+                     kModeNames[i]);
+        ++failures;
+      }
+    }
+  }
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,607 @@
+// Created by DONG Zhong on 2024/05/06.
+
+// Encodes drawn bitmaps with each codec and decodes them back. BMP and QOI
+// go through their own decoders. PNG has no decoder, so its chunks and zlib
+// stream are checked here and the rows inflated with a separate inflater.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <rezero2d.h>
+
+#include "rezero2d/utils/pixel_operations.h"
+
+namespace {
+
+int failures = 0;
+
+void Fail(const char* test, const char* what) {
+  std::fprintf(stderr, "%s: %s.\n", test, what);
+  ++failures;
+}
+
+std::uint32_t random_state = 12345;
+
+std::uint32_t Random(std::uint32_t range) {
+  random_state = random_state * 1664525u + 1013904223u;
+  return (random_state >> 8) % range;
+}
+
+// Runs of colors a few rows tall, with some noise between them so every
+// encoder sees both runs and literals. `alpha_step` 17 keeps kA8 images to
+// the 16 levels RLE4 needs.
+std::shared_ptr<rezero::Bitmap> MakeImage(rezero::Format format, std::uint32_t width,
+                                          std::uint32_t height, std::uint32_t alpha_step = 1) {
+  auto bitmap = std::make_shared<rezero::Bitmap>();
+  bitmap->InitTiled(width, height, format);
+
+  rezero::Canvas canvas;
+  canvas.Begin(bitmap);
+  std::uint32_t color = 0xFF000000;
+  for (std::uint32_t y = 0; y < height;) {
+    std::uint32_t rows = 1 + Random(4);
+    for (std::uint32_t x = 0; x < width;) {
+      std::uint32_t run = Random(4) == 0 ? 1 : 1 + Random(60);
+      std::uint32_t alpha = Random(256 / alpha_step) * alpha_step;
+      if (Random(3) == 0) {
+        // Small steps from the previous color.
+        color = (color & 0x00FFFFFF) + (Random(4) << 16) + (Random(4) << 8) + Random(4);
+      } else {
+        color = Random(1u << 24);
+      }
+      color = (alpha << 24) | (color & 0x00FFFFFF);
+
+      canvas.SetFillColor(color);
+      canvas.FillRect(rezero::Rect(x, y, std::min(x + run, width), std::min(y + rows, height)));
+      x += run;
+    }
+    y += rows;
+  }
+  canvas.End()->Wait();
+  return bitmap;
+}
+
+std::vector<std::uint8_t> ReadPixels(const rezero::Bitmap& bitmap) {
+  std::uint32_t row_size = bitmap.GetWidth() * (bitmap.GetFormat() == rezero::Format::kA8 ? 1 : 4);
+  std::vector<std::uint8_t> pixels(std::size_t(row_size) * bitmap.GetHeight());
+  bitmap.ReadPixels(pixels.data(), row_size);
+  return pixels;
+}
+
+// The codecs store straight alpha, which loses some precision of small
+// alphas, so ARGB pixels come back as premultiplying them again gives.
+std::vector<std::uint8_t> RoundTripARGB(std::vector<std::uint8_t> pixels) {
+  rezero::UnpremultiplyRow(pixels.data(), pixels.data(), pixels.size() / 4);
+  rezero::PremultiplyRow(pixels.data(), pixels.data(), pixels.size() / 4);
+  return pixels;
+}
+
+std::uint32_t LoadLE32(const std::uint8_t* p) {
+  return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) | (std::uint32_t(p[2]) << 16) |
+         (std::uint32_t(p[3]) << 24);
+}
+
+std::uint32_t LoadBE32(const std::uint8_t* p) {
+  return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+         (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+void CheckBMP(const char* test, rezero::Bitmap& bitmap, bool compress,
+              std::uint32_t expected_compression, std::uint16_t expected_bits) {
+  rezero::EncodeOptions options;
+  options.compress = compress;
+  options.thread_count = 3;
+  std::shared_ptr<rezero::Data> data = bitmap.EncodeAsFileData(rezero::CodecType::kBMP, options);
+  if (!data || data->GetSize() < 54) {
+    Fail(test, "encoding failed");
+    return;
+  }
+
+  const auto* file = static_cast<const std::uint8_t*>(data->GetData());
+  if (file[28] != expected_bits || file[29] != 0 || LoadLE32(file + 30) != expected_compression) {
+    Fail(test, "unexpected bit depth or compression");
+  }
+
+  options.thread_count = 1;
+  std::shared_ptr<rezero::Data> serial = bitmap.EncodeAsFileData(rezero::CodecType::kBMP, options);
+  if (!serial || serial->GetSize() != data->GetSize() ||
+      std::memcmp(serial->GetData(), data->GetData(), data->GetSize()) != 0) {
+    Fail(test, "encoding depends on the thread count");
+  }
+
+  std::vector<std::uint8_t> pixels = ReadPixels(bitmap);
+  auto decoded = rezero::Bitmap::Decode(rezero::CodecType::kDefault, data);
+  if (!decoded || decoded->GetWidth() != bitmap.GetWidth() ||
+      decoded->GetHeight() != bitmap.GetHeight() ||
+      decoded->GetFormat() != rezero::Format::kARGB8888) {
+    Fail(test, "decoding failed");
+    return;
+  }
+
+  if (bitmap.GetFormat() == rezero::Format::kARGB8888) {
+    if (ReadPixels(*decoded) != RoundTripARGB(pixels)) {
+      Fail(test, "decoded pixels differ");
+    }
+    return;
+  }
+
+  // kA8 is stored as gray levels, which decode to opaque gray by default.
+  std::vector<std::uint8_t> gray(pixels.size() * 4);
+  for (std::size_t i = 0; i < pixels.size(); ++i) {
+    gray[i * 4 + 0] = gray[i * 4 + 1] = gray[i * 4 + 2] = pixels[i];
+    gray[i * 4 + 3] = 0xFF;
+  }
+  if (ReadPixels(*decoded) != gray) {
+    Fail(test, "decoded gray pixels differ");
+  }
+
+  std::shared_ptr<rezero::Codec> codec = rezero::Codec::GetCodec(rezero::CodecType::kBMP);
+  rezero::ImageInfo info;
+  std::vector<std::uint8_t> alpha(pixels.size());
+  if (!codec->DecodeInfo(*data, info)) {
+    Fail(test, "reading the header failed");
+    return;
+  }
+  info.format = rezero::Format::kA8;
+  if (!codec->DecodePixels(*data, info, alpha.data(), bitmap.GetWidth()) || alpha != pixels) {
+    Fail(test, "decoded kA8 pixels differ");
+  }
+}
+
+void CheckQOI(const char* test, rezero::Bitmap& bitmap) {
+  std::shared_ptr<rezero::Data> data = bitmap.EncodeAsFileData(rezero::CodecType::kQOI);
+  if (!data) {
+    Fail(test, "encoding failed");
+    return;
+  }
+
+  auto decoded = rezero::Bitmap::Decode(rezero::CodecType::kDefault, data);
+  if (!decoded || decoded->GetWidth() != bitmap.GetWidth() ||
+      decoded->GetHeight() != bitmap.GetHeight()) {
+    Fail(test, "decoding failed");
+  } else if (ReadPixels(*decoded) != RoundTripARGB(ReadPixels(bitmap))) {
+    Fail(test, "decoded pixels differ");
+  }
+}
+
+std::uint32_t Crc32(const std::uint8_t* data, std::size_t size) {
+  std::uint32_t crc = 0xFFFFFFFF;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+std::uint32_t Adler32(const std::uint8_t* data, std::size_t size) {
+  std::uint32_t a = 1;
+  std::uint32_t b = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    a = (a + data[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+// A plain RFC 1951 inflater, written from the spec rather than from the
+// encoder so the two do not share mistakes.
+class Inflater {
+ public:
+  Inflater(const std::uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+  // Inflates every block up to the final one. Returns false on malformed
+  // input.
+  bool Inflate(std::vector<std::uint8_t>& out) {
+    out_ = &out;
+    bool last = false;
+    while (!last && !error_) {
+      last = Bits(1);
+      switch (Bits(2)) {
+        case 0:
+          Stored();
+          break;
+        case 1:
+          Fixed();
+          break;
+        case 2:
+          Dynamic();
+          break;
+        default:
+          error_ = true;
+      }
+    }
+    return !error_;
+  }
+
+  // Bytes consumed, counting the partial last byte.
+  std::size_t GetPosition() const { return position_; }
+
+ private:
+  struct Huffman {
+    std::uint16_t counts[16];
+    std::uint16_t symbols[288];
+  };
+
+  std::uint32_t Bits(int count) {
+    while (bit_count_ < count) {
+      if (position_ == size_) {
+        error_ = true;
+        return 0;
+      }
+      bit_buffer_ |= std::uint32_t(data_[position_++]) << bit_count_;
+      bit_count_ += 8;
+    }
+    std::uint32_t value = bit_buffer_ & ((1u << count) - 1);
+    bit_buffer_ >>= count;
+    bit_count_ -= count;
+    return value;
+  }
+
+  static void Build(Huffman& huffman, const std::uint8_t* lengths, int count) {
+    std::memset(huffman.counts, 0, sizeof(huffman.counts));
+    for (int i = 0; i < count; ++i) {
+      ++huffman.counts[lengths[i]];
+    }
+    huffman.counts[0] = 0;
+
+    std::uint16_t offsets[16] = {};
+    for (int length = 1; length < 15; ++length) {
+      offsets[length + 1] = offsets[length] + huffman.counts[length];
+    }
+    for (int i = 0; i < count; ++i) {
+      if (lengths[i]) {
+        huffman.symbols[offsets[lengths[i]]++] = static_cast<std::uint16_t>(i);
+      }
+    }
+  }
+
+  // Canonical codes are read a bit at a time, first bit first.
+  int Decode(const Huffman& huffman) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for (int length = 1; length < 16; ++length) {
+      code |= Bits(1);
+      int count = huffman.counts[length];
+      if (code - count < first) {
+        return huffman.symbols[index + code - first];
+      }
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    }
+    error_ = true;
+    return 0;
+  }
+
+  void Stored() {
+    bit_buffer_ = 0;
+    bit_count_ = 0;
+    if (size_ - position_ < 4) {
+      error_ = true;
+      return;
+    }
+    std::uint32_t length = data_[position_] | (data_[position_ + 1] << 8);
+    std::uint32_t inverse = data_[position_ + 2] | (data_[position_ + 3] << 8);
+    position_ += 4;
+    if (length != (~inverse & 0xFFFF) || size_ - position_ < length) {
+      error_ = true;
+      return;
+    }
+    out_->insert(out_->end(), data_ + position_, data_ + position_ + length);
+    position_ += length;
+  }
+
+  void Fixed() {
+    std::uint8_t lengths[288 + 30];
+    std::memset(lengths, 8, 144);
+    std::memset(lengths + 144, 9, 112);
+    std::memset(lengths + 256, 7, 24);
+    std::memset(lengths + 280, 8, 8);
+    std::memset(lengths + 288, 5, 30);
+
+    Huffman literals;
+    Huffman distances;
+    Build(literals, lengths, 288);
+    Build(distances, lengths + 288, 30);
+    Codes(literals, distances);
+  }
+
+  void Dynamic() {
+    static constexpr std::uint8_t kOrder[19] = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                11, 4,  12, 3, 13, 2, 14, 1, 15};
+    int literal_count = Bits(5) + 257;
+    int distance_count = Bits(5) + 1;
+    int code_count = Bits(4) + 4;
+    if (literal_count > 286 || distance_count > 30) {
+      error_ = true;
+      return;
+    }
+
+    std::uint8_t lengths[288 + 32] = {};
+    for (int i = 0; i < code_count; ++i) {
+      lengths[kOrder[i]] = static_cast<std::uint8_t>(Bits(3));
+    }
+    Huffman code_lengths;
+    Build(code_lengths, lengths, 19);
+
+    int total = literal_count + distance_count;
+    for (int i = 0; i < total && !error_;) {
+      int symbol = Decode(code_lengths);
+      if (symbol < 16) {
+        lengths[i++] = static_cast<std::uint8_t>(symbol);
+        continue;
+      }
+
+      std::uint8_t length = 0;
+      int repeat;
+      if (symbol == 16) {
+        if (i == 0) {
+          error_ = true;
+          return;
+        }
+        length = lengths[i - 1];
+        repeat = 3 + Bits(2);
+      } else if (symbol == 17) {
+        repeat = 3 + Bits(3);
+      } else {
+        repeat = 11 + Bits(7);
+      }
+      if (i + repeat > total) {
+        error_ = true;
+        return;
+      }
+      std::memset(lengths + i, length, repeat);
+      i += repeat;
+    }
+
+    Huffman literals;
+    Huffman distances;
+    Build(literals, lengths, literal_count);
+    Build(distances, lengths + literal_count, distance_count);
+    Codes(literals, distances);
+  }
+
+  void Codes(const Huffman& literals, const Huffman& distances) {
+    static constexpr std::uint16_t kLengthBase[29] = {
+        3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr std::uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                                      1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                                      4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr std::uint16_t kDistanceBase[30] = {
+        1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static constexpr std::uint8_t kDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2,  2,  3,  3,
+                                                        4, 4, 5, 5, 6, 6, 7,  7,  8,  8,
+                                                        9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    std::vector<std::uint8_t>& out = *out_;
+    while (!error_) {
+      int symbol = Decode(literals);
+      if (symbol < 256) {
+        out.push_back(static_cast<std::uint8_t>(symbol));
+        continue;
+      }
+      if (symbol == 256) {
+        return;
+      }
+
+      symbol -= 257;
+      if (symbol >= 29) {
+        error_ = true;
+        return;
+      }
+      std::size_t length = kLengthBase[symbol] + Bits(kLengthExtra[symbol]);
+      int distance_symbol = Decode(distances);
+      if (distance_symbol >= 30) {
+        error_ = true;
+        return;
+      }
+      std::size_t distance = kDistanceBase[distance_symbol] + Bits(kDistanceExtra[distance_symbol]);
+      if (distance > out.size()) {
+        error_ = true;
+        return;
+      }
+      for (std::size_t i = 0; i < length; ++i) {
+        out.push_back(out[out.size() - distance]);
+      }
+    }
+  }
+
+  const std::uint8_t* data_;
+  std::size_t size_;
+  std::size_t position_ = 0;
+  std::uint32_t bit_buffer_ = 0;
+  int bit_count_ = 0;
+  bool error_ = false;
+  std::vector<std::uint8_t>* out_ = nullptr;
+};
+
+std::uint8_t Paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return static_cast<std::uint8_t>(a);
+  }
+  return static_cast<std::uint8_t>(pb <= pc ? b : c);
+}
+
+// Reverses the filters in place, leaving the rows packed at the front.
+bool Unfilter(std::vector<std::uint8_t>& filtered, std::uint32_t height, std::size_t row_size,
+              std::size_t bpp) {
+  std::vector<std::uint8_t> rows(row_size * height);
+  for (std::uint32_t y = 0; y < height; ++y) {
+    std::uint8_t filter = filtered[y * (row_size + 1)];
+    const std::uint8_t* src = filtered.data() + y * (row_size + 1) + 1;
+    std::uint8_t* row = rows.data() + y * row_size;
+    const std::uint8_t* prior = y > 0 ? row - row_size : nullptr;
+    for (std::size_t i = 0; i < row_size; ++i) {
+      int a = i >= bpp ? row[i - bpp] : 0;
+      int b = prior ? prior[i] : 0;
+      int c = prior && i >= bpp ? prior[i - bpp] : 0;
+      int predictor;
+      switch (filter) {
+        case 0:
+          predictor = 0;
+          break;
+        case 1:
+          predictor = a;
+          break;
+        case 2:
+          predictor = b;
+          break;
+        case 3:
+          predictor = (a + b) / 2;
+          break;
+        case 4:
+          predictor = Paeth(a, b, c);
+          break;
+        default:
+          return false;
+      }
+      row[i] = static_cast<std::uint8_t>(src[i] + predictor);
+    }
+  }
+  filtered = std::move(rows);
+  return true;
+}
+
+void CheckPNG(const char* test, rezero::Bitmap& bitmap, bool compress) {
+  rezero::EncodeOptions options;
+  options.compress = compress;
+  options.thread_count = 3;
+  std::shared_ptr<rezero::Data> data = bitmap.EncodeAsFileData(rezero::CodecType::kPNG, options);
+  if (!data) {
+    Fail(test, "encoding failed");
+    return;
+  }
+
+  options.thread_count = 1;
+  std::shared_ptr<rezero::Data> serial = bitmap.EncodeAsFileData(rezero::CodecType::kPNG, options);
+  if (!serial || serial->GetSize() != data->GetSize() ||
+      std::memcmp(serial->GetData(), data->GetData(), data->GetSize()) != 0) {
+    Fail(test, "encoding depends on the thread count");
+  }
+
+  static constexpr std::uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  const auto* file = static_cast<const std::uint8_t*>(data->GetData());
+  std::size_t size = data->GetSize();
+  if (size < 8 || std::memcmp(file, kSignature, 8) != 0) {
+    Fail(test, "bad signature");
+    return;
+  }
+
+  bool a8 = bitmap.GetFormat() == rezero::Format::kA8;
+  std::vector<std::uint8_t> zlib;
+  std::size_t idat_count = 0;
+  bool ended = false;
+  for (std::size_t offset = 8; offset < size;) {
+    if (size - offset < 12 || LoadBE32(file + offset) > size - offset - 12) {
+      Fail(test, "truncated chunk");
+      return;
+    }
+    std::uint32_t length = LoadBE32(file + offset);
+    const std::uint8_t* type = file + offset + 4;
+    const std::uint8_t* payload = type + 4;
+    if (Crc32(type, length + 4) != LoadBE32(payload + length)) {
+      Fail(test, "bad chunk CRC");
+    }
+
+    if (offset == 8) {
+      if (std::memcmp(type, "IHDR", 4) != 0 || length != 13 ||
+          LoadBE32(payload) != bitmap.GetWidth() || LoadBE32(payload + 4) != bitmap.GetHeight() ||
+          payload[8] != 8 || payload[9] != (a8 ? 0 : 6) || payload[10] || payload[11] ||
+          payload[12]) {
+        Fail(test, "bad IHDR");
+        return;
+      }
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      zlib.insert(zlib.end(), payload, payload + length);
+      ++idat_count;
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      ended = length == 0 && offset + 12 == size;
+    }
+    offset += 12 + length;
+  }
+  if (!ended) {
+    Fail(test, "IEND missing or not last");
+  }
+
+  if (zlib.size() < 6 || zlib[0] != 0x78 || zlib[1] != (compress ? 0x5E : 0x01) ||
+      (zlib[0] * 256 + zlib[1]) % 31 != 0) {
+    Fail(test, "bad zlib header");
+    return;
+  }
+
+  std::vector<std::uint8_t> inflated;
+  Inflater inflater(zlib.data() + 2, zlib.size() - 2);
+  if (!inflater.Inflate(inflated) || zlib.size() - 2 - inflater.GetPosition() != 4) {
+    Fail(test, "inflating failed");
+    return;
+  }
+  if (Adler32(inflated.data(), inflated.size()) != LoadBE32(zlib.data() + zlib.size() - 4)) {
+    Fail(test, "bad Adler-32");
+  }
+
+  std::size_t bpp = a8 ? 1 : 4;
+  std::size_t row_size = bitmap.GetWidth() * bpp;
+  if (inflated.size() != (row_size + 1) * bitmap.GetHeight() ||
+      !Unfilter(inflated, bitmap.GetHeight(), row_size, bpp)) {
+    Fail(test, "bad filtered rows");
+    return;
+  }
+
+  // PNG stores RGBA with straight alpha.
+  std::vector<std::uint8_t> pixels = ReadPixels(bitmap);
+  if (!a8) {
+    rezero::UnpremultiplyRow(pixels.data(), pixels.data(), pixels.size() / 4);
+    for (std::size_t i = 0; i < pixels.size(); i += 4) {
+      std::swap(pixels[i], pixels[i + 2]);
+    }
+  }
+  if (inflated != pixels) {
+    Fail(test, "inflated rows differ");
+  }
+
+  // Tall images are encoded as several strips, each its own IDAT.
+  if (bitmap.GetHeight() > 1000 && idat_count < 3) {
+    Fail(test, "expected several strips");
+  }
+}
+
+} // namespace
+
+int main() {
+  const struct {
+    std::uint32_t width;
+    std::uint32_t height;
+  } kSizes[] = {{1, 1}, {37, 23}, {601, 1900}};
+
+  for (const auto& size : kSizes) {
+    auto argb = MakeImage(rezero::Format::kARGB8888, size.width, size.height);
+    auto a8 = MakeImage(rezero::Format::kA8, size.width, size.height);
+    auto a8_levels = MakeImage(rezero::Format::kA8, size.width, size.height, 17);
+
+    std::fprintf(stderr, "Checking %ux%u images.\n", size.width, size.height);
+    CheckBMP("BMP bit fields", *argb, false, 3, 32);
+    CheckBMP("BMP BI_RGB", *a8, false, 0, 8);
+    CheckBMP("BMP RLE8", *a8, true, 1, 8);
+    CheckBMP("BMP RLE4", *a8_levels, true, 2, 4);
+    CheckQOI("QOI", *argb);
+    CheckPNG("PNG", *argb, false);
+    CheckPNG("PNG compressed", *argb, true);
+    CheckPNG("PNG kA8", *a8, false);
+    CheckPNG("PNG kA8 compressed", *a8, true);
+  }
+
+  return failures ? 1 : 0;
+}
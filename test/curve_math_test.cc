@@ -0,0 +1,246 @@
+// Created by DONG Zhong on 2024/05/06.
+
+// Checks the extrema finders and the curve splitters against evaluating the
+// curves directly, on a few known curves and many random ones.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "rezero2d/raster/curve_math.h"
+
+namespace {
+
+using rezero::Point;
+
+constexpr int kRandomCurves = 2000;
+constexpr int kSamples = 32;
+
+int failures = 0;
+
+void Fail(const char* what, int curve) {
+  if (failures < 20) {
+    std::fprintf(stderr, "Curve %d: %s.\n", curve, what);
+  }
+  ++failures;
+}
+
+double Distance(const Point& a, const Point& b) {
+  return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+std::uint32_t random_state = 12345;
+
+double Random(double low, double high) {
+  random_state = random_state * 1664525u + 1013904223u;
+  return low + (high - low) * (random_state >> 8) / double(1u << 24);
+}
+
+// Extent of the control points, which tolerances are relative to.
+template <std::size_t N>
+double Extent(const Point (&p)[N]) {
+  double extent = 1.0;
+  for (std::size_t i = 1; i < N; ++i) {
+    extent = std::max(extent, Distance(p[0], p[i]));
+  }
+  return extent;
+}
+
+// `evaluate(t)` of a curve whose extrema are `ts`. The velocity along x or y
+// has to vanish at each of them, and both coordinates have to be monotonic
+// between them.
+template <typename Evaluate>
+void CheckExtrema(Evaluate evaluate, const double* ts, std::size_t count, double extent,
+                  int curve) {
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!(ts[i] > 0.0 && ts[i] < 1.0) || (i > 0 && !(ts[i - 1] < ts[i]))) {
+      Fail("extrema not sorted in (0, 1)", curve);
+      return;
+    }
+
+    constexpr double kStep = 1e-6;
+    Point velocity = (evaluate(ts[i] + kStep) - evaluate(ts[i] - kStep)) / (2.0 * kStep);
+    if (std::min(std::abs(velocity.x), std::abs(velocity.y)) > 1e-4 * extent) {
+      Fail("nonzero velocity at an extremum", curve);
+    }
+  }
+
+  for (std::size_t i = 0; i <= count; ++i) {
+    double t0 = i == 0 ? 0.0 : ts[i - 1];
+    double t1 = i == count ? 1.0 : ts[i];
+    Point first = evaluate(t0);
+    Point last = evaluate(t1);
+    Point previous = first;
+    for (int j = 1; j <= kSamples; ++j) {
+      Point point = evaluate(t0 + (t1 - t0) * j / kSamples);
+      double slack = 1e-9 * extent;
+      if ((point.x - previous.x) * (last.x - first.x) < -slack * std::abs(last.x - first.x) ||
+          (point.y - previous.y) * (last.y - first.y) < -slack * std::abs(last.y - first.y) ||
+          (last.x == first.x && std::abs(point.x - first.x) > slack) ||
+          (last.y == first.y && std::abs(point.y - first.y) > slack)) {
+        Fail("not monotonic between extrema", curve);
+        return;
+      }
+      previous = point;
+    }
+  }
+}
+
+void CheckQuad(const Point (&p)[3], int curve) {
+  double ts[rezero::kMaxQuadExtrema];
+  std::size_t count = rezero::FindQuadExtrema(p, ts);
+  double extent = Extent(p);
+  CheckExtrema([&](double t) { return rezero::EvaluateQuad(p, t); }, ts, count, extent, curve);
+
+  double t = Random(0.01, 0.99);
+  Point out[5];
+  rezero::SplitQuad(p, t, out);
+  for (int j = 0; j <= kSamples; ++j) {
+    double u = double(j) / kSamples;
+    if (Distance(rezero::EvaluateQuad(out, u), rezero::EvaluateQuad(p, u * t)) > 1e-9 * extent ||
+        Distance(rezero::EvaluateQuad(out + 2, u), rezero::EvaluateQuad(p, t + u * (1.0 - t))) >
+            1e-9 * extent) {
+      Fail("quad halves differ from the quad", curve);
+      return;
+    }
+  }
+}
+
+void CheckCubic(const Point (&p)[4], int curve) {
+  double ts[rezero::kMaxCubicExtrema];
+  std::size_t count = rezero::FindCubicExtrema(p, ts);
+  double extent = Extent(p);
+  CheckExtrema([&](double t) { return rezero::EvaluateCubic(p, t); }, ts, count, extent, curve);
+
+  double t = Random(0.01, 0.99);
+  Point out[7];
+  rezero::SplitCubic(p, t, out);
+  for (int j = 0; j <= kSamples; ++j) {
+    double u = double(j) / kSamples;
+    if (Distance(rezero::EvaluateCubic(out, u), rezero::EvaluateCubic(p, u * t)) >
+            1e-9 * extent ||
+        Distance(rezero::EvaluateCubic(out + 3, u),
+                 rezero::EvaluateCubic(p, t + u * (1.0 - t))) > 1e-9 * extent) {
+      Fail("cubic halves differ from the cubic", curve);
+      return;
+    }
+  }
+}
+
+// Distance from `point` to a fine polyline through the conic.
+double DistanceToConic(const Point (&p)[3], double weight, const Point& point) {
+  constexpr int kSegments = 4096;
+  double distance = Distance(point, p[0]);
+  Point a = p[0];
+  for (int i = 1; i <= kSegments; ++i) {
+    Point b = rezero::EvaluateConic(p, weight, double(i) / kSegments);
+    Point ab = b - a;
+    double length_sq = ab.x * ab.x + ab.y * ab.y;
+    double s = 0.0;
+    if (length_sq > 0.0) {
+      s = std::clamp(((point.x - a.x) * ab.x + (point.y - a.y) * ab.y) / length_sq, 0.0, 1.0);
+    }
+    distance = std::min(distance, Distance(point, a + ab * s));
+    a = b;
+  }
+  return distance;
+}
+
+void CheckConic(const Point (&p)[3], double weight, int curve, bool split) {
+  double ts[rezero::kMaxConicExtrema];
+  std::size_t count = rezero::FindConicExtrema(p, weight, ts);
+  double extent = Extent(p);
+  CheckExtrema([&](double t) { return rezero::EvaluateConic(p, weight, t); }, ts, count, extent,
+               curve);
+  if (!split) {
+    return;
+  }
+
+  // The halves keep end weights of 1, which reparameterizes them, so their
+  // points are only checked to lie on the conic.
+  double t = Random(0.01, 0.99);
+  Point out[5];
+  double weights[2];
+  rezero::SplitConic(p, weight, t, out, weights);
+  if (Distance(out[2], rezero::EvaluateConic(p, weight, t)) > 1e-9 * extent) {
+    Fail("conic split away from the conic", curve);
+    return;
+  }
+  if (!(weights[0] > 0.0 && weights[1] > 0.0)) {
+    Fail("conic halves with nonpositive weights", curve);
+    return;
+  }
+  for (int j = 1; j < 8; ++j) {
+    double u = j / 8.0;
+    if (DistanceToConic(p, weight, rezero::EvaluateConic(out, weights[0], u)) > 1e-5 * extent ||
+        DistanceToConic(p, weight, rezero::EvaluateConic(out + 2, weights[1], u)) >
+            1e-5 * extent) {
+      Fail("conic halves off the conic", curve);
+      return;
+    }
+  }
+}
+
+void CheckKnownCounts() {
+  struct {
+    const char* name;
+    std::size_t count;
+    std::size_t expected;
+    double first;
+  } cases[6];
+
+  double ts[rezero::kMaxCubicExtrema];
+  const Point arch[3] = {Point(0, 0), Point(50, 100), Point(100, 0)};
+  cases[0] = {"arch quad", rezero::FindQuadExtrema(arch, ts), 1, ts[0]};
+  const Point line[4] = {Point(0, 0), Point(1, 1), Point(2, 2), Point(3, 3)};
+  cases[1] = {"straight cubic", rezero::FindCubicExtrema(line, ts), 0, 0.0};
+  const Point bulge[4] = {Point(0, 0), Point(100, 0), Point(100, 100), Point(0, 100)};
+  cases[2] = {"bulging cubic", rezero::FindCubicExtrema(bulge, ts), 1, ts[0]};
+  const Point wave[4] = {Point(0, 0), Point(120, 100), Point(-20, -40), Point(100, 60)};
+  cases[3] = {"waving cubic", rezero::FindCubicExtrema(wave, ts), 4, -1.0};
+  const Point quarter[3] = {Point(100, 0), Point(100, 100), Point(0, 100)};
+  cases[4] = {"quarter circle", rezero::FindConicExtrema(quarter, std::sqrt(0.5), ts), 0, 0.0};
+  cases[5] = {"arch conic", rezero::FindConicExtrema(arch, 3.0, ts), 1, ts[0]};
+
+  for (const auto& known : cases) {
+    if (known.count != known.expected) {
+      std::fprintf(stderr, "The %s has %zu extrema, expected %zu.\n", known.name, known.count,
+                   known.expected);
+      ++failures;
+    } else if (known.count == 1 && std::abs(known.first - 0.5) > 1e-12) {
+      std::fprintf(stderr, "The %s turns at %g, expected 0.5.\n", known.name, known.first);
+      ++failures;
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  CheckKnownCounts();
+
+  for (int curve = 0; curve < kRandomCurves; ++curve) {
+    Point p[4];
+    for (Point& point : p) {
+      point = Point(Random(-200.0, 200.0), Random(-200.0, 200.0));
+    }
+    // Some curves with control points in line, which zero the leading
+    // coefficients along an axis.
+    if (curve % 8 == 0) {
+      for (Point& point : p) {
+        point.y = p[0].y;
+      }
+    }
+
+    const Point quad[3] = {p[0], p[1], p[2]};
+    const Point cubic[4] = {p[0], p[1], p[2], p[3]};
+    CheckQuad(quad, curve);
+    CheckCubic(cubic, curve);
+    CheckConic(quad, Random(0.1, 5.0), curve, curve % 10 == 0);
+    CheckConic(quad, 1.0, curve, false);
+  }
+
+  return failures ? 1 : 0;
+}